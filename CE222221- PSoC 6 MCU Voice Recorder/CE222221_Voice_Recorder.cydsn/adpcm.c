@@ -0,0 +1,307 @@
+/******************************************************************************
+* File Name: adpcm.c
+*
+* Version: 1.0
+*
+* Description: This file contains the IMA-ADPCM encoder and decoder used
+*              to store recordings at 4 bits per sample
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include "adpcm.h"
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define ADPCM_INDEX_MAX     (88)            /* Last entry of the step table */
+
+/* Quantizer step sizes */
+static const int16_t adpcmSteps[ADPCM_INDEX_MAX + 1] =
+{
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+    253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+    1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+    3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+/* Step index adjustment for each code magnitude */
+static const int8_t adpcmIndexAdjust[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+/*******************************************************************************
+*            Local Functions
+*******************************************************************************/
+static int32_t AdpcmUpdate(adpcm_codec_t *codec, uint8_t code);
+
+/*******************************************************************************
+* Function Name: AdpcmInit
+********************************************************************************
+* Summary:
+*   This function resets a codec before a new stream. The step index is carried
+*   from block to block, as the encoder adapts to the signal level.
+*
+* Parameters:
+*   codec: Codec to reset.
+*
+*******************************************************************************/
+void AdpcmInit(adpcm_codec_t *codec)
+{
+    codec->predictor = 0;
+    codec->index = 0;
+    codec->block = NULL;
+    codec->sample = ADPCM_BLOCK_SAMPLES;
+}
+
+/*******************************************************************************
+* Function Name: AdpcmEncodeBlock
+********************************************************************************
+* Summary:
+*   This function starts to encode a new block. The header is written with the
+*   first sample given to AdpcmEncode.
+*
+* Parameters:
+*   codec: Encoder.
+*   block: Buffer of ADPCM_BLOCK_SIZE bytes.
+*
+*******************************************************************************/
+void AdpcmEncodeBlock(adpcm_codec_t *codec, uint8_t *block)
+{
+    codec->block = block;
+    codec->sample = 0;
+}
+
+/*******************************************************************************
+* Function Name: AdpcmEncode
+********************************************************************************
+* Summary:
+*   This function encodes PCM samples in the current block, until the block is 
+*   full.
+*
+* Parameters:
+*   codec: Encoder.
+*   pcm: 16-bit samples.
+*   count: Number of samples.
+*
+* Return:
+*   uint32_t: Number of samples encoded.
+*
+*******************************************************************************/
+uint32_t AdpcmEncode(adpcm_codec_t *codec, const int16_t pcm[], uint32_t count)
+{
+    adpcm_header_t *header = (adpcm_header_t *) codec->block;
+    uint8_t *data = &codec->block[ADPCM_HEADER_SIZE];
+    uint32_t done;
+    uint32_t nibble;
+    int32_t diff;
+    int32_t step;
+    uint8_t code;
+    
+    for (done = 0; (done < count) && (codec->sample < ADPCM_BLOCK_SAMPLES); done++)
+    {
+        if (codec->sample == 0)
+        {
+            /* First sample goes as is in the header */
+            codec->predictor = pcm[done];
+            header->sample = pcm[done];
+            header->index = (uint8_t) codec->index;
+            header->reserved = 0;
+        }
+        else
+        {
+            /* Quantize the difference with the prediction */
+            step = adpcmSteps[codec->index];
+            diff = pcm[done] - codec->predictor;
+            code = 0;
+            
+            if (diff < 0)
+            {
+                code = 8;
+                diff = -diff;
+            }
+            if (diff >= step)
+            {
+                code |= 4;
+                diff -= step;
+            }
+            step >>= 1;
+            if (diff >= step)
+            {
+                code |= 2;
+                diff -= step;
+            }
+            step >>= 1;
+            if (diff >= step)
+            {
+                code |= 1;
+            }
+            
+            /* Track the decoder, so both predictions stay equal */
+            AdpcmUpdate(codec, code);
+            
+            /* Low nibble first */
+            nibble = codec->sample - 1u;
+            if ((nibble & 1u) == 0u)
+            {
+                data[nibble/2u] = code;
+            }
+            else
+            {
+                data[nibble/2u] |= (uint8_t) (code << 4);
+            }
+        }
+        
+        codec->sample++;
+    }
+    
+    return done;
+}
+
+/*******************************************************************************
+* Function Name: AdpcmDecodeBlock
+********************************************************************************
+* Summary:
+*   This function starts to decode a block, from its header.
+*
+* Parameters:
+*   codec: Decoder.
+*   block: Block of ADPCM_BLOCK_SIZE bytes.
+*
+*******************************************************************************/
+void AdpcmDecodeBlock(adpcm_codec_t *codec, uint8_t *block)
+{
+    adpcm_header_t *header = (adpcm_header_t *) block;
+    
+    codec->block = block;
+    codec->sample = 0;
+    codec->predictor = header->sample;
+    codec->index = (header->index > ADPCM_INDEX_MAX) ? ADPCM_INDEX_MAX : header->index;
+}
+
+/*******************************************************************************
+* Function Name: AdpcmDecode
+********************************************************************************
+* Summary:
+*   This function decodes PCM samples from the current block, until the block 
+*   is done.
+*
+* Parameters:
+*   codec: Decoder.
+*   pcm: 16-bit samples.
+*   count: Number of samples wanted.
+*
+* Return:
+*   uint32_t: Number of samples decoded.
+*
+*******************************************************************************/
+uint32_t AdpcmDecode(adpcm_codec_t *codec, int16_t pcm[], uint32_t count)
+{
+    uint8_t *data = &codec->block[ADPCM_HEADER_SIZE];
+    uint32_t done;
+    uint32_t nibble;
+    uint8_t code;
+    
+    for (done = 0; (done < count) && (codec->sample < ADPCM_BLOCK_SAMPLES); done++)
+    {
+        if (codec->sample == 0)
+        {
+            pcm[done] = (int16_t) codec->predictor;
+        }
+        else
+        {
+            nibble = codec->sample - 1u;
+            code = data[nibble/2u];
+            code = ((nibble & 1u) == 0u) ? (code & 0x0Fu) : (code >> 4);
+            
+            pcm[done] = (int16_t) AdpcmUpdate(codec, code);
+        }
+        
+        codec->sample++;
+    }
+    
+    return done;
+}
+
+/* True once the block is full or fully decoded */
+bool AdpcmBlockDone(const adpcm_codec_t *codec)
+{
+    return (codec->sample >= ADPCM_BLOCK_SAMPLES);
+}
+
+/* Apply a code to the prediction and the step index, as the decoder does */
+static int32_t AdpcmUpdate(adpcm_codec_t *codec, uint8_t code)
+{
+    int32_t step = adpcmSteps[codec->index];
+    int32_t delta = step >> 3;
+    
+    if (code & 4u)
+    {
+        delta += step;
+    }
+    if (code & 2u)
+    {
+        delta += step >> 1;
+    }
+    if (code & 1u)
+    {
+        delta += step >> 2;
+    }
+    
+    codec->predictor += (code & 8u) ? -delta : delta;
+    
+    if (codec->predictor > INT16_MAX)
+    {
+        codec->predictor = INT16_MAX;
+    }
+    else if (codec->predictor < INT16_MIN)
+    {
+        codec->predictor = INT16_MIN;
+    }
+    
+    codec->index += adpcmIndexAdjust[code & 7u];
+    
+    if (codec->index < 0)
+    {
+        codec->index = 0;
+    }
+    else if (codec->index > ADPCM_INDEX_MAX)
+    {
+        codec->index = ADPCM_INDEX_MAX;
+    }
+    
+    return codec->predictor;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,92 @@
+/******************************************************************************
+* File Name: adpcm.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the adpcm.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef ADPCM_H
+#define ADPCM_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+
+/* IMA-ADPCM block, as in WAV files. The header holds the first sample and the
+   step index, so every block decodes on its own */
+typedef struct
+{
+    int16_t sample;                   /* First sample of the block */
+    uint8_t index;                    /* Step index for the next sample */
+    uint8_t reserved;                 /* Always zero */
+}   adpcm_header_t;
+
+/* Encoder or decoder running over one block */
+typedef struct
+{
+    int32_t predictor;                /* Last sample, encoded or decoded */
+    int32_t index;                    /* Step index, 0 to 88 */
+    uint8_t *block;                   /* Block in progress */
+    uint32_t sample;                  /* Samples done in the block */
+}   adpcm_codec_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void AdpcmInit(adpcm_codec_t *codec);
+void AdpcmEncodeBlock(adpcm_codec_t *codec, uint8_t *block);
+uint32_t AdpcmEncode(adpcm_codec_t *codec, const int16_t pcm[], uint32_t count);
+void AdpcmDecodeBlock(adpcm_codec_t *codec, uint8_t *block);
+uint32_t AdpcmDecode(adpcm_codec_t *codec, int16_t pcm[], uint32_t count);
+bool AdpcmBlockDone(const adpcm_codec_t *codec);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define ADPCM_BLOCK_SIZE    (504u)          /* Memory page less the page header */
+#define ADPCM_HEADER_SIZE   (sizeof(adpcm_header_t))
+#define ADPCM_BLOCK_SAMPLES ((ADPCM_BLOCK_SIZE - ADPCM_HEADER_SIZE)*2u + 1u)
+                                            /* Header sample plus a nibble per byte half */
+
+#endif
+/* [] END OF FILE */
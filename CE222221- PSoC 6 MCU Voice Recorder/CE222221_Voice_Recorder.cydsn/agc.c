@@ -0,0 +1,350 @@
+/******************************************************************************
+* File Name: agc.c
+*
+* Version: 1.0
+*
+* Description: This file contains the automatic gain control, a processing
+*              stage that evens the level of the captured pages
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include "agc.h"
+
+/* The DSP instructions are used when the compiler targets them, the C 
+   reference builds on a host as well */
+#if (AGC_SIMD != 0u) && defined(__ARM_FEATURE_DSP)
+#include "project.h"
+#define AGC_DSP             (1u)
+#else
+#define AGC_DSP             (0u)
+#endif
+
+static uint32_t AgcGains(agc_t *agc, uint64_t energy, uint32_t count, uint32_t peak, int32_t *step);
+static uint32_t AgcSqrt(uint32_t value);
+static int32_t AgcMagnitude(int32_t sample);
+static int32_t AgcSaturate(int32_t value, uint32_t bits);
+#if (AGC_DSP != 0u)
+static uint64_t AgcLevelDsp(const uint32_t *pairs, uint32_t count, uint32_t *peak);
+static void AgcApplyDsp(uint32_t *pairs, uint32_t count, uint32_t gain, int32_t step);
+#endif
+
+/*******************************************************************************
+* Function Name: AgcInit
+********************************************************************************
+* Summary:
+*   This function resets an automatic gain control to unity gain.
+*
+* Parameters:
+*   agc: Gain control to reset.
+*   enabled: false to leave the blocks unchanged.
+*
+*******************************************************************************/
+void AgcInit(agc_t *agc, bool enabled)
+{
+    agc->enabled = enabled;
+    agc->gain = AGC_UNITY;
+    agc->level = 0;
+    agc->peak = 0;
+}
+
+/*******************************************************************************
+* Function Name: AgcProcess
+********************************************************************************
+* Summary:
+*   This function is the process of a gain control stage, its state is an 
+*   agc_t. It levels a block of 16-bit samples with the DSP instructions, two
+*   samples per word, and leaves the 24-bit blocks, or a build without the 
+*   instructions, to AgcProcessRef. Both give the same samples.
+*
+* Parameters:
+*   stage: Stage run, its state is the gain control.
+*   block: Block processed in place.
+*
+*******************************************************************************/
+void AgcProcess(dsp_stage_t *stage, dsp_block_t *block)
+{
+#if (AGC_DSP != 0u)
+    agc_t *agc = (agc_t *) stage->state;
+    uint32_t count = block->frames*block->channels;
+    uint32_t *pairs = (uint32_t *) block->samples;
+    uint64_t energy;
+    uint32_t peak;
+    uint32_t gain;
+    int32_t step;
+    
+    if ((block->sampleSize == sizeof(int16_t)) && ((count & 1u) == 0u) && (count != 0u))
+    {
+        if (agc->enabled)
+        {
+            energy = AgcLevelDsp(pairs, count/2u, &peak);
+            gain = AgcGains(agc, energy, count, peak, &step);
+            AgcApplyDsp(pairs, count/2u, gain, step);
+        }
+        return;
+    }
+#endif
+    
+    AgcProcessRef(stage, block);
+}
+
+/*******************************************************************************
+* Function Name: AgcProcessRef
+********************************************************************************
+* Summary:
+*   This function is the portable process of a gain control stage, in C. The 
+*   gain of a block is set from its RMS level: towards AGC_TARGET_LEVEL, held 
+*   below AGC_GATE_LEVEL. It is then capped so that the peak of the block does 
+*   not clip, the block being its own look-ahead. The gain goes in a ramp from 
+*   the last block, one step per two samples, and the samples saturate. The 
+*   24-bit samples are measured at the 16-bit scale.
+*
+* Parameters:
+*   stage: Stage run, its state is the gain control.
+*   block: Block processed in place.
+*
+*******************************************************************************/
+void AgcProcessRef(dsp_stage_t *stage, dsp_block_t *block)
+{
+    agc_t *agc = (agc_t *) stage->state;
+    uint32_t count = block->frames*block->channels;
+    int16_t *samples16 = (int16_t *) block->samples;
+    int32_t *samples24 = (int32_t *) block->samples;
+    bool wide = (block->sampleSize == sizeof(int32_t));
+    uint64_t energy = 0;
+    uint32_t peak = 0;
+    uint32_t gain;
+    uint32_t index;
+    int32_t sample;
+    int32_t step;
+    int32_t scaled;
+    
+    if (!agc->enabled || (count == 0u))
+    {
+        return;
+    }
+    
+    for (index = 0; index < count; index++)
+    {
+        sample = wide ? (samples24[index] >> 8) : samples16[index];
+        energy += (uint64_t) ((int64_t) sample * sample);
+        if ((uint32_t) AgcMagnitude(sample) > peak)
+        {
+            peak = (uint32_t) AgcMagnitude(sample);
+        }
+    }
+    
+    gain = AgcGains(agc, energy, count, peak, &step);
+    
+    for (index = 0; index < count; index++)
+    {
+        /* Q4.11, as the DSP instructions take it */
+        scaled = (int32_t) (gain >> (16u - AGC_GAIN_FRAC));
+        
+        if (wide)
+        {
+            samples24[index] = AgcSaturate((int32_t) (((int64_t) samples24[index] * scaled) >> AGC_GAIN_FRAC), 24u);
+        }
+        else
+        {
+            samples16[index] = (int16_t) AgcSaturate((samples16[index] * scaled) >> AGC_GAIN_FRAC, 16u);
+        }
+        
+        /* One step per two samples */
+        if ((index & 1u) != 0u)
+        {
+            gain = (uint32_t) ((int32_t) gain + step);
+        }
+    }
+}
+
+/* Gain at the start of a block and its step per two samples, from its level and peak */
+static uint32_t AgcGains(agc_t *agc, uint64_t energy, uint32_t count, uint32_t peak, int32_t *step)
+{
+    uint32_t start = agc->gain;
+    uint32_t end = agc->gain;
+    uint32_t target;
+    uint32_t limit;
+    
+    agc->level = AgcSqrt((uint32_t) (energy / count));
+    agc->peak = peak;
+    
+    /* Quiet blocks hold the gain, the background is not brought up */
+    if (agc->level >= AGC_GATE_LEVEL)
+    {
+        target = (AGC_TARGET_LEVEL*AGC_UNITY) / agc->level;
+        if (target > AGC_MAX_GAIN)
+        {
+            target = AGC_MAX_GAIN;
+        }
+        else if (target < AGC_MIN_GAIN)
+        {
+            target = AGC_MIN_GAIN;
+        }
+        
+        /* The gain drops within the block, it rises slowly */
+        if (target < end)
+        {
+            end = target;
+        }
+        else
+        {
+            end += end >> AGC_RELEASE_SHIFT;
+            if (end > target)
+            {
+                end = target;
+            }
+        }
+    }
+    
+    /* No sample of the block over full scale */
+    if (peak > 0u)
+    {
+        limit = (32767u*AGC_UNITY) / peak;
+        if (start > limit)
+        {
+            start = limit;
+        }
+        if (end > limit)
+        {
+            end = limit;
+        }
+    }
+    
+    agc->gain = end;
+    *step = ((int32_t) end - (int32_t) start) / (int32_t) ((count + 1u)/2u);
+    
+    return start;
+}
+
+/* Integer square root, bit by bit */
+static uint32_t AgcSqrt(uint32_t value)
+{
+    uint32_t root = 0;
+    uint32_t bit = 1u << 30;
+    
+    while (bit > value)
+    {
+        bit >>= 2;
+    }
+    
+    while (bit != 0u)
+    {
+        if (value >= (root + bit))
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    
+    return root;
+}
+
+/* Absolute 16-bit sample, saturated as QSUB16 does */
+static int32_t AgcMagnitude(int32_t sample)
+{
+    if (sample >= 0)
+    {
+        return sample;
+    }
+    
+    return (sample <= -32768) ? 32767 : -sample;
+}
+
+/* Signed saturation to a number of bits, as SSAT does */
+static int32_t AgcSaturate(int32_t value, uint32_t bits)
+{
+    int32_t high = (int32_t) ((1u << (bits - 1u)) - 1u);
+    
+    if (value > high)
+    {
+        return high;
+    }
+    
+    return (value < (-high - 1)) ? (-high - 1) : value;
+}
+
+#if (AGC_DSP != 0u)
+/* Energy and peak of the samples, two per word, by dual multiply-accumulate */
+static uint64_t AgcLevelDsp(const uint32_t *pairs, uint32_t count, uint32_t *peak)
+{
+    uint64_t energy = 0;
+    uint32_t top = 0;
+    uint32_t magnitude;
+    uint32_t index;
+    
+    for (index = 0; index < count; index++)
+    {
+        energy = __SMLALD(pairs[index], pairs[index], energy);
+        
+        /* Magnitude of both samples, then the larger one of each half kept */
+        magnitude = __QSUB16(0u, pairs[index]);
+        (void) __SSUB16(pairs[index], magnitude);
+        magnitude = __SEL(pairs[index], magnitude);
+        (void) __SSUB16(magnitude, top);
+        top = __SEL(magnitude, top);
+    }
+    
+    *peak = ((top & 0xFFFFu) > (top >> 16)) ? (top & 0xFFFFu) : (top >> 16);
+    
+    return energy;
+}
+
+/* Samples times the gain in Q4.11, saturated, two per word */
+static void AgcApplyDsp(uint32_t *pairs, uint32_t count, uint32_t gain, int32_t step)
+{
+    uint32_t scaled;
+    uint32_t index;
+    int32_t low;
+    int32_t high;
+    
+    for (index = 0; index < count; index++)
+    {
+        scaled = gain >> (16u - AGC_GAIN_FRAC);
+        
+        low = __SSAT((int32_t) __SMUAD(pairs[index], scaled) >> AGC_GAIN_FRAC, 16);
+        high = __SSAT((int32_t) __SMUAD(pairs[index], scaled << 16) >> AGC_GAIN_FRAC, 16);
+        pairs[index] = __PKHBT((uint32_t) low, (uint32_t) high, 16);
+        
+        gain = (uint32_t) ((int32_t) gain + step);
+    }
+}
+#endif
+
+/* [] END OF FILE */
@@ -0,0 +1,90 @@
+/******************************************************************************
+* File Name: agc.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the agc.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef AGC_H
+#define AGC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp.h"
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+/* State of an automatic gain control, one per path. The gain of a block is set
+   from its own RMS level and peak, the block is its look-ahead */
+typedef struct agc
+{
+    bool enabled;                     /* Blocks are left unchanged when false */
+    uint32_t gain;                    /* Gain at the end of the last block, Q16.16 */
+    uint32_t level;                   /* RMS level of the last block, 16-bit scale */
+    uint32_t peak;                    /* Largest absolute sample of the last block */
+} agc_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void AgcInit(agc_t *agc, bool enabled);
+void AgcProcess(dsp_stage_t *stage, dsp_block_t *block);
+void AgcProcessRef(dsp_stage_t *stage, dsp_block_t *block);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+/* The 16-bit blocks use the Cortex-M4 DSP instructions, when the compiler has
+   them: dual 16-bit multiply-accumulate for the level, saturating packed 
+   arithmetic for the peak and the gain. AgcProcessRef is the same in plain C,
+   sample for sample, and also processes the 24-bit blocks */
+#define AGC_SIMD            (1u)            /* Set to 0 to always run the C reference */
+
+#define AGC_UNITY           (0x10000u)      /* Gain of 1, Q16.16 */
+#define AGC_GAIN_FRAC       (11u)           /* Fraction bits of the gain applied, Q4.11 */
+#define AGC_MAX_GAIN        (8u*AGC_UNITY)  /* Most gain, 18 dB, below 16 in Q4.11 */
+#define AGC_MIN_GAIN        (AGC_UNITY/4u)  /* Least gain, -12 dB */
+#define AGC_TARGET_LEVEL    (4096u)         /* RMS level aimed at, -18 dBFS */
+#define AGC_GATE_LEVEL      (128u)          /* RMS level below which the gain holds */
+#define AGC_RELEASE_SHIFT   (5u)            /* Gain rises by 1/32 per block at most */
+#define AGC_BUDGET_CYCLES   (6000u)         /* Cycles declared for a page */
+
+#endif
+/* [] END OF FILE */
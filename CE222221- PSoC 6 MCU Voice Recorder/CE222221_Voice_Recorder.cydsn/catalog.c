@@ -0,0 +1,1093 @@
+/******************************************************************************
+* File Name: catalog.c
+*
+* Version: 1.0
+*
+* Description: This file contains the functions used to keep the catalog of
+*              recordings stored in the external memory
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include <string.h>
+#include "catalog.h"
+#include "recorder.h"
+#include "smif_mem.h"
+#include "rtos.h"
+
+/*******************************************************************************
+*            Local Functions
+*******************************************************************************/
+static void ReplayCatalogEntry(const catalog_entry_t *entry);
+static bool ReplayJournal(uint32_t first, uint32_t tail);
+static uint32_t FindJournalSector(void);
+static uint32_t FindJournalTail(void);
+static uint32_t ReadJournalSignature(uint32_t index);
+static bool AppendCatalogEntry(catalog_entry_t *entry);
+static void WriteCheckpoint(void);
+static void BuildCheckpoint(void);
+static void ProgressWrittenCallback(mem_op_t op, uint32_t address, void *arg);
+static bool ValidRecordEntry(const catalog_entry_t *entry);
+static void ApplyCheckpoint(const catalog_checkpoint_t *checkpoint);
+static void CompactCatalog(void);
+static void FormatCatalog(void);
+static void ResetCatalogIndex(void);
+static void SetSectorOwner(record_handle_t handle, uint8_t owner);
+static void DropRecord(record_handle_t handle);
+static void FindLatestRecord(void);
+static void CountRecordErases(record_handle_t handle);
+
+/* One page of the journal, entries or a checkpoint */
+typedef union
+{
+    catalog_entry_t entries[PACKET_SIZE/sizeof(catalog_entry_t)];
+    catalog_checkpoint_t checkpoint;
+    catalog_wear_t wear;
+} catalog_page_t;
+
+/*******************************************************************************
+*            Internal Global Variables
+*******************************************************************************/
+catalog_record_t catalogRecords[CATALOG_MAX_RECORDS];   /* RAM index, by handle */
+uint8_t sectorOwner[NUM_SECTORS_IN_MEM];    /* Handle using each sector */
+catalog_page_t journalPage;                 /* Journal page read or checkpoint written */
+catalog_wear_t wearPage;                    /* Erase counters written after a checkpoint */
+uint32_t eraseCounts[NUM_SECTORS_IN_MEM];   /* Erase counters found when mounting */
+uint32_t journalSector = INFO_SECTOR;       /* Info sector holding the journal */
+uint32_t journalGeneration = 0;             /* Rotations of the journal */
+uint32_t journalTail = 0;                   /* Next free entry in the journal */
+uint32_t catalogSequence = 0;               /* Sequence of the next recording */
+record_handle_t latestHandle = NO_RECORD_HANDLE;    /* Newest recording stored */
+uint32_t mountTime = 0;                     /* Duration of the last mount in us */
+catalog_entry_t progressEntry;              /* Progress entry being programmed */
+volatile uint32_t progressPending = 0;      /* Progress writes not completed */
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define CATALOG_ADDRESS         (journalSector * SECTOR_SIZE)
+#define CATALOG_ENTRY_SIZE      (sizeof(catalog_entry_t))
+#define CATALOG_JOURNAL_ENTRIES (SECTOR_SIZE / CATALOG_ENTRY_SIZE)
+#define CATALOG_ENTRIES_IN_PAGE (PACKET_SIZE / CATALOG_ENTRY_SIZE)
+#define CATALOG_US_PER_TICK     (1000000u / configTICK_RATE_HZ)
+
+/*******************************************************************************
+* Function Name: InitCatalog
+********************************************************************************
+* Summary:
+*   This function mounts the catalog. The tail of the journal is found with a 
+*   binary search that reads only the signature words. The RAM index is loaded 
+*   from the last checkpoint and the few entries after it are replayed. If that
+*   checkpoint is not valid, the whole journal is replayed. The journal rotates
+*   on the info sectors, the newest one is mounted. If none holds a journal, 
+*   the first is erased. The erase counters are restored from the journal as 
+*   well. The time taken is kept for CatalogMountTime.
+*
+*******************************************************************************/
+void InitCatalog(void)
+{
+    TickType_t startTick = xTaskGetTickCount();
+    uint32_t tail;
+    uint32_t checkpoint;
+    
+    ResetCatalogIndex();
+    
+    /* The journal always starts with a checkpoint. Anything else, such as the 
+       single info page of older firmware, is erased */
+    if (FindJournalSector() == MEM_NO_SECTOR)
+    {
+        EraseCountInit(eraseCounts);
+        FormatCatalog();
+    }
+    else
+    {
+        tail = FindJournalTail();
+        
+        /* Checkpoints are written every CATALOG_CHECKPOINT_INTERVAL entries */
+        checkpoint = ((tail - 1u) / CATALOG_CHECKPOINT_INTERVAL) * CATALOG_CHECKPOINT_INTERVAL;
+        
+        if (!ReplayJournal(checkpoint, tail))
+        {
+            ResetCatalogIndex();
+            ReplayJournal(0, tail);
+        }
+        
+        journalTail = tail;
+        
+        EraseCountInit(eraseCounts);
+    }
+    
+    mountTime = (xTaskGetTickCount() - startTick) * CATALOG_US_PER_TICK;
+}
+
+/*******************************************************************************
+* Function Name: CatalogReserve
+********************************************************************************
+* Summary:
+*   This function reserves a handle for a new recording. Nothing is written to 
+*   the memory until the recording is committed. If the catalog is full, the 
+*   oldest recording is deleted.
+*
+* Return:
+*   record_handle_t: handle of the new recording.
+*
+*******************************************************************************/
+record_handle_t CatalogReserve(void)
+{
+    record_handle_t handle;
+    record_handle_t oldest;
+    
+    for (handle = 0; handle < CATALOG_MAX_RECORDS; handle++)
+    {
+        if (catalogRecords[handle].state == RECORD_FREE)
+        {
+            break;
+        }
+    }
+    
+    /* No free slot, make room */
+    if (handle == CATALOG_MAX_RECORDS)
+    {
+        oldest = CatalogOldest();
+        
+        if (oldest == NO_RECORD_HANDLE)
+        {
+            return NO_RECORD_HANDLE;
+        }
+        
+        CatalogDelete(oldest);
+        handle = oldest;
+    }
+    
+    catalogRecords[handle].state = RECORD_RESERVED;
+    catalogRecords[handle].numberOfPages = 0;
+    
+    return handle;
+}
+
+/*******************************************************************************
+* Function Name: CatalogCommit
+********************************************************************************
+* Summary:
+*   This function stores a recording in the catalog, appending one entry to the 
+*   journal.
+*
+* Parameters:
+*   handle: handle returned by CatalogReserve.
+*   startSector: first sector of the recording.
+*   numberOfPages: number of pages recorded.
+*   format: format of the recorded data.
+*   flags: recording flags.
+*
+* Return:
+*   bool: true if the recording was stored.
+*
+*******************************************************************************/
+bool CatalogCommit(record_handle_t handle,
+                    uint32_t startSector,
+                    uint32_t numberOfPages,
+                    uint32_t format,
+                    uint32_t flags)
+{
+    catalog_entry_t entry;
+    
+    if ((handle >= CATALOG_MAX_RECORDS) || 
+        ((catalogRecords[handle].state != RECORD_RESERVED) && (catalogRecords[handle].state != RECORD_OPEN)))
+    {
+        return false;
+    }
+    
+    memset(&entry, 0xFF, sizeof(entry));
+    entry.signature = CATALOG_SIGNATURE;
+    entry.handle = (uint16_t) handle;
+    entry.type = CATALOG_ENTRY_ADD;
+    entry.flags = (uint8_t) flags;
+    entry.startSector = startSector;
+    entry.numberOfPages = numberOfPages;
+    entry.format = format;
+    
+    if (!AppendCatalogEntry(&entry))
+    {
+        return false;
+    }
+    
+    ReplayCatalogEntry(&entry);
+    
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: CatalogProgress
+********************************************************************************
+* Summary:
+*   This function saves the progress of a recording, so it can be recovered 
+*   after a power loss. Unlike the other updates, the entry is only queued to 
+*   the storage task, after the pages already submitted. The recorder is never 
+*   blocked: the progress is skipped while the previous one is in the queue or
+*   when the journal is full, the next commit compacts it.
+*
+* Parameters:
+*   handle: handle returned by CatalogReserve.
+*   startSector: first sector of the recording.
+*   numberOfPages: number of pages submitted so far.
+*   format: format of the recorded data.
+*   flags: recording flags.
+*
+* Return:
+*   bool: true if the progress was queued.
+*
+*******************************************************************************/
+bool CatalogProgress(record_handle_t handle,
+                    uint32_t startSector,
+                    uint32_t numberOfPages,
+                    uint32_t format,
+                    uint32_t flags)
+{
+    catalog_record_t *record;
+    uint32_t address = CATALOG_ADDRESS + journalTail*CATALOG_ENTRY_SIZE;
+    
+    if ((handle >= CATALOG_MAX_RECORDS) || (catalogRecords[handle].state != RECORD_RESERVED) ||
+        (progressPending != 0u) || (journalTail >= CATALOG_JOURNAL_ENTRIES) || (MemoryQueueSpace() < 2u))
+    {
+        return false;
+    }
+    
+    /* Checkpoints include the recording in progress */
+    record = &catalogRecords[handle];
+    record->startSector = startSector;
+    record->numberOfPages = numberOfPages;
+    record->format = format;
+    record->flags = flags;
+    record->sequence = catalogSequence;
+    
+    if ((journalTail % CATALOG_CHECKPOINT_INTERVAL) == 0)
+    {
+        BuildCheckpoint();
+        
+        /* Both pages fit in the queue, it was checked above */
+        SubmitMemory(MEM_OP_PROGRAM, (uint8_t *) &journalPage.checkpoint, PACKET_SIZE, 
+                     address, ProgressWrittenCallback, NULL);
+        SubmitMemory(MEM_OP_PROGRAM, (uint8_t *) &wearPage, PACKET_SIZE, 
+                     address + PACKET_SIZE, ProgressWrittenCallback, NULL);
+        
+        progressPending += 2u;
+        journalTail += 2u*CATALOG_ENTRIES_IN_PAGE;
+        
+        return true;
+    }
+    
+    memset(&progressEntry, 0xFF, sizeof(progressEntry));
+    progressEntry.signature = CATALOG_SIGNATURE;
+    progressEntry.handle = (uint16_t) handle;
+    progressEntry.type = CATALOG_ENTRY_PROGRESS;
+    progressEntry.flags = (uint8_t) flags;
+    progressEntry.startSector = startSector;
+    progressEntry.numberOfPages = numberOfPages;
+    progressEntry.format = format;
+    progressEntry.sequence = catalogSequence;
+    
+    if (!SubmitMemory(MEM_OP_PROGRAM, (uint8_t *) &progressEntry, CATALOG_ENTRY_SIZE, 
+                      address, ProgressWrittenCallback, NULL))
+    {
+        return false;
+    }
+    
+    progressPending++;
+    journalTail++;
+    
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: CatalogRelease
+********************************************************************************
+* Summary:
+*   This function releases a handle reserved for a recording that was not kept.
+*   If its progress was saved, a delete entry is appended so it is not 
+*   recovered on the next mount.
+*
+* Parameters:
+*   handle: handle returned by CatalogReserve.
+*
+*******************************************************************************/
+void CatalogRelease(record_handle_t handle)
+{
+    catalog_entry_t entry;
+    
+    if ((handle >= CATALOG_MAX_RECORDS) || 
+        ((catalogRecords[handle].state != RECORD_RESERVED) && (catalogRecords[handle].state != RECORD_OPEN)))
+    {
+        return;
+    }
+    
+    if ((catalogRecords[handle].state == RECORD_OPEN) || (catalogRecords[handle].numberOfPages != 0))
+    {
+        memset(&entry, 0xFF, sizeof(entry));
+        entry.signature = CATALOG_SIGNATURE;
+        entry.handle = (uint16_t) handle;
+        entry.type = CATALOG_ENTRY_DELETE;
+        
+        AppendCatalogEntry(&entry);
+    }
+    
+    catalogRecords[handle].state = RECORD_FREE;
+}
+
+/*******************************************************************************
+* Function Name: CatalogDelete
+********************************************************************************
+* Summary:
+*   This function deletes a recording, appending one entry to the journal. The 
+*   sectors of the recording can be reused afterwards.
+*
+* Parameters:
+*   handle: handle of the recording.
+*
+* Return:
+*   bool: true if the recording was deleted.
+*
+*******************************************************************************/
+bool CatalogDelete(record_handle_t handle)
+{
+    catalog_entry_t entry;
+    
+    if (CatalogGet(handle) == NULL)
+    {
+        return false;
+    }
+    
+    memset(&entry, 0xFF, sizeof(entry));
+    entry.signature = CATALOG_SIGNATURE;
+    entry.handle = (uint16_t) handle;
+    entry.type = CATALOG_ENTRY_DELETE;
+    
+    if (!AppendCatalogEntry(&entry))
+    {
+        return false;
+    }
+    
+    ReplayCatalogEntry(&entry);
+    
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: CatalogGet
+********************************************************************************
+* Summary:
+*   Return a recording stored in the catalog.
+*
+* Parameters:
+*   handle: handle of the recording.
+*
+* Return:
+*   const catalog_record_t *: the recording, NULL if not stored.
+*
+*******************************************************************************/
+const catalog_record_t * CatalogGet(record_handle_t handle)
+{
+    if ((handle >= CATALOG_MAX_RECORDS) || (catalogRecords[handle].state != RECORD_STORED))
+    {
+        return NULL;
+    }
+    
+    return &catalogRecords[handle];
+}
+
+/*******************************************************************************
+* Function Name: CatalogLatest
+********************************************************************************
+* Summary:
+*   Return the newest recording stored in the catalog.
+*
+* Return:
+*   record_handle_t: handle of the recording, NO_RECORD_HANDLE if empty.
+*
+*******************************************************************************/
+record_handle_t CatalogLatest(void)
+{
+    return latestHandle;
+}
+
+/*******************************************************************************
+* Function Name: CatalogOldest
+********************************************************************************
+* Summary:
+*   Return the oldest recording stored in the catalog.
+*
+* Return:
+*   record_handle_t: handle of the recording, NO_RECORD_HANDLE if empty.
+*
+*******************************************************************************/
+record_handle_t CatalogOldest(void)
+{
+    record_handle_t handle;
+    record_handle_t oldest = NO_RECORD_HANDLE;
+    
+    for (handle = 0; handle < CATALOG_MAX_RECORDS; handle++)
+    {
+        if ((catalogRecords[handle].state == RECORD_STORED) && ((oldest == NO_RECORD_HANDLE) ||
+            (catalogRecords[handle].sequence < catalogRecords[oldest].sequence)))
+        {
+            oldest = handle;
+        }
+    }
+    
+    return oldest;
+}
+
+/*******************************************************************************
+* Function Name: CatalogOwner
+********************************************************************************
+* Summary:
+*   Return the recording using a sector of the memory.
+*
+* Parameters:
+*   sector: sector of the memory.
+*
+* Return:
+*   record_handle_t: handle of the recording, NO_RECORD_HANDLE if unused.
+*
+*******************************************************************************/
+record_handle_t CatalogOwner(uint32_t sector)
+{
+    if ((sector >= NUM_SECTORS_IN_MEM) || (sectorOwner[sector] == CATALOG_NO_OWNER))
+    {
+        return NO_RECORD_HANDLE;
+    }
+    
+    return sectorOwner[sector];
+}
+
+/*******************************************************************************
+* Function Name: CatalogEndSector
+********************************************************************************
+* Summary:
+*   Return the last sector used by a recording, recordings wrap to the first 
+*   record sector.
+*
+* Parameters:
+*   handle: handle of the recording.
+*
+* Return:
+*   uint32_t: last sector, INFO_SECTOR if the recording is not stored.
+*
+*******************************************************************************/
+uint32_t CatalogEndSector(record_handle_t handle)
+{
+    const catalog_record_t *record = CatalogGet(handle);
+    uint32_t sector;
+    
+    if (record == NULL)
+    {
+        return INFO_SECTOR;
+    }
+    
+    sector = record->startSector + (record->numberOfPages*PACKET_SIZE - 1u)/SECTOR_SIZE;
+    
+    if (sector >= NUM_SECTORS_IN_MEM)
+    {
+        sector = sector - NUM_SECTORS_IN_MEM + FIRST_RECORD_SECTOR;
+    }
+    
+    return sector;
+}
+
+/*******************************************************************************
+* Function Name: CatalogNextSequence
+********************************************************************************
+* Summary:
+*   Return the sequence the next committed recording gets. Older recordings all
+*   have a lower one, so it tags the pages of the recording in progress.
+*
+* Return:
+*   uint32_t: sequence of the next recording.
+*
+*******************************************************************************/
+uint32_t CatalogNextSequence(void)
+{
+    return catalogSequence;
+}
+
+/*******************************************************************************
+* Function Name: CatalogInterrupted
+********************************************************************************
+* Summary:
+*   Return the recording found in progress at mount time, interrupted by a 
+*   power loss. It stays reserved until it is committed with its recovered 
+*   length, or released.
+*
+* Parameters:
+*   record: filled with the last progress saved.
+*
+* Return:
+*   record_handle_t: handle of the recording, NO_RECORD_HANDLE if none.
+*
+*******************************************************************************/
+record_handle_t CatalogInterrupted(catalog_record_t *record)
+{
+    record_handle_t handle;
+    
+    for (handle = 0; handle < CATALOG_MAX_RECORDS; handle++)
+    {
+        if (catalogRecords[handle].state == RECORD_OPEN)
+        {
+            *record = catalogRecords[handle];
+            return handle;
+        }
+    }
+    
+    return NO_RECORD_HANDLE;
+}
+
+/*******************************************************************************
+* Function Name: CatalogMountTime
+********************************************************************************
+* Summary:
+*   Return the time taken by the last mount of the catalog.
+*
+* Return:
+*   uint32_t: mount time in microseconds.
+*
+*******************************************************************************/
+uint32_t CatalogMountTime(void)
+{
+    return mountTime;
+}
+
+/*******************************************************************************
+* Function Name: ReplayCatalogEntry
+********************************************************************************
+* Summary:
+*   This function applies a journal entry to the RAM index. Invalid entries are
+*   ignored. A recording that overlaps the sectors of an older one replaces it.
+*
+* Parameters:
+*   entry: journal entry.
+*
+*******************************************************************************/
+static void ReplayCatalogEntry(const catalog_entry_t *entry)
+{
+    record_handle_t handle = entry->handle;
+    catalog_record_t *record;
+    
+    if ((entry->signature != CATALOG_SIGNATURE) || (handle >= CATALOG_MAX_RECORDS))
+    {
+        return;
+    }
+    
+    record = &catalogRecords[handle];
+    
+    if (entry->type == CATALOG_ENTRY_ADD)
+    {
+        if (!ValidRecordEntry(entry))
+        {
+            return;
+        }
+        
+        /* Handle reused without a delete entry */
+        DropRecord(handle);
+        
+        record->state = RECORD_STORED;
+        record->startSector = entry->startSector;
+        record->numberOfPages = entry->numberOfPages;
+        record->format = entry->format;
+        record->flags = entry->flags;
+        record->sequence = catalogSequence++;
+        
+        SetSectorOwner(handle, (uint8_t) handle);
+        
+        latestHandle = handle;
+    }
+    else if (entry->type == CATALOG_ENTRY_PROGRESS)
+    {
+        /* Only a recording not committed yet, its sectors stay unowned */
+        if (!ValidRecordEntry(entry) || (record->state == RECORD_STORED))
+        {
+            return;
+        }
+        
+        record->state = RECORD_OPEN;
+        record->startSector = entry->startSector;
+        record->numberOfPages = entry->numberOfPages;
+        record->format = entry->format;
+        record->flags = entry->flags;
+        record->sequence = entry->sequence;
+    }
+    else if (entry->type == CATALOG_ENTRY_DELETE)
+    {
+        DropRecord(handle);
+        
+        if (record->state == RECORD_OPEN)
+        {
+            record->state = RECORD_FREE;
+        }
+    }
+}
+
+/* Check the location of a recording in an add or progress entry */
+static bool ValidRecordEntry(const catalog_entry_t *entry)
+{
+    return ((entry->startSector >= FIRST_RECORD_SECTOR) && (entry->startSector < NUM_SECTORS_IN_MEM) &&
+            (entry->numberOfPages != 0) && 
+            (entry->numberOfPages <= ((NUM_SECTORS_IN_MEM - FIRST_RECORD_SECTOR) * (SECTOR_SIZE/PACKET_SIZE))));
+}
+
+/*******************************************************************************
+* Function Name: ReplayJournal
+********************************************************************************
+* Summary:
+*   This function replays the journal from a checkpoint up to the tail, reading
+*   one page at a time. Checkpoints found on the way replace the RAM index, and
+*   the erase counters pages the counters. The sectors of a recording added 
+*   after the counters were saved count one erase each.
+*
+* Parameters:
+*   first: checkpoint to start from, at a CATALOG_CHECKPOINT_INTERVAL boundary.
+*   tail: first erased entry.
+*
+* Return:
+*   bool: false if there is no valid checkpoint at first.
+*
+*******************************************************************************/
+static bool ReplayJournal(uint32_t first, uint32_t tail)
+{
+    uint32_t index;
+    uint32_t entry;
+    
+    for (index = first; index < tail; index += CATALOG_ENTRIES_IN_PAGE)
+    {
+        SyncMemory(MEM_OP_READ, (uint8_t *) &journalPage, PACKET_SIZE, CATALOG_ADDRESS + index*CATALOG_ENTRY_SIZE);
+        
+        if ((journalPage.checkpoint.header.signature == CATALOG_SIGNATURE) &&
+            (journalPage.checkpoint.header.type == CATALOG_ENTRY_CHECKPOINT))
+        {
+            ApplyCheckpoint(&journalPage.checkpoint);
+            continue;
+        }
+        
+        if ((journalPage.wear.header.signature == CATALOG_SIGNATURE) &&
+            (journalPage.wear.header.type == CATALOG_ENTRY_WEAR))
+        {
+            memcpy(eraseCounts, journalPage.wear.eraseCount, sizeof(eraseCounts));
+            continue;
+        }
+        
+        /* A full replay also accepts a journal not starting with a checkpoint */
+        if ((index == first) && (first != 0))
+        {
+            return false;
+        }
+        
+        for (entry = 0; (entry < CATALOG_ENTRIES_IN_PAGE) && ((index + entry) < tail); entry++)
+        {
+            ReplayCatalogEntry(&journalPage.entries[entry]);
+            
+            if (journalPage.entries[entry].type == CATALOG_ENTRY_ADD)
+            {
+                CountRecordErases(journalPage.entries[entry].handle);
+            }
+        }
+    }
+    
+    return true;
+}
+
+/* Find the info sector holding the newest journal, MEM_NO_SECTOR if none */
+static uint32_t FindJournalSector(void)
+{
+    catalog_entry_t header;
+    uint32_t sector;
+    uint32_t found = MEM_NO_SECTOR;
+    
+    for (sector = INFO_SECTOR; sector < (INFO_SECTOR + INFO_SECTOR_COUNT); sector++)
+    {
+        SyncMemory(MEM_OP_READ, (uint8_t *) &header, CATALOG_ENTRY_SIZE, sector * SECTOR_SIZE);
+        
+        /* The first checkpoint holds the generation of the journal */
+        if ((header.signature == CATALOG_SIGNATURE) && (header.type == CATALOG_ENTRY_CHECKPOINT) &&
+            ((found == MEM_NO_SECTOR) || (header.sequence > journalGeneration)))
+        {
+            found = sector;
+            journalGeneration = header.sequence;
+        }
+    }
+    
+    if (found != MEM_NO_SECTOR)
+    {
+        journalSector = found;
+    }
+    
+    return found;
+}
+
+/*******************************************************************************
+* Function Name: FindJournalTail
+********************************************************************************
+* Summary:
+*   This function finds the first erased entry of the journal. Entries are 
+*   programmed in order, so a binary search over the signature words is enough.
+*   The first entry is known to be programmed.
+*
+* Return:
+*   uint32_t: index of the first erased entry, CATALOG_JOURNAL_ENTRIES if full.
+*
+*******************************************************************************/
+static uint32_t FindJournalTail(void)
+{
+    uint32_t low = 1;
+    uint32_t high = CATALOG_JOURNAL_ENTRIES;
+    uint32_t middle;
+    
+    while (low < high)
+    {
+        middle = (low + high) / 2u;
+        
+        if (ReadJournalSignature(middle) == CATALOG_ERASED)
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1u;
+        }
+    }
+    
+    return low;
+}
+
+/* Read only the signature word of a journal entry */
+static uint32_t ReadJournalSignature(uint32_t index)
+{
+    uint32_t signature;
+    
+    SyncMemory(MEM_OP_READ, (uint8_t *) &signature, sizeof(signature), CATALOG_ADDRESS + index*CATALOG_ENTRY_SIZE);
+    
+    return signature;
+}
+
+/*******************************************************************************
+* Function Name: AppendCatalogEntry
+********************************************************************************
+* Summary:
+*   This function programs an entry at the tail of the journal. A full journal 
+*   is compacted first, and a checkpoint is written every 
+*   CATALOG_CHECKPOINT_INTERVAL entries.
+*
+* Parameters:
+*   entry: journal entry.
+*
+* Return:
+*   bool: true if the entry was written.
+*
+*******************************************************************************/
+static bool AppendCatalogEntry(catalog_entry_t *entry)
+{
+    /* The progress shares the journal page buffer and the tail, its writes 
+       were queued before this barrier */
+    if (progressPending != 0u)
+    {
+        SyncMemory(MEM_OP_SYNC, NULL, 0, 0);
+    }
+    
+    if (journalTail >= CATALOG_JOURNAL_ENTRIES)
+    {
+        CompactCatalog();
+        
+        if (journalTail >= CATALOG_JOURNAL_ENTRIES)
+        {
+            return false;
+        }
+    }
+    else if ((journalTail % CATALOG_CHECKPOINT_INTERVAL) == 0)
+    {
+        WriteCheckpoint();
+    }
+    
+    SyncMemory(MEM_OP_PROGRAM, (uint8_t *) entry, CATALOG_ENTRY_SIZE, CATALOG_ADDRESS + journalTail*CATALOG_ENTRY_SIZE);
+    
+    journalTail++;
+    
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: WriteCheckpoint
+********************************************************************************
+* Summary:
+*   This function programs a snapshot of the RAM index in the page at the tail 
+*   of the journal, followed by a page of erase counters.
+*
+*******************************************************************************/
+static void WriteCheckpoint(void)
+{
+    BuildCheckpoint();
+    
+    SyncMemory(MEM_OP_PROGRAM, (uint8_t *) &journalPage.checkpoint, PACKET_SIZE, CATALOG_ADDRESS + journalTail*CATALOG_ENTRY_SIZE);
+    journalTail += CATALOG_ENTRIES_IN_PAGE;
+    
+    SyncMemory(MEM_OP_PROGRAM, (uint8_t *) &wearPage, PACKET_SIZE, CATALOG_ADDRESS + journalTail*CATALOG_ENTRY_SIZE);
+    journalTail += CATALOG_ENTRIES_IN_PAGE;
+}
+
+/* Snapshot the RAM index in the journal page and the erase counters in the 
+   wear page. Reserved handles are left out, unless their progress was saved */
+static void BuildCheckpoint(void)
+{
+    catalog_checkpoint_t *checkpoint = &journalPage.checkpoint;
+    catalog_record_t *record;
+    record_handle_t handle;
+    uint32_t sector;
+    
+    memset(checkpoint, 0, sizeof(catalog_checkpoint_t));
+    checkpoint->header.signature = CATALOG_SIGNATURE;
+    checkpoint->header.type = CATALOG_ENTRY_CHECKPOINT;
+    checkpoint->header.sequence = journalGeneration;
+    checkpoint->sequence = catalogSequence;
+    
+    memset(&wearPage, 0, sizeof(wearPage));
+    wearPage.header.signature = CATALOG_SIGNATURE;
+    wearPage.header.type = CATALOG_ENTRY_WEAR;
+    
+    for (sector = 0; sector < NUM_SECTORS_IN_MEM; sector++)
+    {
+        wearPage.eraseCount[sector] = EraseCount(sector);
+    }
+    
+    for (handle = 0; handle < CATALOG_MAX_RECORDS; handle++)
+    {
+        record = &catalogRecords[handle];
+        
+        if ((record->state == RECORD_STORED) || (record->state == RECORD_OPEN) ||
+            ((record->state == RECORD_RESERVED) && (record->numberOfPages != 0)))
+        {
+            checkpoint->slots[handle].state = (record->state == RECORD_STORED) ? RECORD_STORED : RECORD_OPEN;
+            checkpoint->slots[handle].sequence = record->sequence;
+            checkpoint->slots[handle].startSector = (uint8_t) record->startSector;
+            checkpoint->slots[handle].numberOfPages = (uint16_t) record->numberOfPages;
+            checkpoint->slots[handle].format = (uint16_t) record->format;
+            checkpoint->slots[handle].flags = (uint8_t) record->flags;
+        }
+    }
+}
+
+/* Count the progress writes completed, runs in the storage task */
+static void ProgressWrittenCallback(mem_op_t op, uint32_t address, void *arg)
+{
+    (void) op;
+    (void) address;
+    (void) arg;
+    
+    progressPending--;
+}
+
+/* Load the RAM index from a checkpoint */
+static void ApplyCheckpoint(const catalog_checkpoint_t *checkpoint)
+{
+    catalog_record_t *record;
+    record_handle_t handle;
+    
+    ResetCatalogIndex();
+    
+    for (handle = 0; handle < CATALOG_MAX_RECORDS; handle++)
+    {
+        record = &catalogRecords[handle];
+        
+        if ((checkpoint->slots[handle].state == RECORD_STORED) || (checkpoint->slots[handle].state == RECORD_OPEN))
+        {
+            record->state = (record_states_t) checkpoint->slots[handle].state;
+            record->sequence = checkpoint->slots[handle].sequence;
+            record->startSector = checkpoint->slots[handle].startSector;
+            record->numberOfPages = checkpoint->slots[handle].numberOfPages;
+            record->format = checkpoint->slots[handle].format;
+            record->flags = checkpoint->slots[handle].flags;
+            
+            if (record->state == RECORD_STORED)
+            {
+                SetSectorOwner(handle, (uint8_t) handle);
+            }
+        }
+    }
+    
+    catalogSequence = checkpoint->sequence;
+    FindLatestRecord();
+}
+
+/*******************************************************************************
+* Function Name: CompactCatalog
+********************************************************************************
+* Summary:
+*   This function starts the journal again with a checkpoint of the RAM index,
+*   in the next info sector. The erases rotate on the info sectors, and the 
+*   previous journal stays valid until the new checkpoint is written.
+*
+*******************************************************************************/
+static void CompactCatalog(void)
+{
+    journalSector = INFO_SECTOR + ((journalSector - INFO_SECTOR + 1u) % INFO_SECTOR_COUNT);
+    journalGeneration++;
+    
+    SyncMemory(MEM_OP_ERASE, NULL, 0, journalSector);
+    
+    journalTail = 0;
+    WriteCheckpoint();
+}
+
+/*******************************************************************************
+* Function Name: FormatCatalog
+********************************************************************************
+* Summary:
+*   This function erases the info sector and starts an empty journal.
+*
+*******************************************************************************/
+static void FormatCatalog(void)
+{
+    ResetCatalogIndex();
+    
+    /* The new journal goes to the first info sector */
+    journalSector = INFO_SECTOR + INFO_SECTOR_COUNT - 1u;
+    journalGeneration = 0;
+    CompactCatalog();
+}
+
+/* Empty the RAM index */
+static void ResetCatalogIndex(void)
+{
+    memset(catalogRecords, 0, sizeof(catalogRecords));
+    memset(sectorOwner, CATALOG_NO_OWNER, sizeof(sectorOwner));
+    memset(eraseCounts, 0, sizeof(eraseCounts));
+    catalogSequence = 0;
+    latestHandle = NO_RECORD_HANDLE;
+}
+
+/* Mark the sectors used by a recording, replacing older recordings there,
+   or release them with CATALOG_NO_OWNER */
+static void SetSectorOwner(record_handle_t handle, uint8_t owner)
+{
+    catalog_record_t *record = &catalogRecords[handle];
+    uint32_t sector = record->startSector;
+    uint32_t count = (record->numberOfPages*PACKET_SIZE + SECTOR_SIZE - 1)/SECTOR_SIZE;
+    
+    while (count-- > 0)
+    {
+        if (owner == CATALOG_NO_OWNER)
+        {
+            /* Release only what this recording still holds */
+            if (sectorOwner[sector] == handle)
+            {
+                sectorOwner[sector] = CATALOG_NO_OWNER;
+            }
+        }
+        else
+        {
+            if ((sectorOwner[sector] != CATALOG_NO_OWNER) && (sectorOwner[sector] != owner))
+            {
+                DropRecord(sectorOwner[sector]);
+            }
+            
+            sectorOwner[sector] = owner;
+        }
+        
+        /* Recordings wrap to the first record sector */
+        sector++;
+        if (sector >= NUM_SECTORS_IN_MEM)
+        {
+            sector = FIRST_RECORD_SECTOR;
+        }
+    }
+}
+
+/* Remove a recording from the RAM index */
+static void DropRecord(record_handle_t handle)
+{
+    if (catalogRecords[handle].state != RECORD_STORED)
+    {
+        return;
+    }
+    
+    SetSectorOwner(handle, CATALOG_NO_OWNER);
+    catalogRecords[handle].state = RECORD_FREE;
+    
+    if (latestHandle == handle)
+    {
+        FindLatestRecord();
+    }
+}
+
+/* Count the erase of each sector of a recording replayed from the journal */
+static void CountRecordErases(record_handle_t handle)
+{
+    const catalog_record_t *record = CatalogGet(handle);
+    uint32_t sector;
+    uint32_t count;
+    
+    if (record == NULL)
+    {
+        return;
+    }
+    
+    sector = record->startSector;
+    count = (record->numberOfPages*PACKET_SIZE + SECTOR_SIZE - 1)/SECTOR_SIZE;
+    
+    while (count-- > 0)
+    {
+        eraseCounts[sector]++;
+        
+        /* Recordings wrap to the first record sector */
+        sector++;
+        if (sector >= NUM_SECTORS_IN_MEM)
+        {
+            sector = FIRST_RECORD_SECTOR;
+        }
+    }
+}
+
+/* Find the newest recording after the latest one is removed */
+static void FindLatestRecord(void)
+{
+    record_handle_t handle;
+    
+    latestHandle = NO_RECORD_HANDLE;
+    
+    for (handle = 0; handle < CATALOG_MAX_RECORDS; handle++)
+    {
+        if ((catalogRecords[handle].state == RECORD_STORED) && ((latestHandle == NO_RECORD_HANDLE) ||
+            (catalogRecords[handle].sequence > catalogRecords[latestHandle].sequence)))
+        {
+            latestHandle = handle;
+        }
+    }
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,184 @@
+/******************************************************************************
+* File Name: catalog.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the catalog.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include "project.h"
+#include "smif_mem.h"
+
+/* Sizes the RAM index and the checkpoint page */
+#define CATALOG_MAX_RECORDS (32u)           /* Recordings kept in the catalog */
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+typedef uint32_t record_handle_t;   /* Index of a recording in the catalog */
+
+/* Entry appended to the journal in the info sector, one page program each */
+typedef struct catalog_entry
+{
+    uint32_t signature;               /* Signature to validate content on FLASH */
+    uint16_t handle;                  /* Recording the entry applies to */
+    uint8_t  type;                    /* CATALOG_ENTRY_ADD, _DELETE or _PROGRESS */
+    uint8_t  flags;                   /* Recording flags */
+    uint32_t startSector;             /* First sector of the recording */
+    uint32_t numberOfPages;           /* Number of pages recorded */
+    uint32_t format;                  /* Format of the recorded data */
+    uint32_t sequence;                /* Sequence of a recording in progress */
+    uint32_t reserved[2];             /* For future use */
+} catalog_entry_t;
+
+/* Snapshot of a RAM index slot, stored in a checkpoint */
+typedef struct catalog_slot
+{
+    uint32_t sequence;                /* Creation order, higher is newer */
+    uint16_t numberOfPages;           /* Number of pages recorded */
+    uint16_t format;                  /* Format of the recorded data */
+    uint8_t  startSector;             /* First sector of the recording */
+    uint8_t  flags;                   /* Recording flags */
+    uint8_t  state;                   /* RECORD_FREE, RECORD_STORED or RECORD_OPEN */
+    uint8_t  reserved;                /* For future use */
+} catalog_slot_t;
+
+/* Checkpoint of the RAM index, fills one page of the journal. No word at an 
+   entry boundary ever reads as erased, so the tail search skips over it */
+typedef struct catalog_checkpoint
+{
+    catalog_entry_t header;           /* Entry of type CATALOG_ENTRY_CHECKPOINT */
+    catalog_slot_t slots[CATALOG_MAX_RECORDS]; /* RAM index by handle */
+    uint32_t sequence;                /* Sequence of the next recording */
+    uint32_t reserved[23];            /* For future use, written as zero */
+} catalog_checkpoint_t;
+
+/* Erase counters of the memory, the page after each checkpoint. A counter 
+   never reads as erased, so the tail search skips over it as well */
+typedef struct catalog_wear
+{
+    catalog_entry_t header;           /* Entry of type CATALOG_ENTRY_WEAR */
+    uint32_t eraseCount[NUM_SECTORS_IN_MEM]; /* Erases of each sector */
+    uint32_t reserved[120u - NUM_SECTORS_IN_MEM]; /* For future use, written as zero */
+} catalog_wear_t;
+
+/* Slot states in the RAM index */
+typedef enum
+{
+    RECORD_FREE     = 0x00u,
+    RECORD_RESERVED = 0x01u,
+    RECORD_STORED   = 0x02u,
+    RECORD_OPEN     = 0x03u,          /* Interrupted, known from its progress */
+}   record_states_t;
+
+/* Recording as kept in the RAM index */
+typedef struct catalog_record
+{
+    record_states_t state;            /* Slot state */
+    uint32_t startSector;             /* First sector of the recording */
+    uint32_t numberOfPages;           /* Number of pages recorded */
+    uint32_t format;                  /* Format of the recorded data */
+    uint32_t flags;                   /* Recording flags */
+    uint32_t sequence;                /* Creation order, higher is newer */
+} catalog_record_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void InitCatalog(void);
+record_handle_t CatalogReserve(void);
+bool CatalogCommit(record_handle_t handle,
+                    uint32_t startSector,
+                    uint32_t numberOfPages,
+                    uint32_t format,
+                    uint32_t flags);
+bool CatalogProgress(record_handle_t handle,
+                    uint32_t startSector,
+                    uint32_t numberOfPages,
+                    uint32_t format,
+                    uint32_t flags);
+void CatalogRelease(record_handle_t handle);
+bool CatalogDelete(record_handle_t handle);
+const catalog_record_t * CatalogGet(record_handle_t handle);
+record_handle_t CatalogLatest(void);
+record_handle_t CatalogOldest(void);
+record_handle_t CatalogOwner(uint32_t sector);
+uint32_t CatalogEndSector(record_handle_t handle);
+uint32_t CatalogNextSequence(void);
+record_handle_t CatalogInterrupted(catalog_record_t *record);
+uint32_t CatalogMountTime(void);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define CATALOG_SIGNATURE   (0x52454331u)   /* Signature for catalog entries */
+#define CATALOG_ERASED      (0xFFFFFFFFu)   /* Word read from erased FLASH */
+#define NO_RECORD_HANDLE    (0xFFFFFFFFu)   /* Invalid recording handle */
+#define CATALOG_ENTRY_ADD   (0x01u)         /* Entry stores a recording */
+#define CATALOG_ENTRY_DELETE (0x02u)        /* Entry removes a recording */
+#define CATALOG_ENTRY_CHECKPOINT (0x03u)    /* Entry starts a checkpoint page */
+#define CATALOG_ENTRY_PROGRESS (0x04u)      /* Entry saves a recording in progress */
+#define CATALOG_ENTRY_WEAR  (0x05u)         /* Entry starts an erase counters page */
+#define CATALOG_CHECKPOINT_INTERVAL (64u)   /* Journal entries between checkpoints */
+#define CATALOG_NO_OWNER    (0xFFu)         /* Sector not used by any recording */
+
+/* Recording flags */
+#define CATALOG_FLAG_MEM_LIMIT (0x01u)      /* Stopped at the maximum record size */
+#define CATALOG_FLAG_RECOVERED (0x02u)      /* Recovered after a power loss */
+#define CATALOG_FLAG_OVERRUN (0x04u)        /* Pages lost while capturing */
+#define CATALOG_FLAG_AGC    (0x08u)         /* Levelled by the automatic gain control */
+#define CATALOG_FLAG_HIGHPASS (0x10u)       /* DC and rumble removed by the high-pass */
+#define CATALOG_FLAG_DENOISE (0x20u)        /* Background noise suppressed */
+
+/* Recording formats, the codec in the low bits and the layout above it. With
+   no layout bit set, the format is mono 16-bit at 8 kHz, as recorded before 
+   the layout bits. See RecordFormatDecode */
+#define RECORD_FORMAT_PCM16 (0u)            /* PCM, as read from the PDM */
+#define RECORD_FORMAT_ADPCM (1u)            /* IMA-ADPCM, one 4-bit block per page */
+#define RECORD_FORMAT_CODEC (0x000Fu)       /* Mask of the codec */
+#define RECORD_FORMAT_STEREO (0x0010u)      /* Left and right interleaved, left first */
+#define RECORD_FORMAT_24BIT (0x0020u)       /* 24-bit samples in 32-bit words */
+#define RECORD_FORMAT_COMPACT (0x0040u)     /* Silent pages not stored, PCM only */
+#define RECORD_FORMAT_RATE  (0x0F00u)       /* Index of the sample rate, 0 for 8 kHz */
+#define RECORD_FORMAT_RATE_POS (8u)         /* Position of the sample rate index */
+
+#endif
+/* [] END OF FILE */
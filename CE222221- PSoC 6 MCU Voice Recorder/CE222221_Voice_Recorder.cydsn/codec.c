@@ -187,6 +187,29 @@ uint32_t Codec_AdjustBothHeadphoneVolume(uint8_t volume)
     return Codec_SendData(CODEC_REG_RCH_DIG_VOL, volume);
 }
 
+/*******************************************************************************
+* Function Name: Codec_SetSamplingRate
+********************************************************************************
+* Summary:
+*   This function sets the sampling rate of the codec. It must match the rate
+*   of the I2S frames, and the MCKI input frequency the clock on AudioClk.
+*
+*
+* Parameters:  
+*	fs - Sampling rate, one of the CODEC_MODE_CTRL2_FS settings, or'ed with
+*        the CODEC_MODE_CTRL2_CM setting of the MCKI frequency
+*
+* Return:
+*   uint32_t - I2C master transaction error status
+*				CY_SCB_I2C_SUCCESS - Operation completed successfully                      
+*				CY_SCB_I2C_MASTER_MANUAL_BUS_ERR - Bus error occurred   
+*
+*******************************************************************************/
+uint32_t Codec_SetSamplingRate(uint8_t fs)
+{
+    return Codec_SendData(CODEC_REG_MODE_CTRL2, fs);
+}
+
 /*******************************************************************************
 * Function Name: Codec_Activate
 ********************************************************************************
@@ -197,6 +197,7 @@
 	uint32_t Codec_Activate(void);
 	uint32_t Codec_Deactivate(void);
 	uint32_t Codec_SendData(uint8_t regAddr, uint8_t data);
+	uint32_t Codec_SetSamplingRate(uint8_t fs);
 	
 #endif /* #ifndef CODEC_H */
 
@@ -0,0 +1,204 @@
+/******************************************************************************
+* File Name: denoise.c
+*
+* Version: 1.0
+*
+* Description: This file contains the spectral subtraction noise suppressor, a
+*              processing stage that learns the background at the capture start
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include <string.h>
+#include "denoise.h"
+
+static void DenoiseFrame(denoise_t *denoise);
+
+/*******************************************************************************
+* Function Name: DenoiseInit
+********************************************************************************
+* Summary:
+*   This function resets a noise suppressor. Its profile is learned again from
+*   the next blocks, and the output starts with a frame of silence.
+*
+* Parameters:
+*   denoise: Suppressor to reset.
+*   enabled: false to leave the blocks unchanged.
+*
+*******************************************************************************/
+void DenoiseInit(denoise_t *denoise, bool enabled)
+{
+    memset(denoise, 0, sizeof(denoise_t));
+    denoise->enabled = enabled;
+}
+
+/*******************************************************************************
+* Function Name: DenoiseProcess
+********************************************************************************
+* Summary:
+*   This function is the process of a noise suppression stage, its state is a
+*   denoise_t. The samples of the block go into the frame being filled, and 
+*   are replaced by the output of the frames already processed. A frame is 
+*   processed each DENOISE_HOP samples, so a page runs one or two of them.
+*
+* Parameters:
+*   stage: Stage run, its state is the suppressor.
+*   block: Block of mono 16-bit samples, processed in place.
+*
+*******************************************************************************/
+void DenoiseProcess(dsp_stage_t *stage, dsp_block_t *block)
+{
+    denoise_t *denoise = (denoise_t *) stage->state;
+    int16_t *samples = (int16_t *) block->samples;
+    uint32_t index;
+    int16_t sample;
+    
+    if (!denoise->enabled || (block->channels != 1u) || (block->sampleSize != sizeof(int16_t)))
+    {
+        return;
+    }
+    
+    /* The learning time in frames, once the rate is known */
+    if (denoise->learnFrames == 0u)
+    {
+        denoise->learnFrames = (DENOISE_LEARN_MS*block->sampleRate) / (1000u*DENOISE_HOP);
+        if (denoise->learnFrames == 0u)
+        {
+            denoise->learnFrames = 1u;
+        }
+    }
+    
+    for (index = 0; index < block->frames; index++)
+    {
+        sample = samples[index];
+        samples[index] = denoise->output[denoise->fill];
+        denoise->input[DENOISE_HOP + denoise->fill] = sample;
+        denoise->fill++;
+        
+        if (denoise->fill == DENOISE_HOP)
+        {
+            DenoiseFrame(denoise);
+            denoise->fill = 0;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: DenoiseFrame
+********************************************************************************
+* Summary:
+*   This function processes the frame of input. While learning, the power of 
+*   each bin is averaged into the noise profile and the frame is left as is. 
+*   Afterwards each bin keeps the share of its power above the profile, times
+*   DENOISE_OVERSUBTRACT, and never less than DENOISE_FLOOR, so the remaining 
+*   noise does not warble. The frame is added to the second half of the last
+*   one, into the next hop of output.
+*
+*******************************************************************************/
+static void DenoiseFrame(denoise_t *denoise)
+{
+    uint64_t power;
+    uint64_t noise;
+    uint32_t gain;
+    uint32_t index;
+    int32_t window;
+    int32_t sample;
+    
+    /* Hann window, the frames half overlapping add up to one */
+    for (index = 0; index < DENOISE_FFT_SIZE; index++)
+    {
+        window = (32768 - DspCos(index*(DSP_FFT_MAX_SIZE/DENOISE_FFT_SIZE))) / 2;
+        denoise->re[index] = (denoise->input[index] * window) >> (15u - DENOISE_HEADROOM);
+        denoise->im[index] = 0;
+    }
+    
+    DspFft(denoise->re, denoise->im, DENOISE_FFT_BITS, false);
+    
+    for (index = 0; index < DENOISE_BINS; index++)
+    {
+        power = (uint64_t) (((int64_t) denoise->re[index] * denoise->re[index]) + 
+                            ((int64_t) denoise->im[index] * denoise->im[index]));
+        
+        if (denoise->frames < denoise->learnFrames)
+        {
+            denoise->noise[index] = ((denoise->noise[index] * denoise->frames) + power) / (denoise->frames + 1u);
+            continue;
+        }
+        
+        noise = denoise->noise[index] * DENOISE_OVERSUBTRACT;
+        gain = (power > noise) ? (uint32_t) (((power - noise) << 15) / power) : 0u;
+        if (gain < DENOISE_FLOOR)
+        {
+            gain = DENOISE_FLOOR;
+        }
+        
+        /* The bins above half the rate mirror the ones below */
+        denoise->re[index] = (int32_t) (((int64_t) denoise->re[index] * gain) >> 15);
+        denoise->im[index] = (int32_t) (((int64_t) denoise->im[index] * gain) >> 15);
+        if ((index != 0u) && (index != (DENOISE_FFT_SIZE/2u)))
+        {
+            denoise->re[DENOISE_FFT_SIZE - index] = (int32_t) (((int64_t) denoise->re[DENOISE_FFT_SIZE - index] * gain) >> 15);
+            denoise->im[DENOISE_FFT_SIZE - index] = (int32_t) (((int64_t) denoise->im[DENOISE_FFT_SIZE - index] * gain) >> 15);
+        }
+    }
+    
+    if (denoise->frames < denoise->learnFrames)
+    {
+        denoise->frames++;
+    }
+    
+    DspFft(denoise->re, denoise->im, DENOISE_FFT_BITS, true);
+    
+    /* Overlap-add into the next hop of output, saturated */
+    for (index = 0; index < DENOISE_HOP; index++)
+    {
+        sample = (denoise->overlap[index] + denoise->re[index]) >> DENOISE_HEADROOM;
+        if (sample > 32767)
+        {
+            sample = 32767;
+        }
+        else if (sample < -32768)
+        {
+            sample = -32768;
+        }
+        
+        denoise->output[index] = (int16_t) sample;
+        denoise->overlap[index] = denoise->re[DENOISE_HOP + index];
+    }
+    
+    /* The newest hop becomes the oldest of the next frame */
+    memmove(denoise->input, &denoise->input[DENOISE_HOP], DENOISE_HOP*sizeof(int16_t));
+}
+
+/* [] END OF FILE */
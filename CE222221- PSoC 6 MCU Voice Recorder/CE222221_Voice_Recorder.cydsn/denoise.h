@@ -0,0 +1,94 @@
+/******************************************************************************
+* File Name: denoise.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the denoise.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef DENOISE_H
+#define DENOISE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp.h"
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+/* Frames of DENOISE_FFT_SIZE samples, Hann windowed, every half frame. The 
+   windows add up to one, so the frames overlap-add back to the samples, 
+   delayed by a frame. Mono 16-bit blocks only, the others are left as is */
+#define DENOISE_FFT_BITS    (DSP_FFT_MAX_BITS) /* Bits of the frame size */
+#define DENOISE_FFT_SIZE    (1u << DENOISE_FFT_BITS) /* Samples of a frame, 256 */
+#define DENOISE_HOP         (DENOISE_FFT_SIZE/2u) /* Samples between two frames */
+#define DENOISE_BINS        ((DENOISE_FFT_SIZE/2u) + 1u) /* Bins up to half the rate */
+#define DENOISE_HEADROOM    (8u)            /* Bits of headroom of the FFT samples */
+#define DENOISE_LEARN_MS    (250u)          /* Noise learned at the start, no speech expected */
+#define DENOISE_OVERSUBTRACT (2u)           /* Noise power subtracted, times the profile */
+#define DENOISE_FLOOR       (3277u)         /* Least gain of a bin, Q15, -20 dB */
+#define DENOISE_BUDGET_CYCLES (120000u)     /* Cycles declared for a page, two frames */
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+/* State of a spectral subtraction noise suppressor, one per path. The noise 
+   power of each bin is averaged over the frames of the first DENOISE_LEARN_MS,
+   the following frames have it subtracted */
+typedef struct denoise
+{
+    bool enabled;                     /* Blocks are left unchanged when false */
+    uint32_t frames;                  /* Frames processed since the reset */
+    uint32_t learnFrames;             /* Frames learning the noise, 0 until the rate is known */
+    uint32_t fill;                    /* Samples of the current hop taken */
+    int16_t input[DENOISE_FFT_SIZE];  /* Last frame of input, the newest hop last */
+    int16_t output[DENOISE_HOP];      /* Hop of output, played out while the next one fills */
+    int32_t overlap[DENOISE_HOP];     /* Second half of the last frame, added to the next */
+    uint64_t noise[DENOISE_BINS];     /* Noise power profile */
+    int32_t re[DENOISE_FFT_SIZE];     /* FFT of the frame */
+    int32_t im[DENOISE_FFT_SIZE];
+} denoise_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void DenoiseInit(denoise_t *denoise, bool enabled);
+void DenoiseProcess(dsp_stage_t *stage, dsp_block_t *block);
+
+#endif
+/* [] END OF FILE */
@@ -0,0 +1,352 @@
+/******************************************************************************
+* File Name: dsp.c
+*
+* Version: 1.0
+*
+* Description: This file contains the chains of fixed-point processing stages
+*              run on the captured and the played pages
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include "dsp.h"
+#include "project.h"
+
+static int32_t DspSin(uint32_t step);
+
+/* Quarter turn of the sine, Q15, by steps of a turn over DSP_FFT_MAX_SIZE */
+static const int16_t dspSine[(DSP_FFT_MAX_SIZE/4u) + 1u] =
+{
+        0,   804,  1608,  2410,  3212,  4011,  4808,  5602,
+     6393,  7179,  7962,  8739,  9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767
+};
+
+/*******************************************************************************
+* Function Name: DspChainInit
+********************************************************************************
+* Summary:
+*   This function empties a chain and starts the cycle counter that measures 
+*   its stages.
+*
+* Parameters:
+*   chain: Chain to reset.
+*   deadlineCycles: Cycles allowed for a block, all stages.
+*
+*******************************************************************************/
+void DspChainInit(dsp_chain_t *chain, uint32_t deadlineCycles)
+{
+    chain->first = NULL;
+    chain->deadlineCycles = deadlineCycles;
+    chain->budgetCycles = 0;
+    DspChainResetStats(chain);
+    
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+/*******************************************************************************
+* Function Name: DspChainSetDeadline
+********************************************************************************
+* Summary:
+*   This function changes the cycles allowed for a block, when the block time 
+*   changes with the format.
+*
+* Parameters:
+*   chain: Chain to update.
+*   deadlineCycles: Cycles allowed for a block, all stages.
+*
+* Return:
+*   bool: false if the stages declare more cycles than the new deadline. The 
+*         blocks over it are then counted in missed.
+*
+*******************************************************************************/
+bool DspChainSetDeadline(dsp_chain_t *chain, uint32_t deadlineCycles)
+{
+    chain->deadlineCycles = deadlineCycles;
+    
+    return (chain->budgetCycles <= deadlineCycles);
+}
+
+/*******************************************************************************
+* Function Name: DspChainAdd
+********************************************************************************
+* Summary:
+*   This function appends a stage to a chain, if its budget fits in what the 
+*   deadline leaves. The stage is linked last, with a single store, so the 
+*   chain may be running meanwhile.
+*
+* Parameters:
+*   chain: Chain to extend.
+*   stage: Stage to append, with its name, process, state and budgetCycles.
+*
+* Return:
+*   bool: false if the budget does not fit, the stage is not added.
+*
+*******************************************************************************/
+bool DspChainAdd(dsp_chain_t *chain, dsp_stage_t *stage)
+{
+    dsp_stage_t **link = &chain->first;
+    
+    if ((chain->budgetCycles + stage->budgetCycles) > chain->deadlineCycles)
+    {
+        return false;
+    }
+    
+    stage->lastCycles = 0;
+    stage->peakCycles = 0;
+    stage->overBudget = 0;
+    stage->next = NULL;
+    
+    while (*link != NULL)
+    {
+        link = &(*link)->next;
+    }
+    
+    chain->budgetCycles += stage->budgetCycles;
+    
+    /* Publish the stage once it is complete */
+    __DMB();
+    *link = stage;
+    
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: DspChainRun
+********************************************************************************
+* Summary:
+*   This function runs the stages of a chain on a block, in order, and counts 
+*   the cycles each one takes. A stage over its budget, or the chain over its 
+*   deadline, is counted, the block is still processed.
+*
+* Parameters:
+*   chain: Chain to run.
+*   block: Block processed in place.
+*
+*******************************************************************************/
+void DspChainRun(dsp_chain_t *chain, dsp_block_t *block)
+{
+    dsp_stage_t *stage = chain->first;
+    uint32_t total = 0;
+    uint32_t start;
+    uint32_t cycles;
+    
+    if (stage == NULL)
+    {
+        return;
+    }
+    
+    while (stage != NULL)
+    {
+        start = DWT->CYCCNT;
+        stage->process(stage, block);
+        cycles = DWT->CYCCNT - start;
+        
+        stage->lastCycles = cycles;
+        if (cycles > stage->peakCycles)
+        {
+            stage->peakCycles = cycles;
+        }
+        if (cycles > stage->budgetCycles)
+        {
+            stage->overBudget++;
+        }
+        
+        total += cycles;
+        stage = stage->next;
+    }
+    
+    chain->lastCycles = total;
+    if (total > chain->peakCycles)
+    {
+        chain->peakCycles = total;
+    }
+    if (total > chain->deadlineCycles)
+    {
+        chain->missed++;
+    }
+    chain->blocks++;
+}
+
+/*******************************************************************************
+* Function Name: DspChainResetStats
+********************************************************************************
+* Summary:
+*   This function clears the cycle statistics of a chain and of its stages.
+*
+*******************************************************************************/
+void DspChainResetStats(dsp_chain_t *chain)
+{
+    dsp_stage_t *stage;
+    
+    for (stage = chain->first; stage != NULL; stage = stage->next)
+    {
+        stage->lastCycles = 0;
+        stage->peakCycles = 0;
+        stage->overBudget = 0;
+    }
+    
+    chain->lastCycles = 0;
+    chain->peakCycles = 0;
+    chain->missed = 0;
+    chain->blocks = 0;
+}
+
+/*******************************************************************************
+* Function Name: DspFft
+********************************************************************************
+* Summary:
+*   This function runs a radix-2 FFT in place, on Q15 samples. The forward FFT
+*   halves the values at each stage, so it never overflows and returns the 
+*   spectrum divided by the size. The inverse FFT does not scale, it returns 
+*   the samples of such a spectrum. The twiddles are Q15, the products are 
+*   taken on 64 bits. Each stage drops a bit, so samples given 8 bits of 
+*   headroom come back within a few steps.
+*
+* Parameters:
+*   re: Real parts, in natural order.
+*   im: Imaginary parts, in natural order, zero for real samples.
+*   bits: Bits of the size, 1 to DSP_FFT_MAX_BITS.
+*   inverse: true for the inverse FFT.
+*
+*******************************************************************************/
+void DspFft(int32_t re[], int32_t im[], uint32_t bits, bool inverse)
+{
+    uint32_t size = 1u << bits;
+    uint32_t shift = inverse ? 0u : 1u;
+    uint32_t index;
+    uint32_t reversed;
+    uint32_t span;
+    uint32_t start;
+    uint32_t step;
+    uint32_t k;
+    uint32_t a;
+    uint32_t b;
+    int32_t cos;
+    int32_t sin;
+    int32_t tr;
+    int32_t ti;
+    int32_t swap;
+    
+    /* Bit-reversed order */
+    for (index = 0; index < size; index++)
+    {
+        reversed = __RBIT(index) >> (32u - bits);
+        if (reversed > index)
+        {
+            swap = re[index];
+            re[index] = re[reversed];
+            re[reversed] = swap;
+            swap = im[index];
+            im[index] = im[reversed];
+            im[reversed] = swap;
+        }
+    }
+    
+    /* Butterflies of spans 1, 2, 4... the twiddle steps shrink as they grow */
+    for (span = 1u; span < size; span <<= 1)
+    {
+        step = DSP_FFT_MAX_SIZE / (span*2u);
+        
+        for (k = 0; k < span; k++)
+        {
+            cos = DspCos(k*step);
+            sin = inverse ? DspSin(k*step) : -DspSin(k*step);
+            
+            for (start = k; start < size; start += span*2u)
+            {
+                a = start;
+                b = start + span;
+                
+                tr = (int32_t) ((((int64_t) cos * re[b]) - ((int64_t) sin * im[b])) >> 15);
+                ti = (int32_t) ((((int64_t) cos * im[b]) + ((int64_t) sin * re[b])) >> 15);
+                
+                re[b] = (re[a] - tr) >> shift;
+                im[b] = (im[a] - ti) >> shift;
+                re[a] = (re[a] + tr) >> shift;
+                im[a] = (im[a] + ti) >> shift;
+            }
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: DspCos
+********************************************************************************
+* Summary:
+*   Return the cosine of a number of steps of a turn over DSP_FFT_MAX_SIZE.
+*
+* Parameters:
+*   step: Angle in steps, taken modulo a turn.
+*
+* Return:
+*   int32_t: Cosine, Q15.
+*
+*******************************************************************************/
+int32_t DspCos(uint32_t step)
+{
+    return DspSin(step + (DSP_FFT_MAX_SIZE/4u));
+}
+
+/* Sine of a number of steps, from the quarter turn in the table */
+static int32_t DspSin(uint32_t step)
+{
+    uint32_t quarter = DSP_FFT_MAX_SIZE/4u;
+    
+    step %= DSP_FFT_MAX_SIZE;
+    
+    if (step <= quarter)
+    {
+        return dspSine[step];
+    }
+    if (step <= (2u*quarter))
+    {
+        return dspSine[(2u*quarter) - step];
+    }
+    if (step <= (3u*quarter))
+    {
+        return -dspSine[step - (2u*quarter)];
+    }
+    
+    return -dspSine[(4u*quarter) - step];
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,116 @@
+/******************************************************************************
+* File Name: dsp.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the dsp.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef DSP_H
+#define DSP_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+/* Block of samples handed to the stages, one page of frames. The samples are
+   fixed-point, the channels interleaved */
+typedef struct dsp_block
+{
+    void *samples;                    /* First sample, int16_t or int32_t */
+    uint32_t frames;                  /* Frames in the block */
+    uint32_t channels;                /* 1, or 2 left first */
+    uint32_t sampleSize;              /* sizeof(int16_t), or sizeof(int32_t) for 24-bit */
+    uint32_t sampleRate;              /* Frames per second */
+} dsp_block_t;
+
+struct dsp_stage;
+
+/* Processes a block in place */
+typedef void (*dsp_process_t)(struct dsp_stage *stage, dsp_block_t *block);
+
+/* Stage of a chain. The owner fills name, process, state and budgetCycles, 
+   the chain measures the rest */
+typedef struct dsp_stage
+{
+    const char *name;                 /* Name of the stage */
+    dsp_process_t process;            /* Processing of a block */
+    void *state;                      /* State of the stage, for process */
+    uint32_t budgetCycles;            /* Cycles declared for a block */
+    uint32_t lastCycles;              /* Cycles of the last block */
+    uint32_t peakCycles;              /* Most cycles of a block */
+    uint32_t overBudget;              /* Blocks over the budget */
+    struct dsp_stage *next;           /* Next stage, NULL for the last one */
+} dsp_stage_t;
+
+/* Chain of stages run on each block of a path. The deadline is the share of 
+   a block time the chain may take */
+typedef struct dsp_chain
+{
+    dsp_stage_t *first;               /* First stage, NULL if empty */
+    uint32_t deadlineCycles;          /* Cycles allowed for a block */
+    uint32_t budgetCycles;            /* Cycles declared by the stages */
+    uint32_t lastCycles;              /* Cycles of the last block, all stages */
+    uint32_t peakCycles;              /* Most cycles of a block, all stages */
+    uint32_t missed;                  /* Blocks over the deadline */
+    uint32_t blocks;                  /* Blocks processed */
+} dsp_chain_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void DspChainInit(dsp_chain_t *chain, uint32_t deadlineCycles);
+bool DspChainSetDeadline(dsp_chain_t *chain, uint32_t deadlineCycles);
+bool DspChainAdd(dsp_chain_t *chain, dsp_stage_t *stage);
+void DspChainRun(dsp_chain_t *chain, dsp_block_t *block);
+void DspChainResetStats(dsp_chain_t *chain);
+void DspFft(int32_t re[], int32_t im[], uint32_t bits, bool inverse);
+int32_t DspCos(uint32_t step);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+/* Fixed-point FFT, sized for the samples of a page. The angles step by a turn
+   over DSP_FFT_MAX_SIZE, the twiddles are Q15 */
+#define DSP_FFT_MAX_BITS    (8u)            /* Bits of the largest FFT size */
+#define DSP_FFT_MAX_SIZE    (1u << DSP_FFT_MAX_BITS) /* Largest FFT size, 256 points */
+
+#endif
+/* [] END OF FILE */
@@ -63,6 +63,7 @@ void EventsTask(void *arg)
     uint32_t graphics_event;
     recorder_states_t  state;
     int32_t volume = CODEC_HP_DEFAULT_VOLUME;
+    uint8_t position;
     
     (void) arg;
         
@@ -107,23 +108,23 @@ void EventsTask(void *arg)
                 
                     /* This button is the recording button */
                 
-                    /* If already recording, stop recording */
+                    /* If already recording, stop recording, a record played meanwhile goes on */
                     if (state == RECORDING)
                     {       
-                        graphics_event = SHOW_STOP;
-                        xQueueSend(GUIQueue, &graphics_event, 0);
-                        
                         StopRecorder();
+                        
+                        graphics_event = (RecorderState() == PLAYING) ? SHOW_PLAYING : SHOW_STOP;
+                        xQueueSend(GUIQueue, &graphics_event, 0);
                     }
-                    /* If playing or pause, reset the recorder */
-                    else if ((state == PLAYING) || (state == PAUSED))
+                    /* If paused, or playing without full duplex, reset the recorder */
+                    else if (((state == PLAYING) && (RECORD_DUPLEX == 0u)) || (state == PAUSED))
                     {
                         graphics_event = SHOW_STOP;
                         xQueueSend(GUIQueue, &graphics_event, 0);
                         
                         ResetRecorder();
                     }
-                    /* In any other state, start recording */
+                    /* In any other state, start recording, the record playing goes on */
                     else
                     {
                         graphics_event = SHOW_RECORDING;
@@ -151,7 +152,7 @@ void EventsTask(void *arg)
                         xQueueSend(GUIQueue, &graphics_event, 0);
                         
                         StopRecorder();
-                        PlayRecorder();
+                        PlayRecorder(CatalogLatest());
                     }
                     /* If playing, pause the playing */
                     else if (state == PLAYING)
@@ -175,7 +176,7 @@ void EventsTask(void *arg)
                         graphics_event = SHOW_PLAYING;
                         xQueueSend(GUIQueue, &graphics_event, 0);
                         
-                        PlayRecorder();
+                        PlayRecorder(CatalogLatest());
                     }                                       
                     
                     break;
@@ -183,6 +184,12 @@ void EventsTask(void *arg)
                     
                     /* This action decrease the speaker volume */
                     
+                    /* While paused, the slider scrubs through the record */
+                    if (state == PAUSED)
+                    {
+                        break;
+                    }
+                    
                     volume += EVENT_VOLUME_STEP;
                     
                     if (volume >= CODEC_HP_MUTE_VALUE)
@@ -199,6 +206,12 @@ void EventsTask(void *arg)
                     
                     /* This action increase the speaker volume */
                     
+                    /* While paused, the slider scrubs through the record */
+                    if (state == PAUSED)
+                    {
+                        break;
+                    }
+                    
                     volume -= EVENT_VOLUME_STEP;
                     
                     if (volume < CODEC_HP_VOLUME_MAX)
@@ -214,18 +227,36 @@ void EventsTask(void *arg)
                 
                 /* Recorder Events */
                 case PLAY_COMPLETED:
-                    graphics_event = SHOW_STOP;
-                    xQueueSend(GUIQueue, &graphics_event, 0);
+                    /* The recording goes on after a record played meanwhile */
+                    if (state != RECORDING)
+                    {
+                        graphics_event = SHOW_STOP;
+                        xQueueSend(GUIQueue, &graphics_event, 0);
+                    }
                     break;
                     
                 case REACH_MEM_LIMIT:
-                    graphics_event = SHOW_STOP;
+                    graphics_event = (state == PLAYING) ? SHOW_PLAYING : SHOW_STOP;
                     xQueueSend(GUIQueue, &graphics_event, 0);
                     
                     graphics_event = SHOW_WARNING;
                     xQueueSend(GUIQueue, &graphics_event, 0);
                     break;
                     
+                case SLIDER_POSITION:
+                    /* Read the latest position in any state, the next move sends a new event */
+                    position = TouchSliderPosition();
+                    
+                    /* Scrub through a paused record, the slider spans the whole record */
+                    if (state == PAUSED)
+                    {
+                        SeekRecorder((uint32_t) (((uint64_t) RecorderLength() * position) / TOUCH_SLIDER_MAX));
+                        
+                        graphics_event = SHOW_TIMER | (RecorderPosition() / 1000u);
+                        xQueueSend(GUIQueue, &graphics_event, 0);
+                    }
+                    break;
+                    
                 default:
                     break;
             }
@@ -135,6 +135,66 @@ static void GraphicsDrawWarningMessage(bool show)
     }
 }
 
+/* Draw the time taken to mount the catalog, in 0.1 ms */
+static void GraphicsDrawMountTime(uint32_t time)
+{
+    char string[TEXT_BUFFER_SIZE*3];
+    
+    UG_SetForecolor(C_WHITE);
+    
+    sprintf(string, "Mount: %u.%u ms", (uint16_t) (time / 10), (uint8_t) (time % 10));
+    
+    UG_PutString(0,0,string);
+}
+
+/* Draw a flash benchmark result on its own line, from kB/s */
+static void GraphicsDrawBenchmark(uint32_t line, const char *name, uint32_t rate)
+{
+    char string[TEXT_BUFFER_SIZE*3];
+    
+    UG_SetForecolor(C_WHITE);
+    
+    sprintf(string, "%-8s%2u.%03u MB/s", name, (uint16_t) (rate / 1000u), (uint16_t) (rate % 1000u));
+    
+    UG_PutString(0, TEXT_SIZE.char_height*line, string);
+}
+
+/* Draw the CPU cost of a SMIF data transport, in cycles per page */
+static void GraphicsDrawXferCost(uint32_t line, const char *name, uint32_t cycles)
+{
+    char string[TEXT_BUFFER_SIZE*3];
+    
+    UG_SetForecolor(C_WHITE);
+    
+    sprintf(string, "%-8s%5u cyc/pg", name, (uint16_t) cycles);
+    
+    UG_PutString(0, TEXT_SIZE.char_height*line, string);
+}
+
+/* Draw the peak occupancy of the capture pool, over the pages chained */
+static void GraphicsDrawPool(uint32_t peak, uint32_t depth)
+{
+    char string[TEXT_BUFFER_SIZE*3];
+    
+    UG_SetForecolor(C_WHITE);
+    
+    sprintf(string, "Pool: %2u/%2u pages", (uint8_t) peak, (uint8_t) depth);
+    
+    UG_PutString(0, TEXT_SIZE.char_height*4u, string);
+}
+
+/* Draw the peak load of the capture processing, in percent of the page time */
+static void GraphicsDrawDspLoad(uint32_t load, uint32_t rateKhz)
+{
+    char string[TEXT_BUFFER_SIZE*3];
+    
+    UG_SetForecolor(C_WHITE);
+    
+    sprintf(string, "DSP: %3u%% at %2u kHz", (uint8_t) load, (uint8_t) rateKhz);
+    
+    UG_PutString(0, TEXT_SIZE.char_height*5u, string);
+}
+
 /* Draw the current recording/playing time */
 static void GraphicsUpdateTime(uint32_t time)
 {
@@ -213,6 +273,42 @@ void GraphicsTask(void *arg)
                     {
                         GraphicsUpdateTime(CY_LO16(event));
                     }
+                    /* Show the catalog mount time, until the first warning update */
+                    else if ((event & GUI_EVENT_MASK) == SHOW_MOUNT_TIME)
+                    {
+                        GraphicsDrawMountTime(CY_LO16(event));
+                    }
+                    /* Flash benchmark results, below the mount time */
+                    else if ((event & GUI_EVENT_MASK) == SHOW_BENCH_ERASE)
+                    {
+                        GraphicsDrawBenchmark(1u, "Erase", CY_LO16(event));
+                    }
+                    else if ((event & GUI_EVENT_MASK) == SHOW_BENCH_PROGRAM)
+                    {
+                        GraphicsDrawBenchmark(2u, "Program", CY_LO16(event));
+                    }
+                    else if ((event & GUI_EVENT_MASK) == SHOW_BENCH_READ)
+                    {
+                        GraphicsDrawBenchmark(3u, "Read", CY_LO16(event));
+                    }
+                    else if ((event & GUI_EVENT_MASK) == SHOW_BENCH_ISR)
+                    {
+                        GraphicsDrawXferCost(4u, "SMIF ISR", CY_LO16(event));
+                    }
+                    else if ((event & GUI_EVENT_MASK) == SHOW_BENCH_DMA)
+                    {
+                        GraphicsDrawXferCost(5u, "SMIF DMA", CY_LO16(event));
+                    }
+                    /* Capture pool occupancy, peak in the high byte */
+                    else if ((event & GUI_EVENT_MASK) == SHOW_TX_POOL)
+                    {
+                        GraphicsDrawPool(CY_HI8(CY_LO16(event)), CY_LO8(event));
+                    }
+                    /* Capture processing load, percent in the high byte, rate in kHz */
+                    else if ((event & GUI_EVENT_MASK) == SHOW_DSP_LOAD)
+                    {
+                        GraphicsDrawDspLoad(CY_HI8(CY_LO16(event)), CY_LO8(event));
+                    }
                     break;
             }
         }
@@ -61,6 +61,14 @@
         SHOW_VOLUME_TXT = 0x30000007u,
         SHOW_VOLUME_VAL = 0x30010000u,
         SHOW_TIMER      = 0x30020000u,
+        SHOW_MOUNT_TIME = 0x30030000u,
+        SHOW_BENCH_ERASE   = 0x30040000u,
+        SHOW_BENCH_PROGRAM = 0x30050000u,
+        SHOW_BENCH_READ    = 0x30060000u,
+        SHOW_TX_POOL       = 0x30070000u,
+        SHOW_DSP_LOAD      = 0x30080000u,
+        SHOW_BENCH_ISR     = 0x30090000u,
+        SHOW_BENCH_DMA     = 0x300A0000u,
     }   gui_events_t;
     
     #define GUI_ICON_SIZE           25u         /* Size of the icons */
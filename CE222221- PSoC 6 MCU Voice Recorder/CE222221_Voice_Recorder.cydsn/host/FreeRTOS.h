@@ -0,0 +1,87 @@
+/******************************************************************************
+* File Name: FreeRTOS.h
+*
+* Version: 1.0
+*
+* Description: Host replacement of the FreeRTOS configuration and base types,
+*              run by the cooperative scheduler of rtos_host.c.
+*
+* Related Document: N/A
+*
+* Hardware Dependency: None, built for a Linux host
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+#ifndef __HOST_FREERTOS_H
+#define __HOST_FREERTOS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "FreeRTOSConfig.h"
+
+/*******************************************************************************
+*            Port types, as the CM4 port of FreeRTOS V9.0.0
+*******************************************************************************/
+typedef long BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define portMAX_DELAY               ((TickType_t) 0xFFFFFFFFul)
+#define portTICK_PERIOD_MS          ((TickType_t) 1000u / configTICK_RATE_HZ)
+#define pdMS_TO_TICKS(xTimeInMs)    ((TickType_t) (((TickType_t) (xTimeInMs) * (TickType_t) configTICK_RATE_HZ) / (TickType_t) 1000u))
+
+#define pdFALSE                     ((BaseType_t) 0)
+#define pdTRUE                      ((BaseType_t) 1)
+#define pdPASS                      (pdTRUE)
+#define pdFAIL                      (pdFALSE)
+#define errQUEUE_EMPTY              ((BaseType_t) 0)
+#define errQUEUE_FULL               ((BaseType_t) 0)
+
+#define tskIDLE_PRIORITY            ((UBaseType_t) 0u)
+
+/*******************************************************************************
+*            Critical sections and yields, see rtos_host.c
+*******************************************************************************/
+void HostEnterCritical(void);
+void HostExitCritical(void);
+void HostYieldFromIsr(BaseType_t higherPriorityTaskWoken);
+
+#define taskENTER_CRITICAL()        HostEnterCritical()
+#define taskEXIT_CRITICAL()         HostExitCritical()
+#define taskDISABLE_INTERRUPTS()    HostEnterCritical()
+#define taskENABLE_INTERRUPTS()     HostExitCritical()
+#define portYIELD_FROM_ISR(x)       HostYieldFromIsr(x)
+
+#endif /* __HOST_FREERTOS_H */
+
+/* [] END OF FILE */
@@ -0,0 +1,783 @@
+/******************************************************************************
+* File Name: audio_host.c
+*
+* Version: 1.0
+*
+* Description: PDM, I2S and DMA model for the host. The DMA completes a page
+*              at the rate set by the audio clocks; the PDM feeds a tone and
+*              the I2S keeps the played samples for the check.
+*
+* Related Document: N/A
+*
+* Hardware Dependency: None, built for a Linux host
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host.h"
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+
+/* A DataWire channel, one descriptor runs at the pace of its peripheral */
+typedef struct
+{
+    uint32_t            channel;    /* Channel of DW0 */
+    IRQn_Type           irq;        /* Interrupt of the channel */
+    bool                enabled;    /* Cy_DMA_Channel_Enable */
+    bool                running;    /* Descriptor in progress, completion scheduled */
+    uint32_t            generation; /* Cancels the completion of a stopped descriptor */
+    uint64_t            startNs;    /* Start of the descriptor, or of its rest */
+    uint64_t            endNs;      /* Completion of the descriptor */
+    uint32_t            rate;       /* Frames per second of the descriptor */
+    uint8_t             *snapshot;  /* Source of a play descriptor, read at its start */
+    uint32_t            snapshotSize;
+}   audio_channel_t;
+
+/*******************************************************************************
+*            Local Functions
+*******************************************************************************/
+static void AudioHostKick(audio_channel_t *chan);
+static void AudioHostPause(audio_channel_t *chan);
+static void AudioHostDone(void *arg);
+static bool AudioHostActive(const audio_channel_t *chan);
+static uint32_t AudioHostRate(const audio_channel_t *chan);
+static uint32_t DescrFrames(const cy_stc_dma_descriptor_config_t *config, uint32_t channel);
+static uint32_t DescrSourceSize(const cy_stc_dma_descriptor_config_t *config);
+static void CapturePage(const cy_stc_dma_descriptor_config_t *config);
+static void PlayPage(audio_channel_t *chan, const cy_stc_dma_descriptor_config_t *config);
+static int32_t ToneSample(uint32_t frame, uint32_t rate);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define AUDIO_RECORD_CHANNEL    (0u)        /* DMA_Record_DW_CHANNEL */
+#define AUDIO_PLAY_CHANNEL      (1u)        /* DMA_PlayRight_DW_CHANNEL */
+#define AUDIO_TONE_HZ           (440.0)     /* Tone of the bursts */
+#define AUDIO_TONE_LEVEL        (8000.0)    /* Peak of the tone, 16-bit */
+#define AUDIO_NOISE_LEVEL       (64u)       /* Peak to peak of the background noise */
+#define AUDIO_DEF_ON_MS         (600u)      /* Tone bursts, then silence */
+#define AUDIO_DEF_OFF_MS        (400u)
+#define AUDIO_PI                (3.14159265358979323846)
+
+/*******************************************************************************
+*            Internal Global Variables
+*******************************************************************************/
+DW_Type hostDw0;
+I2S_Type hostI2s;
+PDM_Type hostPdm;
+
+/* Generated settings of the design */
+const cy_stc_sysint_t DMA_PDM_IRQ_cfg = { .intrSrc = DMA_PDM_IRQn, .intrPriority = 7u };
+const cy_stc_sysint_t DMA_I2S_IRQ_cfg = { .intrSrc = DMA_I2S_IRQn, .intrPriority = 7u };
+
+const cy_stc_i2s_config_t I2S_config =
+{
+    .txEnabled = true,
+    .rxEnabled = false,
+    .clkDiv = 7u,
+    .txChannelLength = CY_I2S_LEN16,
+    .txWordLength = CY_I2S_LEN16,
+};
+
+const cy_stc_pdm_pcm_config_t PDM_PCM_config =
+{
+    .clkDiv = CY_PDM_PCM_CLK_DIV_1_4,
+    .mclkDiv = CY_PDM_PCM_CLK_DIV_BYPASS,
+    .ckoDiv = 3u,
+    .sincDecRate = 64u,
+    .chanSelect = CY_PDM_PCM_OUT_CHAN_LEFT,
+    .wordLen = CY_PDM_PCM_WLEN_16_BIT,
+    .signExtension = true,
+};
+
+cy_stc_dma_descriptor_t DMA_Record_PDM_to_SRAM;
+const cy_stc_dma_descriptor_config_t DMA_Record_PDM_to_SRAM_config =
+{
+    .retrigger = CY_DMA_RETRIG_IM,
+    .interruptType = CY_DMA_X_LOOP,
+    .triggerOutType = CY_DMA_1ELEMENT,
+    .channelState = CY_DMA_CHANNEL_ENABLED,
+    .triggerInType = CY_DMA_1ELEMENT,
+    .dataSize = CY_DMA_HALFWORD,
+    .srcTransferSize = CY_DMA_TRANSFER_SIZE_WORD,
+    .dstTransferSize = CY_DMA_TRANSFER_SIZE_DATA,
+    .descriptorType = CY_DMA_2D_TRANSFER,
+    .srcAddress = NULL,
+    .dstAddress = NULL,
+    .srcXincrement = 0,
+    .dstXincrement = 1,
+    .xCount = 256u,
+    .srcYincrement = 0,
+    .dstYincrement = 256,
+    .yCount = 1u,
+    .nextDescriptor = &DMA_Record_PDM_to_SRAM,
+};
+
+cy_stc_dma_descriptor_t DMA_PlayRight_SRAM_to_I2S;
+const cy_stc_dma_descriptor_config_t DMA_PlayRight_SRAM_to_I2S_config =
+{
+    .retrigger = CY_DMA_RETRIG_IM,
+    .interruptType = CY_DMA_X_LOOP,
+    .triggerOutType = CY_DMA_1ELEMENT,
+    .channelState = CY_DMA_CHANNEL_ENABLED,
+    .triggerInType = CY_DMA_1ELEMENT,
+    .dataSize = CY_DMA_HALFWORD,
+    .srcTransferSize = CY_DMA_TRANSFER_SIZE_DATA,
+    .dstTransferSize = CY_DMA_TRANSFER_SIZE_WORD,
+    .descriptorType = CY_DMA_1D_TRANSFER,
+    .srcAddress = NULL,
+    .dstAddress = NULL,
+    .srcXincrement = 1,
+    .dstXincrement = 0,
+    .xCount = 256u,
+    .srcYincrement = 0,
+    .dstYincrement = 0,
+    .yCount = 1u,
+    .nextDescriptor = &DMA_PlayRight_SRAM_to_I2S,
+};
+
+audio_channel_t audioRecord = { .channel = AUDIO_RECORD_CHANNEL, .irq = DMA_PDM_IRQn };
+audio_channel_t audioPlay = { .channel = AUDIO_PLAY_CHANNEL, .irq = DMA_I2S_IRQn };
+cy_stc_dma_descriptor_t *audioDescr[2];     /* Current descriptor of each channel */
+audio_host_stats_t audioStats;              /* Counters */
+
+cy_stc_pdm_pcm_config_t pdmConfig;          /* Settings of the PDM/PCM */
+bool pdmEnabled = false;
+cy_stc_i2s_config_t i2sConfig;              /* Settings of the I2S */
+bool i2sStarted = false;
+bool pllEnabled = true;                     /* Audio PLL, as generated */
+uint32_t pllOutputHz = 16384000u;
+
+uint32_t toneOnMs = AUDIO_DEF_ON_MS;        /* Captured signal */
+uint32_t toneOffMs = AUDIO_DEF_OFF_MS;
+uint32_t captureFrame = 0;                  /* Frames captured since the start */
+uint32_t captureHeld = 0;                   /* Pages captured without interrupt */
+uint32_t noiseSeed = 12345u;
+
+int16_t *playedSamples = NULL;              /* Left samples played */
+uint32_t playedFrames = 0;
+uint32_t playedCapacity = 0;
+
+/*******************************************************************************
+* Function Name: AudioHostTone
+********************************************************************************
+* Summary:
+*   This function sets the signal of the microphones: bursts of a tone over a
+*   low noise, then the noise alone.
+*
+* Parameters:
+*   onMs: Length of a burst.
+*   offMs: Silence between the bursts.
+*
+*******************************************************************************/
+void AudioHostTone(uint32_t onMs, uint32_t offMs)
+{
+    toneOnMs = onMs;
+    toneOffMs = offMs;
+}
+
+/*******************************************************************************
+* Function Name: AudioHostHoldCapture
+********************************************************************************
+* Summary:
+*   This function holds the interrupt of the record DMA for a number of pages, 
+*   as a long critical section would. The page after them interrupts for all.
+*
+* Parameters:
+*   pages: Pages completed without interrupt.
+*
+*******************************************************************************/
+void AudioHostHoldCapture(uint32_t pages)
+{
+    captureHeld = pages;
+}
+
+/*******************************************************************************
+* Function Name: AudioHostStats
+********************************************************************************
+* Summary:
+*   Return the counters of the audio blocks.
+*
+*******************************************************************************/
+const audio_host_stats_t * AudioHostStats(void)
+{
+    return &audioStats;
+}
+
+/*******************************************************************************
+* Function Name: AudioHostPlayed
+********************************************************************************
+* Summary:
+*   Return the samples sent to the left channel of the I2S since the last
+*   reset, 16-bit words as is and the upper half of the 32-bit ones.
+*
+* Parameters:
+*   frames: Number of samples returned.
+*
+*******************************************************************************/
+const int16_t * AudioHostPlayed(uint32_t *frames)
+{
+    *frames = playedFrames;
+
+    return playedSamples;
+}
+
+void AudioHostPlayedReset(void)
+{
+    playedFrames = 0;
+}
+
+/*******************************************************************************
+*            DMA
+*******************************************************************************/
+cy_en_dma_status_t Cy_DMA_Descriptor_Init(cy_stc_dma_descriptor_t *descriptor,
+                    cy_stc_dma_descriptor_config_t const *config)
+{
+    if ((descriptor == NULL) || (config == NULL))
+    {
+        return CY_DMA_BAD_PARAM;
+    }
+
+    descriptor->config = *config;
+
+    return CY_DMA_SUCCESS;
+}
+
+/* The channels of DW1 only keep their registers, smif_host.c runs them */
+void Cy_DMA_Channel_SetDescriptor(DW_Type *base, uint32_t channel, cy_stc_dma_descriptor_t const *descriptor)
+{
+    if (base == &hostDw0)
+    {
+        audioDescr[channel] = (cy_stc_dma_descriptor_t *) descriptor;
+    }
+    base->CH_STRUCT[channel].CH_CURR_PTR = (uintptr_t) descriptor;
+}
+
+cy_stc_dma_descriptor_t * Cy_DMA_Channel_GetCurrentDescriptor(DW_Type const *base, uint32_t channel)
+{
+    if (base == &hostDw0)
+    {
+        return audioDescr[channel];
+    }
+
+    return (cy_stc_dma_descriptor_t *) base->CH_STRUCT[channel].CH_CURR_PTR;
+}
+
+void Cy_DMA_Channel_Enable(DW_Type *base, uint32_t channel)
+{
+    audio_channel_t *chan = (channel == AUDIO_RECORD_CHANNEL) ? &audioRecord : &audioPlay;
+
+    base->CH_STRUCT[channel].CH_CTL |= DW_CH_STRUCT_CH_CTL_ENABLED_Msk;
+    if (base == &hostDw0)
+    {
+        chan->enabled = true;
+        AudioHostKick(chan);
+    }
+}
+
+/* The position in the descriptor is kept in CH_IDX, as the DataWire does */
+void Cy_DMA_Channel_Disable(DW_Type *base, uint32_t channel)
+{
+    audio_channel_t *chan = (channel == AUDIO_RECORD_CHANNEL) ? &audioRecord : &audioPlay;
+
+    base->CH_STRUCT[channel].CH_CTL &= ~DW_CH_STRUCT_CH_CTL_ENABLED_Msk;
+    if (base == &hostDw0)
+    {
+        AudioHostPause(chan);
+        chan->enabled = false;
+    }
+}
+
+cy_en_dma_status_t Cy_DMA_Channel_Init(DW_Type *base, uint32_t channel, cy_stc_dma_channel_config_t const *config)
+{
+    if ((config == NULL) || (config->descriptor == NULL) || (channel >= 16u))
+    {
+        return CY_DMA_BAD_PARAM;
+    }
+
+    Cy_DMA_Channel_SetDescriptor(base, channel, config->descriptor);
+    if (config->enable)
+    {
+        Cy_DMA_Channel_Enable(base, channel);
+    }
+
+    return CY_DMA_SUCCESS;
+}
+
+void Cy_DMA_Channel_SetInterruptMask(DW_Type *base, uint32_t channel, uint32_t interrupt)
+{
+    base->CH_STRUCT[channel].INTR_MASK = interrupt;
+}
+
+void Cy_DMA_Enable(DW_Type *base)
+{
+    base->CTL |= DW_CTL_ENABLED_Msk;
+}
+
+void Cy_DMA_Channel_ClearInterrupt(DW_Type *base, uint32_t channel)
+{
+    (void) base;
+    (void) channel;
+}
+
+void DMA_Record_Init(void)
+{
+    (void) Cy_DMA_Descriptor_Init(&DMA_Record_PDM_to_SRAM, &DMA_Record_PDM_to_SRAM_config);
+    Cy_DMA_Channel_SetDescriptor(DMA_Record_HW, DMA_Record_DW_CHANNEL, &DMA_Record_PDM_to_SRAM);
+    DMA_Record_HW->CH_STRUCT[DMA_Record_DW_CHANNEL].CH_IDX = 0u;
+}
+
+void DMA_Record_SetInterruptMask(uint32_t interrupt)
+{
+    (void) interrupt;
+}
+
+void DMA_PlayRight_Init(void)
+{
+    (void) Cy_DMA_Descriptor_Init(&DMA_PlayRight_SRAM_to_I2S, &DMA_PlayRight_SRAM_to_I2S_config);
+    Cy_DMA_Channel_SetDescriptor(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL, &DMA_PlayRight_SRAM_to_I2S);
+    DMA_PlayRight_HW->CH_STRUCT[DMA_PlayRight_DW_CHANNEL].CH_IDX = 0u;
+}
+
+void DMA_PlayRight_SetInterruptMask(uint32_t interrupt)
+{
+    (void) interrupt;
+}
+
+/*******************************************************************************
+*            I2S and PDM/PCM
+*******************************************************************************/
+cy_en_i2s_status_t Cy_I2S_Init(I2S_Type *base, cy_stc_i2s_config_t const *config)
+{
+    (void) base;
+
+    if (i2sStarted)
+    {
+        return CY_I2S_BAD_PARAM;
+    }
+    i2sConfig = *config;
+
+    return CY_I2S_SUCCESS;
+}
+
+void Cy_I2S_DeInit(I2S_Type *base)
+{
+    (void) base;
+}
+
+void I2S_Start(void)
+{
+    i2sStarted = true;
+    AudioHostKick(&audioPlay);
+}
+
+void I2S_Stop(void)
+{
+    AudioHostPause(&audioPlay);
+    i2sStarted = false;
+}
+
+cy_en_pdm_pcm_status_t Cy_PDM_PCM_Init(PDM_Type *base, cy_stc_pdm_pcm_config_t const *config)
+{
+    (void) base;
+
+    if (pdmEnabled)
+    {
+        return CY_PDM_PCM_BAD_PARAM;
+    }
+    pdmConfig = *config;
+
+    return CY_PDM_PCM_SUCCESS;
+}
+
+void Cy_PDM_PCM_DeInit(PDM_Type *base)
+{
+    (void) base;
+}
+
+void Cy_PDM_PCM_Enable(PDM_Type *base)
+{
+    (void) base;
+
+    pdmEnabled = true;
+    AudioHostKick(&audioRecord);
+}
+
+void Cy_PDM_PCM_Disable(PDM_Type *base)
+{
+    (void) base;
+
+    AudioHostPause(&audioRecord);
+    pdmEnabled = false;
+}
+
+void Cy_PDM_PCM_ClearFifo(PDM_Type *base)
+{
+    (void) base;
+}
+
+/*******************************************************************************
+*            Clocks and codec
+*******************************************************************************/
+cy_en_sysclk_status_t Cy_SysClk_PllDisable(uint32_t clkPath)
+{
+    (void) clkPath;
+
+    pllEnabled = false;
+
+    return CY_SYSCLK_SUCCESS;
+}
+
+cy_en_sysclk_status_t Cy_SysClk_PllConfigure(uint32_t clkPath, const cy_stc_pll_config_t *config)
+{
+    (void) clkPath;
+
+    if (pllEnabled || (config->inputFreq == 0u))
+    {
+        return CY_SYSCLK_BAD_PARAM;
+    }
+    pllOutputHz = config->outputFreq;
+
+    return CY_SYSCLK_SUCCESS;
+}
+
+cy_en_sysclk_status_t Cy_SysClk_PllEnable(uint32_t clkPath, uint32_t timeoutus)
+{
+    (void) clkPath;
+    (void) timeoutus;
+
+    pllEnabled = true;
+
+    return CY_SYSCLK_SUCCESS;
+}
+
+/* A bypassed path reports no frequency */
+uint32_t Cy_SysClk_ClkPathGetFrequency(uint32_t clkPath)
+{
+    (void) clkPath;
+
+    return pllEnabled ? pllOutputHz : 0u;
+}
+
+cy_en_sysclk_status_t Cy_SysClk_ClkHfSetDivider(uint32_t clkHf, cy_en_clkhf_dividers_t divider)
+{
+    (void) clkHf;
+    (void) divider;
+
+    return CY_SYSCLK_SUCCESS;
+}
+
+/* The codec is on I2C, the host has none */
+uint32_t Codec_SetSamplingRate(uint8_t fs)
+{
+    (void) fs;
+
+    return 0u;
+}
+
+/* Start the descriptor of an enabled channel, if its peripheral runs */
+static void AudioHostKick(audio_channel_t *chan)
+{
+    const cy_stc_dma_descriptor_config_t *config;
+    DW_CH_STRUCT_Type *regs = &hostDw0.CH_STRUCT[chan->channel];
+    uint64_t nowNs = HostTimeUs() * 1000u;
+    uint32_t frames;
+
+    if (chan->running || !AudioHostActive(chan))
+    {
+        return;
+    }
+
+    chan->rate = AudioHostRate(chan);
+    if (chan->rate == 0u)
+    {
+        return;
+    }
+
+    config = &audioDescr[chan->channel]->config;
+    frames = DescrFrames(config, chan->channel);
+    if (regs->CH_IDX >= frames)
+    {
+        regs->CH_IDX = 0u;
+    }
+
+    /* Back to back with the previous descriptor, unless the channel was stopped */
+    if (chan->endNs < nowNs)
+    {
+        chan->endNs = nowNs;
+    }
+    chan->startNs = chan->endNs;
+    chan->endNs = chan->startNs + ((uint64_t) (frames - regs->CH_IDX) * 1000000000u) / chan->rate;
+    chan->running = true;
+    chan->generation++;
+
+    /* The play DMA must find the page ready when it starts on it */
+    if (chan->channel == AUDIO_PLAY_CHANNEL)
+    {
+        chan->snapshotSize = DescrSourceSize(config);
+        chan->snapshot = realloc(chan->snapshot, chan->snapshotSize);
+        memcpy(chan->snapshot, config->srcAddress, chan->snapshotSize);
+        if (SmifHostMapped(config->srcAddress, chan->snapshotSize) && !SmifHostXipReady())
+        {
+            audioStats.xipViolations++;
+        }
+        audioStats.playRate = chan->rate;
+    }
+    else
+    {
+        audioStats.captureRate = chan->rate;
+    }
+
+    HostAt((chan->endNs + 999u) / 1000u, AudioHostDone,
+           (void *) (uintptr_t) ((chan->generation << 1) | chan->channel));
+}
+
+/* Stop the descriptor in progress, keeping the frames done in CH_IDX */
+static void AudioHostPause(audio_channel_t *chan)
+{
+    DW_CH_STRUCT_Type *regs = &hostDw0.CH_STRUCT[chan->channel];
+    uint64_t nowNs = HostTimeUs() * 1000u;
+
+    if (chan->running)
+    {
+        regs->CH_IDX += (uint32_t) (((nowNs - chan->startNs) * chan->rate) / 1000000000u);
+        chan->running = false;
+        chan->endNs = nowNs;
+        chan->generation++;
+    }
+}
+
+/* End of a descriptor: move the data, go to the next one and interrupt */
+static void AudioHostDone(void *arg)
+{
+    uint32_t channel = (uint32_t) ((uintptr_t) arg & 1u);
+    uint32_t generation = (uint32_t) ((uintptr_t) arg >> 1);
+    audio_channel_t *chan = (channel == AUDIO_RECORD_CHANNEL) ? &audioRecord : &audioPlay;
+    cy_stc_dma_descriptor_config_t config;
+
+    if (!chan->running || (chan->generation != generation))
+    {
+        return;
+    }
+
+    config = audioDescr[channel]->config;
+    chan->running = false;
+    hostDw0.CH_STRUCT[channel].CH_IDX = 0u;
+
+    if (channel == AUDIO_RECORD_CHANNEL)
+    {
+        CapturePage(&config);
+    }
+    else
+    {
+        PlayPage(chan, &config);
+    }
+
+    if ((config.channelState == CY_DMA_CHANNEL_DISABLED) || (config.nextDescriptor == NULL))
+    {
+        /* The channel still loads the next pointer, NULL at the end of a chain */
+        audioDescr[channel] = config.nextDescriptor;
+        hostDw0.CH_STRUCT[channel].CH_CURR_PTR = (uintptr_t) config.nextDescriptor;
+        hostDw0.CH_STRUCT[channel].CH_CTL &= ~DW_CH_STRUCT_CH_CTL_ENABLED_Msk;
+        chan->enabled = false;
+    }
+    else
+    {
+        Cy_DMA_Channel_SetDescriptor(&hostDw0, channel, config.nextDescriptor);
+        AudioHostKick(chan);
+    }
+
+    if ((channel == AUDIO_RECORD_CHANNEL) && (captureHeld != 0u))
+    {
+        captureHeld--;
+    }
+    else if (config.interruptType == CY_DMA_DESCR)
+    {
+        HostRaiseIrq(chan->irq);
+    }
+}
+
+/* An enabled channel runs while its peripheral does */
+static bool AudioHostActive(const audio_channel_t *chan)
+{
+    return chan->enabled && (audioDescr[chan->channel] != NULL) &&
+           ((chan->channel == AUDIO_RECORD_CHANNEL) ? pdmEnabled : i2sStarted);
+}
+
+/* Frames per second of the peripheral of a channel, 0 without audio clock */
+static uint32_t AudioHostRate(const audio_channel_t *chan)
+{
+    static const uint32_t pdmDividers[] = {1u, 2u, 3u, 4u};
+    static const uint32_t i2sLengths[] = {8u, 16u, 18u, 20u, 24u, 32u};
+    uint32_t clockHz = pllEnabled ? pllOutputHz : 0u;
+
+    if (chan->channel == AUDIO_RECORD_CHANNEL)
+    {
+        return clockHz / (pdmDividers[pdmConfig.clkDiv] * pdmDividers[pdmConfig.mclkDiv] *
+                          (pdmConfig.ckoDiv + 1u) * 2u * pdmConfig.sincDecRate);
+    }
+
+    /* The I2S clock runs at 8 times the bit clock */
+    return clockHz / ((i2sConfig.clkDiv + 1u) * 8u * 2u * i2sLengths[i2sConfig.txChannelLength]);
+}
+
+/* Frames moved by a descriptor: the FIFO interleaves the captured channels, the
+   I2S takes a left and a right sample per frame */
+static uint32_t DescrFrames(const cy_stc_dma_descriptor_config_t *config, uint32_t channel)
+{
+    uint32_t elements = config->xCount * ((config->descriptorType == CY_DMA_2D_TRANSFER) ? config->yCount : 1u);
+
+    if (channel == AUDIO_RECORD_CHANNEL)
+    {
+        return elements / ((pdmConfig.chanSelect == CY_PDM_PCM_OUT_STEREO) ? 2u : 1u);
+    }
+
+    return elements / 2u;
+}
+
+/* Bytes of the source read by a play descriptor */
+static uint32_t DescrSourceSize(const cy_stc_dma_descriptor_config_t *config)
+{
+    uint32_t size = (config->dataSize == CY_DMA_WORD) ? 4u : 2u;
+    uint32_t last;
+
+    if (config->descriptorType == CY_DMA_2D_TRANSFER)
+    {
+        last = (config->yCount - 1u) * (uint32_t) config->srcYincrement +
+               (config->xCount - 1u) * (uint32_t) config->srcXincrement;
+    }
+    else
+    {
+        last = (config->xCount - 1u) * (uint32_t) config->srcXincrement;
+    }
+
+    return (last + 1u) * size;
+}
+
+/* Fill the page of a record descriptor with the signal */
+static void CapturePage(const cy_stc_dma_descriptor_config_t *config)
+{
+    uint32_t channels = (pdmConfig.chanSelect == CY_PDM_PCM_OUT_STEREO) ? 2u : 1u;
+    uint32_t frames = config->xCount / channels;
+    uint32_t frame;
+    uint32_t index;
+    int32_t sample;
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        sample = ToneSample(captureFrame, audioRecord.rate);
+
+        for (index = 0; index < channels; index++)
+        {
+            /* The right microphone is a bit further */
+            int32_t value = (index == 0u) ? sample : ((sample * 3) / 4);
+            uint32_t element = (frame * channels + index) * (uint32_t) config->dstXincrement;
+
+            if (config->dataSize == CY_DMA_WORD)
+            {
+                ((int32_t *) config->dstAddress)[element] = value * 256;
+            }
+            else
+            {
+                ((int16_t *) config->dstAddress)[element] = (int16_t) value;
+            }
+        }
+        captureFrame++;
+    }
+
+    audioStats.capturedPages++;
+    audioStats.capturedFrames += frames;
+}
+
+/* Send the page of a play descriptor, it must not have changed since its start */
+static void PlayPage(audio_channel_t *chan, const cy_stc_dma_descriptor_config_t *config)
+{
+    uint32_t frames = DescrFrames(config, AUDIO_PLAY_CHANNEL);
+    uint32_t frame;
+
+    if (memcmp(chan->snapshot, config->srcAddress, chan->snapshotSize) != 0)
+    {
+        audioStats.playOverwrites++;
+    }
+    if (SmifHostMapped(config->srcAddress, chan->snapshotSize) && !SmifHostXipReady())
+    {
+        audioStats.xipViolations++;
+    }
+
+    if (playedFrames + frames > playedCapacity)
+    {
+        playedCapacity = (playedFrames + frames) * 2u;
+        playedSamples = realloc(playedSamples, playedCapacity * sizeof(int16_t));
+    }
+
+    for (frame = 0; frame < frames; frame++)
+    {
+        uint32_t element = frame * (uint32_t) config->srcYincrement;
+
+        if (config->dataSize == CY_DMA_WORD)
+        {
+            playedSamples[playedFrames] = (int16_t) (((const int32_t *) (const void *) chan->snapshot)[element] >> 8);
+        }
+        else
+        {
+            playedSamples[playedFrames] = ((const int16_t *) (const void *) chan->snapshot)[element];
+        }
+        playedFrames++;
+    }
+
+    audioStats.playedPages++;
+    audioStats.playedFrames += frames;
+}
+
+/* Tone burst or silence, over a low noise */
+static int32_t ToneSample(uint32_t frame, uint32_t rate)
+{
+    uint64_t ms = ((uint64_t) frame * 1000u) / rate;
+    int32_t sample;
+
+    noiseSeed = noiseSeed * 1664525u + 1013904223u;
+    sample = (int32_t) ((noiseSeed >> 16) % AUDIO_NOISE_LEVEL) - (int32_t) (AUDIO_NOISE_LEVEL / 2u);
+
+    if ((ms % (toneOnMs + toneOffMs)) < toneOnMs)
+    {
+        sample += (int32_t) (AUDIO_TONE_LEVEL * sin(2.0 * AUDIO_PI * AUDIO_TONE_HZ * frame / rate));
+    }
+
+    return sample;
+}
+
+/* [] END OF FILE */
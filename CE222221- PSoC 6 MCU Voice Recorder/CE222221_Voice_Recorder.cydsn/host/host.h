@@ -0,0 +1,141 @@
+/******************************************************************************
+* File Name: host.h
+*
+* Version: 1.0
+*
+* Description: Interfaces of the host models: the virtual clock, the SMIF
+*              memory image and the audio blocks.
+*
+* Related Document: N/A
+*
+* Hardware Dependency: None, built for a Linux host
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+#ifndef __HOST_H
+#define __HOST_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "project.h"
+#include "FreeRTOS.h"
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+
+/* Event run in the interrupt context at a simulated time */
+typedef void (*host_event_t)(void *arg);
+
+/* Latencies of the memory. Defaults are the S25FL512S typical values with
+   the SMIF clocked at 50 MHz in quad mode */
+typedef struct
+{
+    uint32_t commandUs;         /* Command, address and mode cycles */
+    uint32_t transferNs;        /* Data phase, per byte */
+    uint32_t programUs;         /* Page program, after the data phase */
+    uint32_t eraseUs;           /* Sector erase */
+    uint32_t suspendUs;         /* Erase suspend latency */
+}   smif_host_timing_t;
+
+/* Counters of the memory */
+typedef struct
+{
+    uint32_t reads;             /* Read commands */
+    uint32_t programs;          /* Page programs */
+    uint32_t erases;            /* Sector erases started */
+    uint32_t suspends;          /* Erases suspended */
+    uint32_t quadEnables;       /* QE commands */
+    uint32_t violations;        /* Commands the memory would not execute as intended */
+    uint32_t fifoInterrupts;    /* SMIF interrupts raised to refill or drain the FIFOs */
+    uint32_t dmaPhases;         /* Data phases moved by a DW channel */
+    uint64_t bytesRead;         /* Bytes read by command */
+    uint64_t bytesProgrammed;   /* Bytes programmed */
+    uint64_t busyUs;            /* Time the memory was programming or erasing */
+}   smif_host_stats_t;
+
+/* Counters of the audio blocks */
+typedef struct
+{
+    uint32_t capturedPages;     /* Descriptors completed by the record DMA */
+    uint32_t capturedFrames;    /* Frames written by the record DMA */
+    uint32_t playedPages;       /* Descriptors completed by the play DMA */
+    uint32_t playedFrames;      /* Frames read by the play DMA */
+    uint32_t captureRate;       /* Frames per second of the last capture */
+    uint32_t playRate;          /* Frames per second of the last playback */
+    uint32_t xipViolations;     /* Mapped reads with the SMIF in command mode */
+    uint32_t playOverwrites;    /* Pages changed while the play DMA read them */
+}   audio_host_stats_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+
+/* Scheduler, rtos_host.c */
+uint64_t HostTimeUs(void);                               /* Simulated time */
+void HostAt(uint64_t timeUs, host_event_t event, void *arg); /* Run an event at a time */
+void HostRaiseIrq(IRQn_Type irq);                        /* Run the handler of an interrupt */
+void HostStopScheduler(void);                            /* Return from vTaskStartScheduler */
+void HostTimeLimit(uint64_t timeUs);                     /* Stop the simulation at that time */
+uint32_t HostContextSwitches(void);
+
+/* Memory, smif_host.c */
+bool SmifHostOpen(const char *path,
+                    const smif_host_timing_t *timing);   /* RAM image if path is NULL */
+void SmifHostClose(void);                                /* Writes back a file image */
+const smif_host_stats_t * SmifHostStats(void);
+const uint8_t * SmifHostImage(void);                     /* Content of the memory */
+bool SmifHostMapped(const void *address, uint32_t size); /* Inside the mapped window */
+bool SmifHostXipReady(void);                             /* Mapped reads allowed */
+
+/* Audio blocks, audio_host.c */
+void AudioHostTone(uint32_t onMs, uint32_t offMs);       /* Captured tone bursts */
+void AudioHostHoldCapture(uint32_t pages);               /* Record interrupts held back */
+const audio_host_stats_t * AudioHostStats(void);
+const int16_t * AudioHostPlayed(uint32_t *frames);       /* Left samples played */
+void AudioHostPlayedReset(void);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define HOST_TICK_US            (1000000u / configTICK_RATE_HZ)
+#define HOST_CORE_CLOCK_HZ      (100000000u)    /* CM4 at 100 MHz */
+
+#define SMIF_DEF_COMMAND_US     (1u)            /* 8 command + 24 address + 8 mode cycles */
+#define SMIF_DEF_TRANSFER_NS    (40u)           /* Quad I/O at 50 MHz, 25 MB/s */
+#define SMIF_DEF_PROGRAM_US     MEM_PROGRAM_US  /* The timing the firmware budgets */
+#define SMIF_DEF_ERASE_US       MEM_ERASE_US
+#define SMIF_DEF_SUSPEND_US     MEM_SUSPEND_US
+
+#endif /* __HOST_H */
+
+/* [] END OF FILE */
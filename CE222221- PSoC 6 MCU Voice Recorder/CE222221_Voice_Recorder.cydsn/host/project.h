@@ -0,0 +1,601 @@
+/******************************************************************************
+* File Name: project.h
+*
+* Version: 1.0
+*
+* Description: Host replacement of the generated project.h. It declares the
+*              PDL blocks the storage task and the recorder use, backed by the
+*              models of this directory.
+*
+* Related Document: N/A
+*
+* Hardware Dependency: None, built for a Linux host
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+#ifndef __HOST_PROJECT_H
+#define __HOST_PROJECT_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*******************************************************************************
+*            Core
+*******************************************************************************/
+#define CY_LO8(x)           ((uint8_t) ((x) & 0xFFu))
+#define CY_HI8(x)           ((uint8_t) (((x) >> 8) & 0xFFu))
+#define CY_LO16(x)          ((uint16_t) ((x) & 0xFFFFu))
+#define CY_HI16(x)          ((uint16_t) (((x) >> 16) & 0xFFFFu))
+#define CY_ALIGN(align)     __attribute__((aligned(align)))
+
+extern uint32_t SystemCoreClock;            /* CM4 clock, scales the DWT counter */
+extern uint32_t cy_delayFreqHz;
+
+typedef void (*cy_israddress)(void);
+
+/* Interrupts of the design, dispatched by rtos_host.c */
+typedef enum
+{
+    SVCall_IRQn                 = -5,
+    PendSV_IRQn                 = -2,
+    SysTick_IRQn                = -1,
+    smif_interrupt_IRQn         = 2,
+    DMA_PDM_IRQn                = 3,
+    DMA_I2S_IRQn                = 4,
+    cpuss_interrupts_dw1_0_IRQn = 5,    /* Then one per DW1 channel */
+    HOST_IRQ_COUNT              = 21,
+}   IRQn_Type;
+
+typedef struct
+{
+    IRQn_Type       intrSrc;
+    uint32_t        intrPriority;
+}   cy_stc_sysint_t;
+
+typedef enum
+{
+    CY_SYSINT_SUCCESS   = 0x00u,
+    CY_SYSINT_BAD_PARAM = 0x01u,
+}   cy_en_sysint_status_t;
+
+cy_en_sysint_status_t Cy_SysInt_Init(const cy_stc_sysint_t *config, cy_israddress userIsr);
+void NVIC_EnableIRQ(IRQn_Type irq);
+void NVIC_DisableIRQ(IRQn_Type irq);
+void NVIC_ClearPendingIRQ(IRQn_Type irq);
+void __enable_irq(void);
+void __disable_irq(void);
+
+/* Intrinsics, the DSP ones are only used when __ARM_FEATURE_DSP is defined */
+static inline void __DMB(void)
+{
+    __sync_synchronize();
+}
+
+static inline uint32_t __CLZ(uint32_t value)
+{
+    return (value == 0u) ? 32u : (uint32_t) __builtin_clz(value);
+}
+
+static inline uint32_t __RBIT(uint32_t value)
+{
+    uint32_t result = 0;
+    uint32_t index;
+
+    for (index = 0; index < 32u; index++)
+    {
+        result = (result << 1) | ((value >> index) & 1u);
+    }
+
+    return result;
+}
+
+/* Cycle counter, runs from the simulated time at SystemCoreClock */
+typedef struct
+{
+    volatile uint32_t CTRL;
+    volatile uint32_t CYCCNT;
+}   DWT_Type;
+
+typedef struct
+{
+    volatile uint32_t DEMCR;
+}   CoreDebug_Type;
+
+DWT_Type * HostDwt(void);
+extern CoreDebug_Type hostCoreDebug;
+
+#define DWT                         (HostDwt())
+#define CoreDebug                   (&hostCoreDebug)
+#define CoreDebug_DEMCR_TRCENA_Msk  (1ul << 24)
+#define DWT_CTRL_CYCCNTENA_Msk      (1ul)
+
+/*******************************************************************************
+*            GPIO
+*******************************************************************************/
+typedef struct
+{
+    volatile uint32_t OUT;
+}   GPIO_PRT_Type;
+
+void Cy_GPIO_Write(GPIO_PRT_Type *base, uint32_t pinNum, uint32_t value);
+
+extern GPIO_PRT_Type hostRedLedPort;
+#define RED_LED_PORT                (&hostRedLedPort)
+#define RED_LED_NUM                 (1u)
+
+/*******************************************************************************
+*            SMIF, see smif_host.c
+*******************************************************************************/
+typedef struct
+{
+    volatile uint32_t CTL;
+    volatile uint32_t STATUS;
+    volatile uint32_t TX_DATA_FIFO_CTL;
+    volatile uint32_t RX_DATA_FIFO_CTL;
+    volatile uint32_t TX_DATA_FIFO_WR4;
+    volatile uint32_t RX_DATA_FIFO_RD4;
+}   SMIF_Type;
+
+typedef enum
+{
+    CY_SMIF_SUCCESS         = 0x00u,
+    CY_SMIF_CMD_FIFO_FULL   = 0x01u,
+    CY_SMIF_EXCEED_TIMEOUT  = 0x02u,
+    CY_SMIF_BAD_PARAM       = 0x04u,
+    CY_SMIF_BUSY            = 0x05u,
+}   cy_en_smif_status_t;
+
+typedef enum
+{
+    CY_SMIF_NORMAL          = 0x00u,    /* Command mode */
+    CY_SMIF_MEMORY          = 0x01u,    /* Memory-mapped (XIP) mode */
+}   cy_en_smif_mode_t;
+
+typedef enum
+{
+    CY_SMIF_WIDTH_SINGLE    = 0x00u,
+    CY_SMIF_WIDTH_DUAL      = 0x01u,
+    CY_SMIF_WIDTH_QUAD      = 0x02u,
+    CY_SMIF_WIDTH_OCTAL     = 0x03u,
+}   cy_en_smif_txfr_width_t;
+
+typedef enum
+{
+    CY_SMIF_SLAVE_SELECT_0  = 0x01u,
+}   cy_en_smif_slave_select_t;
+
+typedef enum
+{
+    CY_SMIF_DATA_SEL0       = 0x00u,
+}   cy_en_smif_data_select_t;
+
+typedef enum
+{
+    CY_SMIF_CACHE_SLOW      = 0x01u,
+    CY_SMIF_CACHE_FAST      = 0x02u,
+    CY_SMIF_CACHE_BOTH      = 0x03u,
+}   cy_en_smif_cache_t;
+
+#define CY_SMIF_TX_NOT_LAST_BYTE    (0u)
+#define CY_SMIF_TX_LAST_BYTE        (1u)
+#define CY_SMIF_SEND_CMPLT          (0x00u)
+#define CY_SMIF_REC_CMPLT           (0x01u)
+
+typedef void (*cy_smif_event_cb_t)(uint32_t event);
+
+typedef struct
+{
+    cy_smif_event_cb_t  txCmpltCb;
+    cy_smif_event_cb_t  rxCmpltCb;
+    uint32_t            transferStatus;
+    uint32_t            timeout;
+}   cy_stc_smif_context_t;
+
+typedef struct
+{
+    uint32_t            mode;
+    uint32_t            deselectDelay;
+    uint32_t            rxClockSel;
+    uint32_t            blockEvent;
+}   cy_stc_smif_config_t;
+
+/* The mapped window is a host pointer, hence the uintptr_t base */
+typedef struct
+{
+    cy_en_smif_slave_select_t slaveSelect;
+    uint32_t            flags;
+    cy_en_smif_data_select_t dataSelect;
+    uintptr_t           baseAddress;
+    uint32_t            memMappedSize;
+    bool                dualQuadSlots;
+    const void          *deviceCfg;
+}   cy_stc_smif_mem_config_t;
+
+typedef struct
+{
+    uint32_t            memCount;
+    cy_stc_smif_mem_config_t **memConfig;
+    uint32_t            majorVersion;
+    uint32_t            minorVersion;
+}   cy_stc_smif_block_config_t;
+
+extern SMIF_Type hostSmif;
+extern cy_stc_smif_config_t SMIF_1_config;
+extern cy_stc_smif_context_t SMIF_1_context;
+#define SMIF_1_HW                   (&hostSmif)
+
+cy_en_smif_status_t Cy_SMIF_Init(SMIF_Type *base, cy_stc_smif_config_t const *config,
+                    uint32_t timeout, cy_stc_smif_context_t *context);
+void Cy_SMIF_SetDataSelect(SMIF_Type *base, cy_en_smif_slave_select_t slaveSelect,
+                    cy_en_smif_data_select_t dataSelect);
+void Cy_SMIF_Enable(SMIF_Type *base, cy_stc_smif_context_t *context);
+void Cy_SMIF_SetMode(SMIF_Type *base, cy_en_smif_mode_t mode);
+cy_en_smif_status_t Cy_SMIF_CacheInvalidate(SMIF_Type *base, cy_en_smif_cache_t cacheType);
+bool Cy_SMIF_BusyCheck(SMIF_Type const *base);
+void Cy_SMIF_SetTxFifoTriggerLevel(SMIF_Type *base, uint32_t level);
+void Cy_SMIF_SetRxFifoTriggerLevel(SMIF_Type *base, uint32_t level);
+void Cy_SMIF_Interrupt(SMIF_Type *base, cy_stc_smif_context_t *context);
+cy_en_smif_status_t Cy_SMIF_TransmitCommand(SMIF_Type *base, uint8_t cmd,
+                    cy_en_smif_txfr_width_t cmdTxfrWidth, uint8_t const cmdParam[],
+                    uint32_t paramSize, cy_en_smif_txfr_width_t paramTxfrWidth,
+                    cy_en_smif_slave_select_t slaveSelect, uint32_t completeTxfr,
+                    cy_stc_smif_context_t const *context);
+cy_en_smif_status_t Cy_SMIF_Memslot_Init(SMIF_Type *base, cy_stc_smif_block_config_t * const blockConfig,
+                    cy_stc_smif_context_t *context);
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdWriteEnable(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    cy_stc_smif_context_t const *context);
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdSectorErase(SMIF_Type *base, cy_stc_smif_mem_config_t *memDevice,
+                    uint8_t const *sectorAddr, cy_stc_smif_context_t const *context);
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdProgram(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    uint8_t const *addr, uint8_t *writeBuff, uint32_t size,
+                    cy_smif_event_cb_t cmdCmpltCb, cy_stc_smif_context_t *context);
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdRead(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    uint8_t const *addr, uint8_t *readBuff, uint32_t size,
+                    cy_smif_event_cb_t cmdCmpltCb, cy_stc_smif_context_t *context);
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdReadSts(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    uint8_t *status, uint8_t command, cy_stc_smif_context_t const *context);
+cy_en_smif_status_t Cy_SMIF_Memslot_QuadEnable(SMIF_Type *base, cy_stc_smif_mem_config_t *memDevice,
+                    cy_stc_smif_context_t const *context);
+bool Cy_SMIF_Memslot_IsBusy(SMIF_Type *base, cy_stc_smif_mem_config_t *memDevice,
+                    cy_stc_smif_context_t const *context);
+
+/*******************************************************************************
+*            DMA (DataWire), see audio_host.c
+*******************************************************************************/
+typedef enum
+{
+    CY_DMA_RETRIG_IM        = 0x00u,
+    CY_DMA_RETRIG_4CYC      = 0x01u,
+    CY_DMA_RETRIG_16CYC     = 0x02u,
+    CY_DMA_WAIT_FOR_REACT   = 0x03u,
+}   cy_en_dma_trigger_deact_t;
+
+typedef enum
+{
+    CY_DMA_1ELEMENT         = 0x00u,
+    CY_DMA_X_LOOP           = 0x01u,
+    CY_DMA_DESCR            = 0x02u,
+    CY_DMA_DESCR_CHAIN      = 0x03u,
+}   cy_en_dma_trigger_type_t;
+
+typedef enum
+{
+    CY_DMA_CHANNEL_ENABLED  = 0x00u,
+    CY_DMA_CHANNEL_DISABLED = 0x01u,
+}   cy_en_dma_channel_state_t;
+
+typedef enum
+{
+    CY_DMA_BYTE             = 0x00u,
+    CY_DMA_HALFWORD         = 0x01u,
+    CY_DMA_WORD             = 0x02u,
+}   cy_en_dma_data_size_t;
+
+typedef enum
+{
+    CY_DMA_TRANSFER_SIZE_DATA = 0x00u,
+    CY_DMA_TRANSFER_SIZE_WORD = 0x01u,
+}   cy_en_dma_transfer_size_t;
+
+typedef enum
+{
+    CY_DMA_SINGLE_TRANSFER  = 0x00u,
+    CY_DMA_1D_TRANSFER      = 0x01u,
+    CY_DMA_2D_TRANSFER      = 0x02u,
+}   cy_en_dma_descriptor_type_t;
+
+typedef enum
+{
+    CY_DMA_SUCCESS          = 0x00u,
+    CY_DMA_BAD_PARAM        = 0x01u,
+}   cy_en_dma_status_t;
+
+struct cy_stc_dma_descriptor;
+
+typedef struct
+{
+    cy_en_dma_trigger_deact_t   retrigger;
+    cy_en_dma_trigger_type_t    interruptType;
+    cy_en_dma_trigger_type_t    triggerOutType;
+    cy_en_dma_channel_state_t   channelState;
+    cy_en_dma_trigger_type_t    triggerInType;
+    cy_en_dma_data_size_t       dataSize;
+    cy_en_dma_transfer_size_t   srcTransferSize;
+    cy_en_dma_transfer_size_t   dstTransferSize;
+    cy_en_dma_descriptor_type_t descriptorType;
+    void                        *srcAddress;
+    void                        *dstAddress;
+    int32_t                     srcXincrement;
+    int32_t                     dstXincrement;
+    uint32_t                    xCount;
+    int32_t                     srcYincrement;
+    int32_t                     dstYincrement;
+    uint32_t                    yCount;
+    struct cy_stc_dma_descriptor *nextDescriptor;
+}   cy_stc_dma_descriptor_config_t;
+
+/* A descriptor keeps its settings as given, the channel model reads them */
+typedef struct cy_stc_dma_descriptor
+{
+    cy_stc_dma_descriptor_config_t config;
+}   cy_stc_dma_descriptor_t;
+
+typedef struct
+{
+    volatile uint32_t   CH_CTL;
+    volatile uint32_t   CH_STATUS;
+    volatile uint32_t   CH_IDX;
+    volatile uintptr_t  CH_CURR_PTR;
+    volatile uint32_t   INTR_MASK;
+}   DW_CH_STRUCT_Type;
+
+typedef struct
+{
+    volatile uint32_t   CTL;
+    DW_CH_STRUCT_Type   CH_STRUCT[16];
+}   DW_Type;
+
+typedef struct
+{
+    cy_stc_dma_descriptor_t *descriptor;
+    bool                preemptable;
+    uint32_t            priority;
+    bool                enable;
+    bool                bufferable;
+}   cy_stc_dma_channel_config_t;
+
+#define CY_DMA_INTR_MASK            (0x01u)
+#define DW_CH_STRUCT_CH_CTL_ENABLED_Msk (0x80000000u)
+#define DW_CTL_ENABLED_Msk          (0x80000000u)
+
+cy_en_dma_status_t Cy_DMA_Descriptor_Init(cy_stc_dma_descriptor_t *descriptor,
+                    cy_stc_dma_descriptor_config_t const *config);
+void Cy_DMA_Channel_SetDescriptor(DW_Type *base, uint32_t channel, cy_stc_dma_descriptor_t const *descriptor);
+cy_stc_dma_descriptor_t * Cy_DMA_Channel_GetCurrentDescriptor(DW_Type const *base, uint32_t channel);
+void Cy_DMA_Channel_Enable(DW_Type *base, uint32_t channel);
+void Cy_DMA_Channel_Disable(DW_Type *base, uint32_t channel);
+void Cy_DMA_Channel_ClearInterrupt(DW_Type *base, uint32_t channel);
+cy_en_dma_status_t Cy_DMA_Channel_Init(DW_Type *base, uint32_t channel, cy_stc_dma_channel_config_t const *config);
+void Cy_DMA_Channel_SetInterruptMask(DW_Type *base, uint32_t channel, uint32_t interrupt);
+void Cy_DMA_Enable(DW_Type *base);
+
+/* The second DataWire, used without a component by the SMIF data phases */
+extern DW_Type hostDw1;
+#define DW1                         (&hostDw1)
+
+/* DMA components of the design */
+extern DW_Type hostDw0;
+#define DMA_Record_HW               (&hostDw0)
+#define DMA_Record_DW_CHANNEL       (0u)
+#define DMA_Record_INTR_MASK        (CY_DMA_INTR_MASK)
+#define DMA_PlayRight_HW            (&hostDw0)
+#define DMA_PlayRight_DW_CHANNEL    (1u)
+#define DMA_PlayRight_INTR_MASK     (CY_DMA_INTR_MASK)
+
+extern cy_stc_dma_descriptor_t DMA_Record_PDM_to_SRAM;
+extern const cy_stc_dma_descriptor_config_t DMA_Record_PDM_to_SRAM_config;
+extern cy_stc_dma_descriptor_t DMA_PlayRight_SRAM_to_I2S;
+extern const cy_stc_dma_descriptor_config_t DMA_PlayRight_SRAM_to_I2S_config;
+extern const cy_stc_sysint_t DMA_PDM_IRQ_cfg;
+extern const cy_stc_sysint_t DMA_I2S_IRQ_cfg;
+
+void DMA_Record_Init(void);
+void DMA_Record_SetInterruptMask(uint32_t interrupt);
+void DMA_PlayRight_Init(void);
+void DMA_PlayRight_SetInterruptMask(uint32_t interrupt);
+
+/*******************************************************************************
+*            Trigger multiplexer, see smif_host.c
+*******************************************************************************/
+typedef enum
+{
+    TRIGGER_TYPE_LEVEL      = 0x00u,
+    TRIGGER_TYPE_EDGE       = 0x01u,
+}   en_trig_type_t;
+
+typedef enum
+{
+    CY_TRIGMUX_SUCCESS      = 0x00u,
+    CY_TRIGMUX_BAD_PARAM    = 0x01u,
+}   cy_en_trigmux_status_t;
+
+/* The routes of the SMIF data requests to DW1, in the values of the device: 
+   outputs have bit 30 set, the group is in bits 8 to 15 and the line below */
+#define TRIG13_IN_SMIF_TR_TX_REQ        (0x00000D16u)
+#define TRIG13_IN_SMIF_TR_RX_REQ        (0x00000D17u)
+#define TRIG13_OUT_TR_GROUP1_INPUT41    (0x40000D1Eu)   /* Group 13 output 30 */
+#define TRIG13_OUT_TR_GROUP1_INPUT42    (0x40000D1Fu)   /* Group 13 output 31 */
+#define TRIG1_IN_TR_GROUP13_OUTPUT30    (0x00000129u)   /* Group 1 input 41 */
+#define TRIG1_IN_TR_GROUP13_OUTPUT31    (0x0000012Au)   /* Group 1 input 42 */
+#define TRIG1_OUT_CPUSS_DW1_TR_IN14     (0x4000010Eu)
+#define TRIG1_OUT_CPUSS_DW1_TR_IN15     (0x4000010Fu)
+
+cy_en_trigmux_status_t Cy_TrigMux_Connect(uint32_t inTrig, uint32_t outTrig, bool invert, en_trig_type_t trigType);
+
+/*******************************************************************************
+*            I2S and PDM/PCM, see audio_host.c
+*******************************************************************************/
+typedef struct
+{
+    volatile uint32_t   TX_FIFO_WR;
+}   I2S_Type;
+
+typedef struct
+{
+    volatile uint32_t   RX_FIFO_RD;
+}   PDM_Type;
+
+typedef enum
+{
+    CY_I2S_LEN8             = 0x00u,
+    CY_I2S_LEN16            = 0x01u,
+    CY_I2S_LEN18            = 0x02u,
+    CY_I2S_LEN20            = 0x03u,
+    CY_I2S_LEN24            = 0x04u,
+    CY_I2S_LEN32            = 0x05u,
+}   cy_en_i2s_len_t;
+
+typedef enum
+{
+    CY_I2S_SUCCESS          = 0x00u,
+    CY_I2S_BAD_PARAM        = 0x01u,
+}   cy_en_i2s_status_t;
+
+typedef struct
+{
+    bool                txEnabled;
+    bool                rxEnabled;
+    uint8_t             clkDiv;         /* Audio clock divider, less one */
+    cy_en_i2s_len_t     txChannelLength;
+    cy_en_i2s_len_t     txWordLength;
+}   cy_stc_i2s_config_t;
+
+typedef enum
+{
+    CY_PDM_PCM_CLK_DIV_BYPASS = 0x00u,
+    CY_PDM_PCM_CLK_DIV_1_2  = 0x01u,
+    CY_PDM_PCM_CLK_DIV_1_3  = 0x02u,
+    CY_PDM_PCM_CLK_DIV_1_4  = 0x03u,
+}   cy_en_pdm_pcm_clk_div_t;
+
+typedef enum
+{
+    CY_PDM_PCM_OUT_CHAN_LEFT  = 0x01u,
+    CY_PDM_PCM_OUT_CHAN_RIGHT = 0x02u,
+    CY_PDM_PCM_OUT_STEREO   = 0x03u,
+}   cy_en_pdm_pcm_out_t;
+
+typedef enum
+{
+    CY_PDM_PCM_WLEN_16_BIT  = 0x00u,
+    CY_PDM_PCM_WLEN_18_BIT  = 0x01u,
+    CY_PDM_PCM_WLEN_20_BIT  = 0x02u,
+    CY_PDM_PCM_WLEN_24_BIT  = 0x03u,
+}   cy_en_pdm_pcm_word_len_t;
+
+typedef enum
+{
+    CY_PDM_PCM_SUCCESS      = 0x00u,
+    CY_PDM_PCM_BAD_PARAM    = 0x01u,
+}   cy_en_pdm_pcm_status_t;
+
+typedef struct
+{
+    cy_en_pdm_pcm_clk_div_t clkDiv;
+    cy_en_pdm_pcm_clk_div_t mclkDiv;
+    uint8_t             ckoDiv;         /* PDM clock divider, less one */
+    uint8_t             sincDecRate;    /* Half the oversampling */
+    cy_en_pdm_pcm_out_t chanSelect;
+    cy_en_pdm_pcm_word_len_t wordLen;
+    bool                signExtension;
+}   cy_stc_pdm_pcm_config_t;
+
+extern I2S_Type hostI2s;
+extern PDM_Type hostPdm;
+extern const cy_stc_i2s_config_t I2S_config;
+extern const cy_stc_pdm_pcm_config_t PDM_PCM_config;
+#define I2S_HW                      (&hostI2s)
+#define PDM_PCM_HW                  (&hostPdm)
+
+cy_en_i2s_status_t Cy_I2S_Init(I2S_Type *base, cy_stc_i2s_config_t const *config);
+void Cy_I2S_DeInit(I2S_Type *base);
+void I2S_Start(void);
+void I2S_Stop(void);
+cy_en_pdm_pcm_status_t Cy_PDM_PCM_Init(PDM_Type *base, cy_stc_pdm_pcm_config_t const *config);
+void Cy_PDM_PCM_DeInit(PDM_Type *base);
+void Cy_PDM_PCM_Enable(PDM_Type *base);
+void Cy_PDM_PCM_Disable(PDM_Type *base);
+void Cy_PDM_PCM_ClearFifo(PDM_Type *base);
+
+/*******************************************************************************
+*            Clocks, see audio_host.c
+*******************************************************************************/
+typedef enum
+{
+    CY_SYSCLK_SUCCESS       = 0x00u,
+    CY_SYSCLK_BAD_PARAM     = 0x01u,
+}   cy_en_sysclk_status_t;
+
+typedef enum
+{
+    CY_SYSCLK_CLKHF_NO_DIVIDE   = 0x00u,
+    CY_SYSCLK_CLKHF_DIVIDE_BY_2 = 0x01u,
+    CY_SYSCLK_CLKHF_DIVIDE_BY_4 = 0x02u,
+    CY_SYSCLK_CLKHF_DIVIDE_BY_8 = 0x03u,
+}   cy_en_clkhf_dividers_t;
+
+typedef enum
+{
+    CY_SYSCLK_FLLPLL_OUTPUT_AUTO   = 0x00u,
+    CY_SYSCLK_FLLPLL_OUTPUT_AUTO1  = 0x01u,
+    CY_SYSCLK_FLLPLL_OUTPUT_INPUT  = 0x02u,
+    CY_SYSCLK_FLLPLL_OUTPUT_OUTPUT = 0x03u,
+}   cy_en_fll_pll_output_mode_t;
+
+typedef struct
+{
+    uint32_t            inputFreq;
+    uint32_t            outputFreq;
+    bool                lfMode;
+    cy_en_fll_pll_output_mode_t outputMode;
+}   cy_stc_pll_config_t;
+
+cy_en_sysclk_status_t Cy_SysClk_PllDisable(uint32_t clkPath);
+cy_en_sysclk_status_t Cy_SysClk_PllConfigure(uint32_t clkPath, const cy_stc_pll_config_t *config);
+cy_en_sysclk_status_t Cy_SysClk_PllEnable(uint32_t clkPath, uint32_t timeoutus);
+uint32_t Cy_SysClk_ClkPathGetFrequency(uint32_t clkPath);
+cy_en_sysclk_status_t Cy_SysClk_ClkHfSetDivider(uint32_t clkHf, cy_en_clkhf_dividers_t divider);
+
+#endif /* __HOST_PROJECT_H */
+
+/* [] END OF FILE */
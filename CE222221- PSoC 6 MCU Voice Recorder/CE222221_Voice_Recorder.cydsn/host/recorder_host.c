@@ -0,0 +1,473 @@
+/******************************************************************************
+* File Name: recorder_host.c
+*
+* Version: 1.0
+*
+* Description: Host scenario of the voice recorder. It mounts the catalog,
+*              records, plays back and prints the throughput, the overrun
+*              margins and the mount time of the storage task.
+*
+* Related Document: N/A
+*
+* Hardware Dependency: None, built for a Linux host
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "host.h"
+#include "recorder.h"
+#include "catalog.h"
+#include "smif_mem.h"
+#include "graphics.h"
+#include "rtos.h"
+
+/*******************************************************************************
+*            Local Functions
+*******************************************************************************/
+static void ScriptTask(void *arg);
+static void GuiTask(void *arg);
+static bool WaitEvent(uint32_t expected, TickType_t ticks);
+static uint32_t VerifyPlayback(const catalog_record_t *record);
+static uint32_t RecordAddress(uint32_t sector, uint32_t page);
+static void PrintLatency(const char *name, mem_lat_op_t op);
+static void RunBenchmark(uint32_t sectors);
+static void PrintXferCost(const char *name, const mem_bench_xfer_t *cost);
+static void Usage(const char *name);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define HOST_STACK_DEPTH        (400u)      /* Ignored, host stacks are larger */
+#define HOST_DEF_SECONDS        (10u)       /* Recording length */
+#define HOST_DEF_SETTLE_MS      (3000u)     /* Idle after the mount, the bank fills */
+#define HOST_MOUNT_TIMEOUT      pdMS_TO_TICKS(5000u)
+#define HOST_PLAY_MARGIN_MS     (5000u)     /* Playback longer than the record */
+#define HOST_TIME_MARGIN_US     (60000000u) /* Time limit past the scenario */
+#define HOST_PCM_LAYOUT         (RECORD_FORMAT_CODEC | RECORD_FORMAT_STEREO | \
+                                 RECORD_FORMAT_24BIT | RECORD_FORMAT_COMPACT)
+
+/*******************************************************************************
+*            Global Variables
+*******************************************************************************/
+
+/* RTOS objects of main_cm4.c */
+QueueHandle_t EventsQueue;
+QueueHandle_t GUIQueue;
+QueueHandle_t StorageQueue;
+EventGroupHandle_t DmaEvents;
+
+/*******************************************************************************
+*            Internal Global Variables
+*******************************************************************************/
+uint32_t hostSeconds = HOST_DEF_SECONDS;    /* Scenario options */
+uint32_t hostFormat = RECORD_DEF_FORMAT;
+uint32_t hostRate = RECORD_SAMPLE_RATE;
+uint32_t hostSettleMs = HOST_DEF_SETTLE_MS;
+uint32_t hostBenchSectors = 0;              /* Benchmark instead of recording */
+uint32_t hostHoldPages = 0;                 /* Capture interrupts held a second in */
+volatile bool hostMounted = false;          /* SHOW_MOUNT_TIME seen */
+bool hostDone = false;                      /* Scenario completed */
+uint32_t hostFailures = 0;                  /* Checks failed */
+uint32_t hostMemLimits = 0;                 /* REACH_MEM_LIMIT events */
+uint64_t hostRecordUs = 0;                  /* Length of the capture */
+
+/*******************************************************************************
+* Function Name: main
+********************************************************************************
+* Summary:
+*   This function runs the recorder on the host: the storage task, the recorder
+*   task and the catalog are the firmware ones, over the PDL and FreeRTOS of
+*   the host directory. A script records, plays back and checks what was
+*   played, then prints the statistics. The simulated time makes each run the
+*   same.
+*
+*******************************************************************************/
+int main(int argc, char *argv[])
+{
+    smif_host_timing_t timing =
+    {
+        .commandUs = SMIF_DEF_COMMAND_US,
+        .transferNs = SMIF_DEF_TRANSFER_NS,
+        .programUs = SMIF_DEF_PROGRAM_US,
+        .eraseUs = SMIF_DEF_ERASE_US,
+        .suspendUs = SMIF_DEF_SUSPEND_US,
+    };
+    const char *image = NULL;
+    int option;
+
+    while ((option = getopt(argc, argv, "s:f:r:i:p:e:w:b:l:h")) != -1)
+    {
+        switch (option)
+        {
+            case 's': hostSeconds = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 'f': hostFormat = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 'r': hostRate = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 'i': image = optarg; break;
+            case 'p': timing.programUs = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 'e': timing.eraseUs = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 'w': hostSettleMs = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 'b': hostBenchSectors = (uint32_t) strtoul(optarg, NULL, 0); break;
+            case 'l': hostHoldPages = (uint32_t) strtoul(optarg, NULL, 0); break;
+            default: Usage(argv[0]); return 1;
+        }
+    }
+
+    if (!SmifHostOpen(image, &timing))
+    {
+        fprintf(stderr, "recorder_host: no memory for the image\n");
+        return 1;
+    }
+
+    /* Same start as main_cm4.c, without the touch and the display */
+    __enable_irq();
+    InitMemory();
+
+    EventsQueue = xQueueCreate(QUEUE_SIZE, sizeof(uint32_t));
+    GUIQueue = xQueueCreate(QUEUE_SIZE, sizeof(uint32_t));
+    StorageQueue = xQueueCreate(STORAGE_QUEUE_SIZE, sizeof(mem_request_t));
+    DmaEvents = xEventGroupCreate();
+
+    xTaskCreate(StorageTask, "Storage Task", HOST_STACK_DEPTH, NULL, 2, NULL);
+    xTaskCreate(RecorderTask, "Recorder Task", HOST_STACK_DEPTH, NULL, 1, NULL);
+    xTaskCreate(GuiTask, "Graphics Task", HOST_STACK_DEPTH, NULL, 1, NULL);
+    xTaskCreate(ScriptTask, "Command Task", HOST_STACK_DEPTH, NULL, 1, NULL);
+
+    HostTimeLimit((uint64_t) hostSeconds * 2000000u + (uint64_t) hostSettleMs * 1000u + HOST_TIME_MARGIN_US);
+    vTaskStartScheduler();
+
+    SmifHostClose();
+
+    if (!hostDone)
+    {
+        fprintf(stderr, "recorder_host: scenario not completed\n");
+        return 1;
+    }
+
+    return (hostFailures == 0u) ? 0 : 1;
+}
+
+/* The events task of the board, driven by the scenario instead of the touch */
+static void ScriptTask(void *arg)
+{
+    const smif_host_stats_t *smif = SmifHostStats();
+    const audio_host_stats_t *audio = AudioHostStats();
+    const tx_pool_stats_t *pool;
+    const catalog_record_t *record;
+    const mem_xfer_stats_t *xfer;
+    record_handle_t handle;
+    uint8_t barrier[PACKET_SIZE];
+    uint64_t start;
+    uint64_t bytes;
+    TickType_t waited = 0;
+
+    (void) arg;
+
+    /* The recorder task mounts the catalog first */
+    while (!hostMounted && (waited < HOST_MOUNT_TIMEOUT))
+    {
+        vTaskDelay(pdMS_TO_TICKS(10u));
+        waited += pdMS_TO_TICKS(10u);
+    }
+    if (!hostMounted)
+    {
+        fprintf(stderr, "recorder_host: catalog not mounted\n");
+        HostStopScheduler();
+    }
+
+    if (hostBenchSectors != 0u)
+    {
+        RunBenchmark(hostBenchSectors);
+    }
+
+    if (!SetRecorderFormat(hostFormat) || !SetRecorderRate(hostRate))
+    {
+        printf("format      0x%04lx at %lu Hz refused: not supported, over the flash budget or the TX pool\n",
+               (unsigned long) hostFormat, (unsigned long) hostRate);
+    }
+
+    /* The user presses the button a while after the start, 0 records at once */
+    if (hostSettleMs != 0u)
+    {
+        vTaskDelay(pdMS_TO_TICKS(hostSettleMs));
+    }
+
+    /* Record, then wait for the storage task to program every page */
+    start = HostTimeUs();
+    handle = StartRecorder();
+    if ((hostHoldPages != 0u) && (hostSeconds > 1u))
+    {
+        vTaskDelay(pdMS_TO_TICKS(1000u));
+        AudioHostHoldCapture(hostHoldPages);
+        vTaskDelay(pdMS_TO_TICKS((hostSeconds - 1u) * 1000u));
+    }
+    else
+    {
+        vTaskDelay(pdMS_TO_TICKS(hostSeconds * 1000u));
+    }
+    StopRecorder();
+    hostRecordUs = HostTimeUs() - start;
+    SyncMemory(MEM_OP_READ, barrier, sizeof(barrier), 0u);
+
+    record = CatalogGet(handle);
+    if (record == NULL)
+    {
+        fprintf(stderr, "recorder_host: record %lu not in the catalog\n", (unsigned long) handle);
+        HostStopScheduler();
+    }
+
+    /* Play it back to the end */
+    AudioHostPlayedReset();
+    PlayRecorder(handle);
+    if (!WaitEvent(PLAY_COMPLETED, pdMS_TO_TICKS(hostSeconds * 1000u + HOST_PLAY_MARGIN_MS)))
+    {
+        fprintf(stderr, "recorder_host: playback not completed\n");
+        hostFailures++;
+    }
+
+    pool = RecorderPoolStats();
+    xfer = MemoryXferStats();
+    bytes = (uint64_t) record->numberOfPages * PACKET_SIZE;
+
+    printf("record      %lu pages from sector %lu, format 0x%04lx, %lu Hz\n",
+           (unsigned long) record->numberOfPages, (unsigned long) record->startSector,
+           (unsigned long) record->format, (unsigned long) audio->captureRate);
+    printf("throughput  %llu B/s recorded over %llu ms\n",
+           (unsigned long long) ((bytes * 1000000u) / ((hostRecordUs != 0u) ? hostRecordUs : 1u)),
+           (unsigned long long) (hostRecordUs / 1000u));
+    printf("recorder    overruns %lu, underruns %lu, backlog peak %lu, silent %lu, mem limits %lu\n",
+           (unsigned long) RecorderOverruns(), (unsigned long) RecorderUnderruns(),
+           (unsigned long) RecorderBacklogPeak(), (unsigned long) RecorderSilentPages(),
+           (unsigned long) hostMemLimits);
+    printf("tx pool     peak %lu of %lu pages, %lu needed\n", (unsigned long) pool->peak, 
+           (unsigned long) pool->depth, (unsigned long) pool->needed);
+    printf("storage     burst peak %lu, banked %lu, data phases %lu, interrupts %lu\n",
+           (unsigned long) MemoryBurstPeak(), (unsigned long) EraseAheadBanked(),
+           (unsigned long) xfer->pages, (unsigned long) xfer->interrupts);
+    PrintLatency("erase", MEM_LAT_ERASE);
+    PrintLatency("erase ahead", MEM_LAT_ERASE_AHEAD);
+    PrintLatency("program", MEM_LAT_PROGRAM);
+    PrintLatency("read", MEM_LAT_READ);
+    printf("mount       %lu us\n", (unsigned long) CatalogMountTime());
+    printf("memory      reads %lu, programs %lu, erases %lu, suspends %lu, busy %llu ms\n",
+           (unsigned long) smif->reads, (unsigned long) smif->programs, (unsigned long) smif->erases,
+           (unsigned long) smif->suspends, (unsigned long long) (smif->busyUs / 1000u));
+    printf("audio       captured %lu pages, played %lu pages at %lu Hz\n",
+           (unsigned long) audio->capturedPages, (unsigned long) audio->playedPages,
+           (unsigned long) audio->playRate);
+    printf("scheduler   %lu context switches, %llu ms simulated\n",
+           (unsigned long) HostContextSwitches(), (unsigned long long) (HostTimeUs() / 1000u));
+
+    if ((record->format & HOST_PCM_LAYOUT) == RECORD_FORMAT_PCM16)
+    {
+        hostFailures += VerifyPlayback(record);
+    }
+
+    if ((smif->violations != 0u) || (audio->xipViolations != 0u) || (audio->playOverwrites != 0u))
+    {
+        printf("violations  memory %lu, XIP %lu, pages overwritten while played %lu\n",
+               (unsigned long) smif->violations, (unsigned long) audio->xipViolations,
+               (unsigned long) audio->playOverwrites);
+        hostFailures++;
+    }
+    if (RecorderOverruns() != 0u)
+    {
+        hostFailures++;
+    }
+
+    printf("result      %s\n", (hostFailures == 0u) ? "pass" : "FAIL");
+
+    hostDone = true;
+    HostStopScheduler();
+}
+
+/* The graphics task of the board, it only notes the mount */
+static void GuiTask(void *arg)
+{
+    uint32_t event;
+
+    (void) arg;
+
+    for (;;)
+    {
+        if ((xQueueReceive(GUIQueue, &event, portMAX_DELAY) == pdPASS) &&
+            ((event & GUI_EVENT_MASK) == SHOW_MOUNT_TIME))
+        {
+            hostMounted = true;
+        }
+    }
+}
+
+/* Wait for a recorder event, counting the others */
+static bool WaitEvent(uint32_t expected, TickType_t ticks)
+{
+    TickType_t start = xTaskGetTickCount();
+    TickType_t elapsed = 0;
+    uint32_t event;
+
+    while (elapsed < ticks)
+    {
+        if (xQueueReceive(EventsQueue, &event, ticks - elapsed) == pdPASS)
+        {
+            if (event == expected)
+            {
+                return true;
+            }
+            if (event == REACH_MEM_LIMIT)
+            {
+                hostMemLimits++;
+            }
+        }
+        elapsed = xTaskGetTickCount() - start;
+    }
+
+    return false;
+}
+
+/* The samples played are the payloads of the stored pages, in order */
+static uint32_t VerifyPlayback(const catalog_record_t *record)
+{
+    const uint8_t *image = SmifHostImage();
+    const int16_t *payload;
+    const int16_t *played;
+    uint32_t frames;
+    uint32_t page;
+    uint32_t index;
+
+    played = AudioHostPlayed(&frames);
+    if (frames != record->numberOfPages * PAGE_SAMPLES)
+    {
+        printf("verify      %lu samples played for %lu stored\n",
+               (unsigned long) frames, (unsigned long) (record->numberOfPages * PAGE_SAMPLES));
+        return 1u;
+    }
+
+    for (page = 0; page < record->numberOfPages; page++)
+    {
+        payload = (const int16_t *) (const void *) &image[RecordAddress(record->startSector, page) + PAGE_HEADER_SIZE];
+
+        for (index = 0; index < PAGE_SAMPLES; index++)
+        {
+            if (played[page * PAGE_SAMPLES + index] != payload[index])
+            {
+                printf("verify      page %lu sample %lu played %d, stored %d\n", (unsigned long) page,
+                       (unsigned long) index, played[page * PAGE_SAMPLES + index], payload[index]);
+                return 1u;
+            }
+        }
+    }
+
+    printf("verify      %lu samples played as stored\n", (unsigned long) frames);
+
+    return 0u;
+}
+
+/* Address of a page, as the recorder wraps it past the info sectors */
+static uint32_t RecordAddress(uint32_t sector, uint32_t page)
+{
+    uint32_t memAddress = (sector * SECTOR_SIZE) + (page * PACKET_SIZE);
+
+    if (memAddress >= (SECTOR_SIZE*NUM_SECTORS_IN_MEM))
+    {
+        memAddress = (FIRST_RECORD_SECTOR*SECTOR_SIZE) + memAddress-(SECTOR_SIZE*NUM_SECTORS_IN_MEM);
+    }
+
+    return memAddress;
+}
+
+static void PrintLatency(const char *name, mem_lat_op_t op)
+{
+    mem_latency_t latency;
+
+    MemoryLatency(op, &latency);
+    printf("latency     %-12s %6lu ops, min %lu us, mean %llu us, max %lu us\n", name,
+           (unsigned long) latency.count, (unsigned long) ((latency.count != 0u) ? latency.minUs : 0u),
+           (unsigned long long) ((latency.count != 0u) ? (latency.totalUs / latency.count) : 0u),
+           (unsigned long) latency.maxUs);
+}
+
+/* BenchmarkMemory over the last sectors, then stop. The cycles are those of
+   the board only, the host counts the interrupts each transport takes */
+static void RunBenchmark(uint32_t sectors)
+{
+    static uint8_t buffer[PACKET_SIZE];
+    const smif_host_stats_t *smif = SmifHostStats();
+    mem_bench_t bench;
+
+    if ((sectors == 0u) || (sectors > (NUM_SECTORS_IN_MEM - FIRST_RECORD_SECTOR)))
+    {
+        fprintf(stderr, "recorder_host: %lu sectors to benchmark\n", (unsigned long) sectors);
+        hostFailures++;
+    }
+    else
+    {
+        BenchmarkMemory(NUM_SECTORS_IN_MEM - sectors, sectors, buffer, &bench);
+
+        printf("bench       erase %lu kB/s, program %lu kB/s, read %lu kB/s over %lu sectors\n",
+               (unsigned long) bench.eraseKBps, (unsigned long) bench.programKBps,
+               (unsigned long) bench.readKBps, (unsigned long) sectors);
+        PrintXferCost("SMIF ISR", &bench.isr);
+        PrintXferCost("SMIF DMA", &bench.dma);
+        printf("memory      FIFO interrupts %lu, DMA data phases %lu\n",
+               (unsigned long) smif->fifoInterrupts, (unsigned long) smif->dmaPhases);
+
+        if (smif->violations != 0u)
+        {
+            printf("violations  memory %lu\n", (unsigned long) smif->violations);
+            hostFailures++;
+        }
+    }
+
+    printf("result      %s\n", (hostFailures == 0u) ? "pass" : "FAIL");
+
+    hostDone = true;
+    HostStopScheduler();
+}
+
+static void PrintXferCost(const char *name, const mem_bench_xfer_t *cost)
+{
+    uint32_t pages = (cost->pages != 0u) ? cost->pages : 1u;
+
+    printf("xfer        %-8s %6lu pages, %lu.%02lu interrupts per page, %lu cycles per page\n", name,
+           (unsigned long) cost->pages, (unsigned long) (cost->interrupts / pages),
+           (unsigned long) (((cost->interrupts % pages) * 100u) / pages),
+           (unsigned long) (cost->cycles / pages));
+}
+
+static void Usage(const char *name)
+{
+    fprintf(stderr, "usage: %s [-s seconds] [-f format] [-r rate] [-i image] [-p programUs] [-e eraseUs] [-w settleMs] [-b sectors] [-l pages]\n", name);
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,1075 @@
+/******************************************************************************
+* File Name: rtos_host.c
+*
+* Version: 1.0
+*
+* Description: Deterministic FreeRTOS model for the host. The tasks run one at
+*              a time on a virtual microsecond clock that advances only when
+*              every task is blocked, so a run gives the same timings on any
+*              machine.
+*
+* Related Document: N/A
+*
+* Hardware Dependency: None, built for a Linux host
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include "host.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "event_groups.h"
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+typedef enum
+{
+    HOST_TASK_READY     = 0x00u,    /* Running or ready to run */
+    HOST_TASK_BLOCKED   = 0x01u,    /* Waiting for an object or a time */
+}   host_task_state_t;
+
+typedef struct host_task
+{
+    ucontext_t          context;    /* Saved while not running */
+    TaskFunction_t      function;
+    void                *arg;
+    char                name[configMAX_TASK_NAME_LEN];
+    UBaseType_t         priority;   /* Raised while holding a mutex a higher task waits for */
+    UBaseType_t         basePriority;
+    host_task_state_t   state;
+    const void          *waitObject;/* Object the task is blocked on */
+    uint64_t            wakeUs;     /* Timeout of the block */
+    uint64_t            order;      /* Ready tasks of a priority run in this order */
+    uint32_t            notifyValue;
+    void                *stack;
+}   host_task_t;
+
+/* Queues, semaphores and mutexes */
+typedef struct
+{
+    uint8_t             *storage;
+    UBaseType_t         length;
+    UBaseType_t         itemSize;
+    UBaseType_t         count;
+    UBaseType_t         head;
+    bool                mutex;
+    host_task_t         *holder;    /* Task holding the mutex */
+}   host_queue_t;
+
+typedef struct
+{
+    EventBits_t         bits;
+}   host_event_group_t;
+
+/* Event run in the interrupt context */
+typedef struct
+{
+    bool                used;
+    uint64_t            timeUs;
+    uint64_t            order;      /* Events at the same time run in the order given */
+    host_event_t        event;
+    void                *arg;
+}   host_timed_t;
+
+/*******************************************************************************
+*            Local Functions
+*******************************************************************************/
+static void HostTaskEntry(void);
+static host_task_t * HostNextReady(void);
+static void HostReady(host_task_t *task);
+static void HostSwitch(void);
+static void HostAdvance(void);
+static void HostRunEvents(void);
+static void HostBlock(const void *object, uint64_t deadline);
+static bool HostSignal(const void *object);
+static void HostPreempt(void);
+static uint64_t HostDeadline(TickType_t ticks);
+static void HostFatal(const char *message);
+static BaseType_t HostQueueSend(host_queue_t *queue, const void *item, TickType_t ticks, bool front);
+static BaseType_t HostQueueRead(host_queue_t *queue, void *item, TickType_t ticks, bool remove);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define HOST_MAX_TASKS      (8u)
+#define HOST_MAX_EVENTS     (64u)
+#define HOST_STACK_SIZE     (1024u*1024u)   /* Host frames are larger than the CM4 ones */
+#define HOST_FOREVER        (UINT64_MAX)
+
+/*******************************************************************************
+*            Internal Global Variables
+*******************************************************************************/
+uint32_t SystemCoreClock = HOST_CORE_CLOCK_HZ;  /* Scales the DWT counter */
+uint32_t cy_delayFreqHz = HOST_CORE_CLOCK_HZ;
+DWT_Type hostDwt;                           /* Cycle counter, from hostTime */
+CoreDebug_Type hostCoreDebug;
+host_task_t hostTasks[HOST_MAX_TASKS];      /* Tasks created */
+uint32_t hostTaskCount = 0;
+host_task_t *hostCurrent = NULL;            /* Task running */
+ucontext_t hostMainContext;                 /* Returned to by HostStopScheduler */
+bool hostRunning = false;                   /* Between vTaskStartScheduler and HostStopScheduler */
+uint64_t hostTime = 0;                      /* Simulated time in us */
+uint64_t hostLimit = HOST_FOREVER;          /* Time the simulation stops */
+uint64_t hostOrder = 0;                     /* Order of the ready tasks and of the events */
+uint32_t hostSuspended = 0;                 /* vTaskSuspendAll nesting */
+uint32_t hostCritical = 0;                  /* Critical section nesting */
+bool hostYieldPending = false;              /* Higher task woken while switches were held */
+bool hostIsr = false;                       /* Running an interrupt handler */
+uint32_t hostSwitches = 0;                  /* Context switches */
+host_timed_t hostEvents[HOST_MAX_EVENTS];   /* Interrupts to come */
+cy_israddress hostVectors[HOST_IRQ_COUNT];  /* Handlers set by Cy_SysInt_Init */
+bool hostIrqEnabled[HOST_IRQ_COUNT];        /* NVIC enable */
+bool hostIrqPending[HOST_IRQ_COUNT];        /* Raised while disabled */
+bool hostIrqMasked = false;                 /* __disable_irq */
+const uint8_t hostDelayObject = 0;          /* Blocked in vTaskDelay, never signalled */
+
+/*******************************************************************************
+* Function Name: xTaskCreate
+********************************************************************************
+* Summary:
+*   This function creates a task on its own host stack. It starts running when
+*   the scheduler picks it, right away if it has a higher priority than the
+*   task creating it.
+*
+*******************************************************************************/
+BaseType_t xTaskCreate(TaskFunction_t pxTaskCode, const char * const pcName,
+                    const uint16_t usStackDepth, void * const pvParameters,
+                    UBaseType_t uxPriority, TaskHandle_t * const pxCreatedTask)
+{
+    host_task_t *task;
+
+    (void) usStackDepth;
+
+    if (hostTaskCount >= HOST_MAX_TASKS)
+    {
+        return pdFAIL;
+    }
+
+    task = &hostTasks[hostTaskCount];
+    memset(task, 0, sizeof(*task));
+    task->function = pxTaskCode;
+    task->arg = pvParameters;
+    strncpy(task->name, pcName, sizeof(task->name) - 1u);
+    task->priority = uxPriority;
+    task->basePriority = uxPriority;
+    task->stack = malloc(HOST_STACK_SIZE);
+    if (task->stack == NULL)
+    {
+        return pdFAIL;
+    }
+
+    getcontext(&task->context);
+    task->context.uc_stack.ss_sp = task->stack;
+    task->context.uc_stack.ss_size = HOST_STACK_SIZE;
+    task->context.uc_link = NULL;
+    makecontext(&task->context, HostTaskEntry, 0);
+
+    hostTaskCount++;
+    HostReady(task);
+
+    if (pxCreatedTask != NULL)
+    {
+        *pxCreatedTask = task;
+    }
+
+    HostPreempt();
+
+    return pdPASS;
+}
+
+/* First function of every task, a task must not return */
+static void HostTaskEntry(void)
+{
+    hostCurrent->function(hostCurrent->arg);
+
+    HostFatal("task returned");
+}
+
+/*******************************************************************************
+* Function Name: vTaskStartScheduler
+********************************************************************************
+* Summary:
+*   This function runs the tasks until HostStopScheduler, the time limit, or
+*   until all of them are blocked for ever.
+*
+*******************************************************************************/
+void vTaskStartScheduler(void)
+{
+    host_task_t *first = HostNextReady();
+
+    if (first == NULL)
+    {
+        return;
+    }
+
+    hostRunning = true;
+    hostCurrent = first;
+    swapcontext(&hostMainContext, &first->context);
+    hostCurrent = NULL;
+}
+
+/*******************************************************************************
+* Function Name: HostStopScheduler
+********************************************************************************
+* Summary:
+*   This function returns from vTaskStartScheduler. The tasks are left where
+*   they are, the simulation cannot be resumed.
+*
+*******************************************************************************/
+void HostStopScheduler(void)
+{
+    if (hostRunning)
+    {
+        hostRunning = false;
+        swapcontext(&hostCurrent->context, &hostMainContext);
+    }
+}
+
+/*******************************************************************************
+* Function Name: HostTimeLimit
+********************************************************************************
+* Summary:
+*   This function sets the simulated time at which the scheduler stops, should
+*   the scenario never end.
+*
+* Parameters:
+*   timeUs: Simulated time in microseconds.
+*
+*******************************************************************************/
+void HostTimeLimit(uint64_t timeUs)
+{
+    hostLimit = timeUs;
+}
+
+/*******************************************************************************
+* Function Name: HostTimeUs
+********************************************************************************
+* Summary:
+*   Return the simulated time in microseconds. It only moves while all the tasks
+*   are blocked: the code runs in no time, the memory and the audio blocks set
+*   the pace.
+*
+*******************************************************************************/
+uint64_t HostTimeUs(void)
+{
+    return hostTime;
+}
+
+/*******************************************************************************
+* Function Name: HostContextSwitches
+********************************************************************************
+* Summary:
+*   Return the number of context switches since the start.
+*
+*******************************************************************************/
+uint32_t HostContextSwitches(void)
+{
+    return hostSwitches;
+}
+
+/*******************************************************************************
+* Function Name: HostAt
+********************************************************************************
+* Summary:
+*   This function runs an event in the interrupt context at a simulated time.
+*   Events at the same time run in the order they were given, an event in the
+*   past runs as soon as all the tasks are blocked.
+*
+* Parameters:
+*   timeUs: Simulated time in microseconds.
+*   event: Function to run.
+*   arg: Argument of the function.
+*
+*******************************************************************************/
+void HostAt(uint64_t timeUs, host_event_t event, void *arg)
+{
+    uint32_t index;
+
+    for (index = 0; index < HOST_MAX_EVENTS; index++)
+    {
+        if (!hostEvents[index].used)
+        {
+            hostEvents[index].used = true;
+            hostEvents[index].timeUs = timeUs;
+            hostEvents[index].order = ++hostOrder;
+            hostEvents[index].event = event;
+            hostEvents[index].arg = arg;
+            return;
+        }
+    }
+
+    HostFatal("too many events");
+}
+
+/*******************************************************************************
+* Function Name: HostRaiseIrq
+********************************************************************************
+* Summary:
+*   This function runs the handler of an interrupt, or keeps it pending while
+*   the interrupt is disabled or masked.
+*
+* Parameters:
+*   irq: The interrupt.
+*
+*******************************************************************************/
+void HostRaiseIrq(IRQn_Type irq)
+{
+    bool isr = hostIsr;
+
+    if ((hostVectors[irq] == NULL) || !hostIrqEnabled[irq] || hostIrqMasked)
+    {
+        hostIrqPending[irq] = true;
+        return;
+    }
+
+    hostIrqPending[irq] = false;
+    hostIsr = true;
+    hostVectors[irq]();
+    hostIsr = isr;
+
+    /* Raised by a task, return to the task woken */
+    HostPreempt();
+}
+
+/* Highest priority ready task, the one ready first among equals */
+static host_task_t * HostNextReady(void)
+{
+    host_task_t *next = NULL;
+    uint32_t index;
+
+    for (index = 0; index < hostTaskCount; index++)
+    {
+        host_task_t *task = &hostTasks[index];
+
+        if ((task->state == HOST_TASK_READY) &&
+            ((next == NULL) || (task->priority > next->priority) ||
+             ((task->priority == next->priority) && (task->order < next->order))))
+        {
+            next = task;
+        }
+    }
+
+    return next;
+}
+
+/* Make a task ready, behind the ready ones of its priority */
+static void HostReady(host_task_t *task)
+{
+    task->state = HOST_TASK_READY;
+    task->waitObject = NULL;
+    task->order = ++hostOrder;
+}
+
+/* Give the CPU to the next ready task, moving the time on when none is ready */
+static void HostSwitch(void)
+{
+    host_task_t *self = hostCurrent;
+    host_task_t *next;
+
+    while ((next = HostNextReady()) == NULL)
+    {
+        HostAdvance();
+    }
+
+    if (next != self)
+    {
+        hostSwitches++;
+        hostCurrent = next;
+        swapcontext(&self->context, &next->context);
+    }
+}
+
+/* Move the time to the next event or timeout, run the interrupts due and wake the tasks */
+static void HostAdvance(void)
+{
+    uint64_t next = HOST_FOREVER;
+    uint32_t index;
+
+    for (index = 0; index < hostTaskCount; index++)
+    {
+        if ((hostTasks[index].state == HOST_TASK_BLOCKED) && (hostTasks[index].wakeUs < next))
+        {
+            next = hostTasks[index].wakeUs;
+        }
+    }
+    for (index = 0; index < HOST_MAX_EVENTS; index++)
+    {
+        if (hostEvents[index].used && (hostEvents[index].timeUs < next))
+        {
+            next = hostEvents[index].timeUs;
+        }
+    }
+
+    if (next == HOST_FOREVER)
+    {
+        fprintf(stderr, "rtos_host: all tasks blocked for ever at %llu us\n", (unsigned long long) hostTime);
+        for (index = 0; index < hostTaskCount; index++)
+        {
+            fprintf(stderr, "rtos_host:   %s blocked on %p\n", hostTasks[index].name, hostTasks[index].waitObject);
+        }
+        HostStopScheduler();
+    }
+    if (next > hostLimit)
+    {
+        fprintf(stderr, "rtos_host: time limit reached at %llu us\n", (unsigned long long) hostLimit);
+        hostTime = hostLimit;
+        HostStopScheduler();
+    }
+
+    if (next > hostTime)
+    {
+        hostTime = next;
+    }
+
+    /* The interrupts first, the tasks they wake see the timeouts as well */
+    HostRunEvents();
+
+    for (index = 0; index < hostTaskCount; index++)
+    {
+        if ((hostTasks[index].state == HOST_TASK_BLOCKED) && (hostTasks[index].wakeUs <= hostTime))
+        {
+            HostReady(&hostTasks[index]);
+        }
+    }
+}
+
+/* Run the events due, in time order, including those they add for now */
+static void HostRunEvents(void)
+{
+    host_timed_t *first;
+    host_event_t event;
+    void *arg;
+    uint32_t index;
+
+    do
+    {
+        first = NULL;
+        for (index = 0; index < HOST_MAX_EVENTS; index++)
+        {
+            host_timed_t *timed = &hostEvents[index];
+
+            if (timed->used && (timed->timeUs <= hostTime) &&
+                ((first == NULL) || (timed->timeUs < first->timeUs) ||
+                 ((timed->timeUs == first->timeUs) && (timed->order < first->order))))
+            {
+                first = timed;
+            }
+        }
+
+        if (first != NULL)
+        {
+            event = first->event;
+            arg = first->arg;
+            first->used = false;
+
+            hostIsr = true;
+            event(arg);
+            hostIsr = false;
+        }
+    } while (first != NULL);
+}
+
+/* Block the running task until the object is signalled or the deadline */
+static void HostBlock(const void *object, uint64_t deadline)
+{
+    if (hostIsr || (hostSuspended != 0u) || (hostCritical != 0u) || !hostRunning)
+    {
+        HostFatal("blocking call with the scheduler suspended");
+    }
+
+    hostCurrent->state = HOST_TASK_BLOCKED;
+    hostCurrent->waitObject = object;
+    hostCurrent->wakeUs = deadline;
+
+    HostSwitch();
+}
+
+/* Wake the tasks blocked on an object, they check it again. Return true if one
+   of them has a higher priority than the running task */
+static bool HostSignal(const void *object)
+{
+    bool higher = false;
+    uint32_t index;
+
+    for (index = 0; index < hostTaskCount; index++)
+    {
+        host_task_t *task = &hostTasks[index];
+
+        if ((task->state == HOST_TASK_BLOCKED) && (task->waitObject == object))
+        {
+            HostReady(task);
+            higher |= (hostCurrent == NULL) || (task->priority > hostCurrent->priority);
+        }
+    }
+
+    return higher;
+}
+
+/* Switch to a higher priority task made ready, once the switches are allowed */
+static void HostPreempt(void)
+{
+    host_task_t *next;
+
+    if (hostIsr || !hostRunning || (hostCurrent == NULL))
+    {
+        return;
+    }
+
+    next = HostNextReady();
+    if ((next == NULL) || (next->priority <= hostCurrent->priority))
+    {
+        return;
+    }
+
+    if ((hostSuspended != 0u) || (hostCritical != 0u))
+    {
+        hostYieldPending = true;
+        return;
+    }
+
+    hostYieldPending = false;
+    HostReady(hostCurrent);
+    HostSwitch();
+}
+
+/* Time a block with a timeout in ticks ends, on a tick boundary */
+static uint64_t HostDeadline(TickType_t ticks)
+{
+    if (ticks == portMAX_DELAY)
+    {
+        return HOST_FOREVER;
+    }
+
+    return ((hostTime / HOST_TICK_US) + ticks) * HOST_TICK_US;
+}
+
+/* Misuse of the RTOS, the simulation cannot go on */
+static void HostFatal(const char *message)
+{
+    fprintf(stderr, "rtos_host: %s at %llu us in %s\n", message, (unsigned long long) hostTime,
+            (hostCurrent != NULL) ? hostCurrent->name : "main");
+    exit(3);
+}
+
+/*******************************************************************************
+*            Tasks
+*******************************************************************************/
+void vTaskDelay(const TickType_t xTicksToDelay)
+{
+    uint64_t deadline = HostDeadline(xTicksToDelay);
+
+    if (xTicksToDelay == 0u)
+    {
+        HostReady(hostCurrent);
+        HostSwitch();
+        return;
+    }
+
+    while (hostTime < deadline)
+    {
+        HostBlock(&hostDelayObject, deadline);
+    }
+}
+
+void vTaskDelayUntil(TickType_t * const pxPreviousWakeTime, const TickType_t xTimeIncrement)
+{
+    TickType_t wake = *pxPreviousWakeTime + xTimeIncrement;
+    TickType_t ticks = wake - xTaskGetTickCount();
+
+    *pxPreviousWakeTime = wake;
+
+    /* Not late, the difference did not wrap */
+    if ((ticks != 0u) && (ticks <= xTimeIncrement))
+    {
+        vTaskDelay(ticks);
+    }
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t) (hostTime / HOST_TICK_US);
+}
+
+TickType_t xTaskGetTickCountFromISR(void)
+{
+    return xTaskGetTickCount();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return hostCurrent;
+}
+
+void vTaskSuspendAll(void)
+{
+    hostSuspended++;
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+    uint32_t switches = hostSwitches;
+
+    hostSuspended--;
+
+    if ((hostSuspended == 0u) && hostYieldPending)
+    {
+        HostPreempt();
+    }
+
+    return (hostSwitches != switches) ? pdTRUE : pdFALSE;
+}
+
+void HostEnterCritical(void)
+{
+    hostCritical++;
+}
+
+void HostExitCritical(void)
+{
+    hostCritical--;
+
+    if ((hostCritical == 0u) && (hostSuspended == 0u) && hostYieldPending)
+    {
+        HostPreempt();
+    }
+}
+
+/* The scheduler runs the task woken once the interrupt handler returns */
+void HostYieldFromIsr(BaseType_t higherPriorityTaskWoken)
+{
+    (void) higherPriorityTaskWoken;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t xClearCountOnExit, TickType_t xTicksToWait)
+{
+    host_task_t *self = hostCurrent;
+    uint64_t deadline = HostDeadline(xTicksToWait);
+    uint32_t value;
+
+    while (self->notifyValue == 0u)
+    {
+        if ((xTicksToWait == 0u) || (hostTime >= deadline))
+        {
+            return 0;
+        }
+        HostBlock(self, deadline);
+    }
+
+    value = self->notifyValue;
+    self->notifyValue = (xClearCountOnExit != pdFALSE) ? 0u : (value - 1u);
+
+    return value;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t xTaskToNotify)
+{
+    host_task_t *task = (host_task_t *) xTaskToNotify;
+
+    task->notifyValue++;
+    (void) HostSignal(task);
+    HostPreempt();
+
+    return pdPASS;
+}
+
+void vTaskNotifyGiveFromISR(TaskHandle_t xTaskToNotify, BaseType_t *pxHigherPriorityTaskWoken)
+{
+    host_task_t *task = (host_task_t *) xTaskToNotify;
+
+    task->notifyValue++;
+    if (HostSignal(task) && (pxHigherPriorityTaskWoken != NULL))
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+}
+
+/*******************************************************************************
+*            Queues, semaphores and mutexes
+*******************************************************************************/
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize)
+{
+    host_queue_t *queue = calloc(1, sizeof(host_queue_t));
+
+    if (queue != NULL)
+    {
+        queue->length = uxQueueLength;
+        queue->itemSize = uxItemSize;
+        queue->storage = calloc(uxQueueLength, (uxItemSize != 0u) ? uxItemSize : 1u);
+    }
+
+    return queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait)
+{
+    return HostQueueSend(xQueue, pvItemToQueue, xTicksToWait, false);
+}
+
+BaseType_t xQueueSendToFront(QueueHandle_t xQueue, const void * const pvItemToQueue, TickType_t xTicksToWait)
+{
+    return HostQueueSend(xQueue, pvItemToQueue, xTicksToWait, true);
+}
+
+BaseType_t xQueueSendFromISR(QueueHandle_t xQueue, const void * const pvItemToQueue,
+                    BaseType_t * const pxHigherPriorityTaskWoken)
+{
+    host_queue_t *queue = xQueue;
+
+    if (queue->count >= queue->length)
+    {
+        return errQUEUE_FULL;
+    }
+
+    memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->itemSize],
+           pvItemToQueue, queue->itemSize);
+    queue->count++;
+
+    if (HostSignal(queue) && (pxHigherPriorityTaskWoken != NULL))
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait)
+{
+    return HostQueueRead(xQueue, pvBuffer, xTicksToWait, true);
+}
+
+BaseType_t xQueuePeek(QueueHandle_t xQueue, void * const pvBuffer, TickType_t xTicksToWait)
+{
+    return HostQueueRead(xQueue, pvBuffer, xTicksToWait, false);
+}
+
+UBaseType_t uxQueueMessagesWaiting(const QueueHandle_t xQueue)
+{
+    return ((host_queue_t *) xQueue)->count;
+}
+
+UBaseType_t uxQueueSpacesAvailable(const QueueHandle_t xQueue)
+{
+    return ((host_queue_t *) xQueue)->length - ((host_queue_t *) xQueue)->count;
+}
+
+/* Copy an item in, at the back or the front, waiting for room */
+static BaseType_t HostQueueSend(host_queue_t *queue, const void *item, TickType_t ticks, bool front)
+{
+    uint64_t deadline = HostDeadline(ticks);
+
+    while (queue->count >= queue->length)
+    {
+        if ((ticks == 0u) || (hostTime >= deadline))
+        {
+            return errQUEUE_FULL;
+        }
+        HostBlock(queue, deadline);
+    }
+
+    if (front)
+    {
+        queue->head = (queue->head + queue->length - 1u) % queue->length;
+        memcpy(&queue->storage[queue->head * queue->itemSize], item, queue->itemSize);
+    }
+    else
+    {
+        memcpy(&queue->storage[((queue->head + queue->count) % queue->length) * queue->itemSize],
+               item, queue->itemSize);
+    }
+    queue->count++;
+
+    (void) HostSignal(queue);
+    HostPreempt();
+
+    return pdPASS;
+}
+
+/* Copy the first item out, removing it or not, waiting for one */
+static BaseType_t HostQueueRead(host_queue_t *queue, void *item, TickType_t ticks, bool remove)
+{
+    uint64_t deadline = HostDeadline(ticks);
+
+    while (queue->count == 0u)
+    {
+        if ((ticks == 0u) || (hostTime >= deadline))
+        {
+            return errQUEUE_EMPTY;
+        }
+        HostBlock(queue, deadline);
+    }
+
+    memcpy(item, &queue->storage[queue->head * queue->itemSize], queue->itemSize);
+
+    if (remove)
+    {
+        queue->head = (queue->head + 1u) % queue->length;
+        queue->count--;
+
+        (void) HostSignal(queue);
+        HostPreempt();
+    }
+
+    return pdPASS;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return xQueueCreate(1u, 0u);
+}
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    host_queue_t *queue = xQueueCreate(1u, 0u);
+
+    if (queue != NULL)
+    {
+        queue->mutex = true;
+        queue->count = 1u;
+    }
+
+    return queue;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t xSemaphore, TickType_t xBlockTime)
+{
+    host_queue_t *queue = xSemaphore;
+    uint64_t deadline = HostDeadline(xBlockTime);
+
+    while (queue->count == 0u)
+    {
+        if ((xBlockTime == 0u) || (hostTime >= deadline))
+        {
+            return pdFAIL;
+        }
+
+        /* The holder inherits the priority of the tasks waiting */
+        if (queue->mutex && (queue->holder->priority < hostCurrent->priority))
+        {
+            queue->holder->priority = hostCurrent->priority;
+        }
+        HostBlock(queue, deadline);
+    }
+
+    queue->count = 0u;
+    queue->holder = queue->mutex ? hostCurrent : NULL;
+
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t xSemaphore)
+{
+    host_queue_t *queue = xSemaphore;
+
+    if ((queue->count != 0u) || (queue->mutex && (queue->holder != hostCurrent)))
+    {
+        return pdFAIL;
+    }
+
+    if (queue->mutex)
+    {
+        hostCurrent->priority = hostCurrent->basePriority;
+        queue->holder = NULL;
+    }
+    queue->count = 1u;
+
+    (void) HostSignal(queue);
+    HostPreempt();
+
+    return pdPASS;
+}
+
+BaseType_t xSemaphoreGiveFromISR(SemaphoreHandle_t xSemaphore, BaseType_t * const pxHigherPriorityTaskWoken)
+{
+    host_queue_t *queue = xSemaphore;
+
+    if (queue->count != 0u)
+    {
+        return pdFAIL;
+    }
+
+    queue->count = 1u;
+    if (HostSignal(queue) && (pxHigherPriorityTaskWoken != NULL))
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+
+    return pdPASS;
+}
+
+/*******************************************************************************
+*            Event groups
+*******************************************************************************/
+EventGroupHandle_t xEventGroupCreate(void)
+{
+    return calloc(1, sizeof(host_event_group_t));
+}
+
+EventBits_t xEventGroupWaitBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToWaitFor,
+                    const BaseType_t xClearOnExit, const BaseType_t xWaitForAllBits,
+                    TickType_t xTicksToWait)
+{
+    host_event_group_t *group = xEventGroup;
+    uint64_t deadline = HostDeadline(xTicksToWait);
+    EventBits_t bits;
+
+    while ((xWaitForAllBits != pdFALSE) ? ((group->bits & uxBitsToWaitFor) != uxBitsToWaitFor) :
+                                          ((group->bits & uxBitsToWaitFor) == 0u))
+    {
+        if ((xTicksToWait == 0u) || (hostTime >= deadline))
+        {
+            return group->bits;
+        }
+        HostBlock(group, deadline);
+    }
+
+    bits = group->bits;
+    if (xClearOnExit != pdFALSE)
+    {
+        group->bits &= ~uxBitsToWaitFor;
+    }
+
+    return bits;
+}
+
+EventBits_t xEventGroupSetBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet)
+{
+    host_event_group_t *group = xEventGroup;
+    EventBits_t bits;
+
+    group->bits |= uxBitsToSet;
+    bits = group->bits;
+
+    (void) HostSignal(group);
+    HostPreempt();
+
+    return bits;
+}
+
+/* The board defers it to the timer task, the host sets the bits at once */
+BaseType_t xEventGroupSetBitsFromISR(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToSet,
+                    BaseType_t *pxHigherPriorityTaskWoken)
+{
+    host_event_group_t *group = xEventGroup;
+
+    group->bits |= uxBitsToSet;
+    if (HostSignal(group) && (pxHigherPriorityTaskWoken != NULL))
+    {
+        *pxHigherPriorityTaskWoken = pdTRUE;
+    }
+
+    return pdPASS;
+}
+
+EventBits_t xEventGroupClearBits(EventGroupHandle_t xEventGroup, const EventBits_t uxBitsToClear)
+{
+    host_event_group_t *group = xEventGroup;
+    EventBits_t bits = group->bits;
+
+    group->bits &= ~uxBitsToClear;
+
+    return bits;
+}
+
+EventBits_t xEventGroupGetBits(EventGroupHandle_t xEventGroup)
+{
+    return ((host_event_group_t *) xEventGroup)->bits;
+}
+
+/*******************************************************************************
+*            Interrupts and cycle counter
+*******************************************************************************/
+cy_en_sysint_status_t Cy_SysInt_Init(const cy_stc_sysint_t *config, cy_israddress userIsr)
+{
+    if ((config->intrSrc < 0) || (config->intrSrc >= HOST_IRQ_COUNT))
+    {
+        return CY_SYSINT_BAD_PARAM;
+    }
+
+    hostVectors[config->intrSrc] = userIsr;
+
+    return CY_SYSINT_SUCCESS;
+}
+
+void NVIC_EnableIRQ(IRQn_Type irq)
+{
+    hostIrqEnabled[irq] = true;
+
+    if (hostIrqPending[irq])
+    {
+        HostRaiseIrq(irq);
+    }
+}
+
+void NVIC_DisableIRQ(IRQn_Type irq)
+{
+    hostIrqEnabled[irq] = false;
+}
+
+void NVIC_ClearPendingIRQ(IRQn_Type irq)
+{
+    hostIrqPending[irq] = false;
+}
+
+void __disable_irq(void)
+{
+    hostIrqMasked = true;
+}
+
+void __enable_irq(void)
+{
+    IRQn_Type irq;
+
+    hostIrqMasked = false;
+
+    for (irq = (IRQn_Type) 0; irq < HOST_IRQ_COUNT; irq++)
+    {
+        if (hostIrqPending[irq] && hostIrqEnabled[irq])
+        {
+            HostRaiseIrq(irq);
+        }
+    }
+}
+
+/* The cycle counter follows the simulated time */
+DWT_Type * HostDwt(void)
+{
+    hostDwt.CYCCNT = (uint32_t) (hostTime * (SystemCoreClock / 1000000u));
+
+    return &hostDwt;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,1007 @@
+/******************************************************************************
+* File Name: smif_host.c
+*
+* Version: 1.0
+*
+* Description: SMIF and S25FL512S model for the host. The memory image is a
+*              RAM or file image with NOR semantics: programs only clear bits,
+*              erases set a sector to 0xFF, and the program, erase and read
+*              latencies are configurable. The commands that break the device
+*              rules are counted as violations.
+*
+* Related Document: N/A
+*
+* Hardware Dependency: None, built for a Linux host
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "smif_mem.h"
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+
+/* Data phase started by CmdProgram or CmdRead, completed by Cy_SMIF_Interrupt */
+typedef enum
+{
+    SMIF_XFER_NONE      = 0x00u,
+    SMIF_XFER_PROGRAM   = 0x01u,
+    SMIF_XFER_READ      = 0x02u,
+}   smif_xfer_t;
+
+/*******************************************************************************
+*            Local Functions
+*******************************************************************************/
+static void SmifHostUpdate(void);
+static void SmifHostStart(smif_xfer_t xfer, uint8_t *buffer, uint32_t size, uint32_t address);
+static void SmifHostXferDone(void *arg);
+static void SmifHostDmaDone(void *arg);
+static void SmifHostComplete(void);
+static bool SmifHostDmaReady(smif_xfer_t xfer, uint32_t size);
+static bool SmifHostRouted(uint32_t request, uint32_t channel);
+static bool SmifHostCheck(const char *command, bool allowSuspended);
+static bool SmifHostRange(uint32_t address, uint32_t size);
+static void SmifHostViolation(const char *message, uint32_t address);
+static void ProgramImage(const uint8_t *data, uint32_t size, uint32_t address);
+static uint32_t AddressBytes(uint8_t const *addr);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define SMIF_HOST_SIZE          (SECTOR_SIZE * NUM_SECTORS_IN_MEM)
+#define SMIF_HOST_PAGE          (512u)      /* Program buffer, the address wraps inside */
+#define SMIF_HOST_REPORTS       (8u)        /* Violations printed, the others are counted */
+#define SMIF_HOST_STS1_WIP      (0x01u)     /* Status register 1 write in progress */
+#define SMIF_HOST_FIFO_BYTES    (8u)        /* Entries of the TX and RX data FIFOs */
+#define SMIF_HOST_ROUTES        (16u)       /* Trigger connections kept */
+#define SMIF_HOST_GROUP1_FIRST  (27u)       /* Group 1 input of the group 13 output 16 */
+#define SMIF_HOST_NO_LEVEL      (0xFFFFFFFFu)
+
+/*******************************************************************************
+*            Internal Global Variables
+*******************************************************************************/
+SMIF_Type hostSmif;
+DW_Type hostDw1;
+cy_stc_smif_config_t SMIF_1_config;
+cy_stc_smif_context_t SMIF_1_context;
+GPIO_PRT_Type hostRedLedPort;
+
+cy_stc_smif_mem_config_t smifMem0 =         /* The S25FL512S of the kit */
+{
+    .slaveSelect = CY_SMIF_SLAVE_SELECT_0,
+    .flags = 0u,
+    .dataSelect = CY_SMIF_DATA_SEL0,
+    .baseAddress = 0u,                      /* The image, set by SmifHostOpen */
+    .memMappedSize = SMIF_HOST_SIZE,
+    .dualQuadSlots = false,
+    .deviceCfg = NULL,
+};
+cy_stc_smif_mem_config_t* smifMemConfigs[1] = { &smifMem0 };
+cy_stc_smif_block_config_t smifBlockConfig =
+{
+    .memCount = 1u,
+    .memConfig = smifMemConfigs,
+    .majorVersion = 1u,
+    .minorVersion = 0u,
+};
+
+uint8_t *smifImage = NULL;                  /* Content of the memory */
+char smifPath[256];                         /* File backing the image, empty for RAM */
+smif_host_timing_t smifTiming;              /* Latencies */
+smif_host_stats_t smifStats;                /* Counters */
+bool smifEnabled = false;                   /* Cy_SMIF_Enable called */
+bool smifMapped = false;                    /* SMIF in memory-mapped mode */
+bool smifWel = false;                       /* Write enable latch */
+bool smifQe = false;                        /* Quad enable bit, non-volatile */
+uint64_t smifBusyUntil = 0;                 /* End of the program or erase (WIP) */
+smif_xfer_t smifXfer = SMIF_XFER_NONE;      /* Data phase in progress */
+uint8_t *smifXferBuffer = NULL;
+uint32_t smifXferSize = 0;
+uint32_t smifXferAddress = 0;
+uint32_t smifEraseSector = MEM_NO_SECTOR;   /* Sector being erased, or suspended */
+bool smifEraseSuspended = false;
+uint64_t smifEraseEnd = 0;                  /* End of the erase, while not suspended */
+uint64_t smifEraseLeft = 0;                 /* Erase time left, while suspended */
+bool smifXferDma = false;                   /* Data phase moved by a DW1 channel */
+uint32_t smifXferChunks = 0;                /* FIFO refills left in the data phase */
+uint32_t smifTxLevel = SMIF_HOST_NO_LEVEL;  /* FIFO levels set for the DMA */
+uint32_t smifRxLevel = SMIF_HOST_NO_LEVEL;
+uint32_t smifRoutes[SMIF_HOST_ROUTES][2];   /* Trigger connections, input and output */
+uint32_t smifRouteCount = 0;
+
+/*******************************************************************************
+* Function Name: SmifHostOpen
+********************************************************************************
+* Summary:
+*   This function creates the memory behind the SMIF. A file image is loaded if
+*   it exists, anything missing reads as erased.
+*
+* Parameters:
+*   path: File backing the image, NULL for a RAM image.
+*   timing: Latencies of the memory, NULL for the S25FL512S defaults.
+*
+* Return:
+*   bool: false if the image could not be allocated.
+*
+*******************************************************************************/
+bool SmifHostOpen(const char *path, const smif_host_timing_t *timing)
+{
+    FILE *file;
+
+    SmifHostClose();
+
+    smifImage = malloc(SMIF_HOST_SIZE);
+    if (smifImage == NULL)
+    {
+        return false;
+    }
+    memset(smifImage, 0xFF, SMIF_HOST_SIZE);
+
+    smifPath[0] = '\0';
+    if (path != NULL)
+    {
+        strncpy(smifPath, path, sizeof(smifPath) - 1u);
+        smifPath[sizeof(smifPath) - 1u] = '\0';
+
+        file = fopen(smifPath, "rb");
+        if (file != NULL)
+        {
+            if (fread(smifImage, 1, SMIF_HOST_SIZE, file) == 0u)
+            {
+                /* Empty file, keep the erased image */
+            }
+            fclose(file);
+        }
+    }
+
+    if (timing != NULL)
+    {
+        smifTiming = *timing;
+    }
+    else
+    {
+        smifTiming.commandUs = SMIF_DEF_COMMAND_US;
+        smifTiming.transferNs = SMIF_DEF_TRANSFER_NS;
+        smifTiming.programUs = SMIF_DEF_PROGRAM_US;
+        smifTiming.eraseUs = SMIF_DEF_ERASE_US;
+        smifTiming.suspendUs = SMIF_DEF_SUSPEND_US;
+    }
+
+    memset(&smifStats, 0, sizeof(smifStats));
+    smifMem0.baseAddress = (uintptr_t) smifImage;
+    smifEnabled = false;
+    smifMapped = false;
+    smifWel = false;
+    smifQe = false;
+    smifBusyUntil = 0;
+    smifXfer = SMIF_XFER_NONE;
+    smifEraseSector = MEM_NO_SECTOR;
+    smifEraseSuspended = false;
+    smifTxLevel = SMIF_HOST_NO_LEVEL;
+    smifRxLevel = SMIF_HOST_NO_LEVEL;
+    smifRouteCount = 0;
+    memset(&hostDw1, 0, sizeof(hostDw1));
+
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: SmifHostClose
+********************************************************************************
+* Summary:
+*   This function frees the memory. A file-backed image is written back first,
+*   so the next run mounts what this one recorded. An erase still in progress
+*   leaves its sector as it was.
+*
+*******************************************************************************/
+void SmifHostClose(void)
+{
+    FILE *file;
+
+    if (smifImage == NULL)
+    {
+        return;
+    }
+
+    SmifHostUpdate();
+
+    if (smifPath[0] != '\0')
+    {
+        file = fopen(smifPath, "wb");
+        if (file != NULL)
+        {
+            fwrite(smifImage, 1, SMIF_HOST_SIZE, file);
+            fclose(file);
+        }
+    }
+
+    free(smifImage);
+    smifImage = NULL;
+    smifMem0.baseAddress = 0u;
+}
+
+/*******************************************************************************
+* Function Name: SmifHostStats
+********************************************************************************
+* Summary:
+*   Return the counters of the memory.
+*
+*******************************************************************************/
+const smif_host_stats_t * SmifHostStats(void)
+{
+    return &smifStats;
+}
+
+/*******************************************************************************
+* Function Name: SmifHostImage
+********************************************************************************
+* Summary:
+*   Return the content of the memory, with the erases completed by now.
+*
+*******************************************************************************/
+const uint8_t * SmifHostImage(void)
+{
+    SmifHostUpdate();
+
+    return smifImage;
+}
+
+/*******************************************************************************
+* Function Name: SmifHostMapped
+********************************************************************************
+* Summary:
+*   Return whether a buffer lies in the memory-mapped window.
+*
+* Parameters:
+*   address: Start of the buffer.
+*   size: The size of the buffer.
+*
+*******************************************************************************/
+bool SmifHostMapped(const void *address, uint32_t size)
+{
+    const uint8_t *bytes = address;
+
+    return (smifImage != NULL) && (bytes >= smifImage) && (bytes + size <= smifImage + SMIF_HOST_SIZE);
+}
+
+/*******************************************************************************
+* Function Name: SmifHostXipReady
+********************************************************************************
+* Summary:
+*   Return whether a read of the mapped window returns the memory content: the
+*   SMIF must be in memory mode and the memory neither programming nor erasing.
+*
+*******************************************************************************/
+bool SmifHostXipReady(void)
+{
+    return smifMapped && (HostTimeUs() >= smifBusyUntil);
+}
+
+/*******************************************************************************
+*            SMIF block
+*******************************************************************************/
+cy_en_smif_status_t Cy_SMIF_Init(SMIF_Type *base, cy_stc_smif_config_t const *config,
+                    uint32_t timeout, cy_stc_smif_context_t *context)
+{
+    (void) base;
+    (void) config;
+
+    if (context == NULL)
+    {
+        return CY_SMIF_BAD_PARAM;
+    }
+
+    memset(context, 0, sizeof(*context));
+    context->timeout = timeout;
+
+    return CY_SMIF_SUCCESS;
+}
+
+void Cy_SMIF_SetDataSelect(SMIF_Type *base, cy_en_smif_slave_select_t slaveSelect,
+                    cy_en_smif_data_select_t dataSelect)
+{
+    (void) base;
+    (void) slaveSelect;
+    (void) dataSelect;
+}
+
+void Cy_SMIF_Enable(SMIF_Type *base, cy_stc_smif_context_t *context)
+{
+    (void) base;
+    (void) context;
+
+    smifEnabled = true;
+}
+
+/* The memory must be idle to fetch from the mapped window */
+void Cy_SMIF_SetMode(SMIF_Type *base, cy_en_smif_mode_t mode)
+{
+    (void) base;
+
+    if (mode == CY_SMIF_MEMORY)
+    {
+        SmifHostUpdate();
+        if ((smifXfer != SMIF_XFER_NONE) || (HostTimeUs() < smifBusyUntil))
+        {
+            SmifHostViolation("memory mode while busy", 0u);
+        }
+        if (!smifQe)
+        {
+            SmifHostViolation("memory mode with QE clear", 0u);
+        }
+    }
+
+    smifMapped = (mode == CY_SMIF_MEMORY);
+}
+
+cy_en_smif_status_t Cy_SMIF_CacheInvalidate(SMIF_Type *base, cy_en_smif_cache_t cacheType)
+{
+    (void) base;
+    (void) cacheType;
+
+    return CY_SMIF_SUCCESS;
+}
+
+/* The SMIF is busy during a data phase */
+bool Cy_SMIF_BusyCheck(SMIF_Type const *base)
+{
+    (void) base;
+
+    return (smifXfer != SMIF_XFER_NONE);
+}
+
+/* The levels at which the FIFOs request a DMA word */
+void Cy_SMIF_SetTxFifoTriggerLevel(SMIF_Type *base, uint32_t level)
+{
+    base->TX_DATA_FIFO_CTL = level;
+    smifTxLevel = level;
+}
+
+void Cy_SMIF_SetRxFifoTriggerLevel(SMIF_Type *base, uint32_t level)
+{
+    base->RX_DATA_FIFO_CTL = level;
+    smifRxLevel = level;
+}
+
+/*******************************************************************************
+* Function Name: Cy_SMIF_Interrupt
+********************************************************************************
+* Summary:
+*   This function refills or drains the FIFO, as the PDL does on each trigger 
+*   interrupt of a data phase given a buffer. The last one completes the data
+*   phase and calls the callback given with the command. A page program keeps 
+*   the memory busy for the program time.
+*
+*******************************************************************************/
+void Cy_SMIF_Interrupt(SMIF_Type *base, cy_stc_smif_context_t *context)
+{
+    smif_xfer_t xfer = smifXfer;
+
+    (void) base;
+
+    if ((xfer == SMIF_XFER_NONE) || smifXferDma)
+    {
+        return;
+    }
+
+    /* Not the last FIFO load, the next one comes once this one is out */
+    smifXferChunks--;
+    if (smifXferChunks != 0u)
+    {
+        HostAt(HostTimeUs() + ((SMIF_HOST_FIFO_BYTES * (uint64_t) smifTiming.transferNs + 999u) / 1000u),
+               SmifHostXferDone, NULL);
+        return;
+    }
+
+    SmifHostComplete();
+    context->transferStatus = 0u;
+
+    if (xfer == SMIF_XFER_PROGRAM)
+    {
+        if (context->txCmpltCb != NULL)
+        {
+            context->txCmpltCb(CY_SMIF_SEND_CMPLT);
+        }
+    }
+    else
+    {
+        if (context->rxCmpltCb != NULL)
+        {
+            context->rxCmpltCb(CY_SMIF_REC_CMPLT);
+        }
+    }
+}
+
+/* Only the erase suspend and resume commands are sent as is */
+cy_en_smif_status_t Cy_SMIF_TransmitCommand(SMIF_Type *base, uint8_t cmd,
+                    cy_en_smif_txfr_width_t cmdTxfrWidth, uint8_t const cmdParam[],
+                    uint32_t paramSize, cy_en_smif_txfr_width_t paramTxfrWidth,
+                    cy_en_smif_slave_select_t slaveSelect, uint32_t completeTxfr,
+                    cy_stc_smif_context_t const *context)
+{
+    uint64_t now = HostTimeUs();
+
+    (void) base;
+    (void) cmdTxfrWidth;
+    (void) cmdParam;
+    (void) paramSize;
+    (void) paramTxfrWidth;
+    (void) slaveSelect;
+    (void) completeTxfr;
+    (void) context;
+
+    SmifHostUpdate();
+
+    if (cmd == MEM_CMD_ERASE_SUSPEND)
+    {
+        /* Ignored unless erasing, the erase goes on during the suspend latency */
+        if ((smifEraseSector != MEM_NO_SECTOR) && !smifEraseSuspended &&
+            (smifEraseEnd > now + smifTiming.suspendUs))
+        {
+            smifEraseSuspended = true;
+            smifEraseLeft = smifEraseEnd - now - smifTiming.suspendUs;
+            smifBusyUntil = now + smifTiming.suspendUs;
+            smifStats.suspends++;
+        }
+    }
+    else if (cmd == MEM_CMD_ERASE_RESUME)
+    {
+        if (smifEraseSuspended)
+        {
+            if (HostTimeUs() < smifBusyUntil)
+            {
+                SmifHostViolation("erase resume while busy", smifEraseSector * SECTOR_SIZE);
+            }
+            smifEraseSuspended = false;
+            smifEraseEnd = now + smifTiming.commandUs + smifEraseLeft;
+            smifBusyUntil = smifEraseEnd;
+        }
+    }
+    else
+    {
+        SmifHostViolation("unknown command", cmd);
+    }
+
+    return CY_SMIF_SUCCESS;
+}
+
+/*******************************************************************************
+*            Memory slot
+*******************************************************************************/
+cy_en_smif_status_t Cy_SMIF_Memslot_Init(SMIF_Type *base, cy_stc_smif_block_config_t * const blockConfig,
+                    cy_stc_smif_context_t *context)
+{
+    (void) base;
+    (void) context;
+
+    if ((smifImage == NULL) || (blockConfig->memCount != 1u))
+    {
+        return CY_SMIF_BAD_PARAM;
+    }
+
+    blockConfig->memConfig[0]->baseAddress = (uintptr_t) smifImage;
+
+    return CY_SMIF_SUCCESS;
+}
+
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdWriteEnable(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    cy_stc_smif_context_t const *context)
+{
+    (void) base;
+    (void) memDevice;
+    (void) context;
+
+    if (SmifHostCheck("write enable", true))
+    {
+        smifWel = true;
+    }
+
+    return CY_SMIF_SUCCESS;
+}
+
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdSectorErase(SMIF_Type *base, cy_stc_smif_mem_config_t *memDevice,
+                    uint8_t const *sectorAddr, cy_stc_smif_context_t const *context)
+{
+    uint32_t address = AddressBytes(sectorAddr);
+    uint64_t now = HostTimeUs();
+
+    (void) base;
+    (void) memDevice;
+    (void) context;
+
+    if (!SmifHostCheck("sector erase", false) || !SmifHostRange(address, 1u))
+    {
+        return CY_SMIF_SUCCESS;
+    }
+    if (!smifWel)
+    {
+        SmifHostViolation("sector erase without write enable", address);
+        return CY_SMIF_SUCCESS;
+    }
+
+    smifWel = false;
+    smifEraseSector = address / SECTOR_SIZE;
+    smifEraseSuspended = false;
+    smifEraseEnd = now + smifTiming.commandUs + smifTiming.eraseUs;
+    smifBusyUntil = smifEraseEnd;
+    smifStats.erases++;
+    smifStats.busyUs += smifTiming.eraseUs;
+
+    return CY_SMIF_SUCCESS;
+}
+
+/* The QE bit is non-volatile, it is only written when clear */
+cy_en_smif_status_t Cy_SMIF_Memslot_QuadEnable(SMIF_Type *base, cy_stc_smif_mem_config_t *memDevice,
+                    cy_stc_smif_context_t const *context)
+{
+    (void) base;
+    (void) memDevice;
+    (void) context;
+
+    if (!smifQe && SmifHostCheck("quad enable", false))
+    {
+        smifQe = true;
+        smifBusyUntil = HostTimeUs() + smifTiming.commandUs + smifTiming.programUs;
+        smifStats.quadEnables++;
+    }
+
+    return CY_SMIF_SUCCESS;
+}
+
+bool Cy_SMIF_Memslot_IsBusy(SMIF_Type *base, cy_stc_smif_mem_config_t *memDevice,
+                    cy_stc_smif_context_t const *context)
+{
+    (void) base;
+    (void) memDevice;
+    (void) context;
+
+    SmifHostUpdate();
+
+    return (HostTimeUs() < smifBusyUntil);
+}
+
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdReadSts(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    uint8_t *status, uint8_t command, cy_stc_smif_context_t const *context)
+{
+    (void) base;
+    (void) memDevice;
+    (void) context;
+
+    SmifHostUpdate();
+
+    if (command == MEM_CMD_READ_STS2)
+    {
+        *status = smifEraseSuspended ? MEM_STS2_ERASE_SUSPEND : 0u;
+    }
+    else
+    {
+        *status = (HostTimeUs() < smifBusyUntil) ? SMIF_HOST_STS1_WIP : 0u;
+    }
+
+    return CY_SMIF_SUCCESS;
+}
+
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdProgram(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    uint8_t const *addr, uint8_t *writeBuff, uint32_t size,
+                    cy_smif_event_cb_t cmdCmpltCb, cy_stc_smif_context_t *context)
+{
+    uint32_t address = AddressBytes(addr);
+
+    (void) base;
+    (void) memDevice;
+
+    if (!SmifHostCheck("page program", true) || !SmifHostRange(address, size))
+    {
+        return CY_SMIF_SUCCESS;
+    }
+    if (!smifWel)
+    {
+        SmifHostViolation("page program without write enable", address);
+        return CY_SMIF_SUCCESS;
+    }
+    if (size > SMIF_HOST_PAGE)
+    {
+        SmifHostViolation("page program over a page", address);
+        return CY_SMIF_SUCCESS;
+    }
+    if (smifEraseSuspended && ((address / SECTOR_SIZE) == smifEraseSector))
+    {
+        SmifHostViolation("page program in the erase suspended", address);
+    }
+
+    /* Without a buffer the PDL leaves the TX FIFO to a DMA */
+    if (writeBuff == NULL)
+    {
+        if (SmifHostDmaReady(SMIF_XFER_PROGRAM, size))
+        {
+            SmifHostStart(SMIF_XFER_PROGRAM, NULL, size, address);
+        }
+        return CY_SMIF_SUCCESS;
+    }
+
+    context->txCmpltCb = cmdCmpltCb;
+    context->transferStatus = 1u;
+    SmifHostStart(SMIF_XFER_PROGRAM, writeBuff, size, address);
+
+    return CY_SMIF_SUCCESS;
+}
+
+cy_en_smif_status_t Cy_SMIF_Memslot_CmdRead(SMIF_Type *base, cy_stc_smif_mem_config_t const *memDevice,
+                    uint8_t const *addr, uint8_t *readBuff, uint32_t size,
+                    cy_smif_event_cb_t cmdCmpltCb, cy_stc_smif_context_t *context)
+{
+    uint32_t address = AddressBytes(addr);
+
+    (void) base;
+    (void) memDevice;
+
+    if (!SmifHostCheck("read", true) || !SmifHostRange(address, size))
+    {
+        return CY_SMIF_SUCCESS;
+    }
+    if (smifEraseSuspended && ((address / SECTOR_SIZE) == smifEraseSector))
+    {
+        SmifHostViolation("read of the erase suspended", address);
+    }
+
+    /* Without a buffer the PDL leaves the RX FIFO to a DMA */
+    if (readBuff == NULL)
+    {
+        if (SmifHostDmaReady(SMIF_XFER_READ, size))
+        {
+            SmifHostStart(SMIF_XFER_READ, NULL, size, address);
+        }
+        return CY_SMIF_SUCCESS;
+    }
+
+    context->rxCmpltCb = cmdCmpltCb;
+    context->transferStatus = 1u;
+    SmifHostStart(SMIF_XFER_READ, readBuff, size, address);
+
+    return CY_SMIF_SUCCESS;
+}
+
+/*******************************************************************************
+*            Trigger multiplexer
+*******************************************************************************/
+cy_en_trigmux_status_t Cy_TrigMux_Connect(uint32_t inTrig, uint32_t outTrig, bool invert, en_trig_type_t trigType)
+{
+    uint32_t index;
+
+    (void) trigType;
+
+    if (invert || ((outTrig & 0x40000000u) == 0u) || ((inTrig & 0x40000000u) != 0u) ||
+        (((inTrig >> 8) & 0xFFu) != ((outTrig >> 8) & 0xFFu)))
+    {
+        return CY_TRIGMUX_BAD_PARAM;
+    }
+
+    /* An output takes one input, the last connected */
+    for (index = 0; index < smifRouteCount; index++)
+    {
+        if (smifRoutes[index][1] == outTrig)
+        {
+            smifRoutes[index][0] = inTrig;
+            return CY_TRIGMUX_SUCCESS;
+        }
+    }
+    if (smifRouteCount >= SMIF_HOST_ROUTES)
+    {
+        return CY_TRIGMUX_BAD_PARAM;
+    }
+    smifRoutes[smifRouteCount][0] = inTrig;
+    smifRoutes[smifRouteCount][1] = outTrig;
+    smifRouteCount++;
+
+    return CY_TRIGMUX_SUCCESS;
+}
+
+/*******************************************************************************
+*            GPIO
+*******************************************************************************/
+
+/* The red LED is only switched on by HandleErrorMemory, which never returns */
+void Cy_GPIO_Write(GPIO_PRT_Type *base, uint32_t pinNum, uint32_t value)
+{
+    if ((base == RED_LED_PORT) && (pinNum == RED_LED_NUM) && (value == LED_ON))
+    {
+        fprintf(stderr, "smif_host: error LED on at %llu us\n", (unsigned long long) HostTimeUs());
+        exit(2);
+    }
+
+    base->OUT = value;
+}
+
+/* Complete the erase once its time is over */
+static void SmifHostUpdate(void)
+{
+    if ((smifEraseSector != MEM_NO_SECTOR) && !smifEraseSuspended && (HostTimeUs() >= smifEraseEnd))
+    {
+        memset(&smifImage[smifEraseSector * SECTOR_SIZE], 0xFF, SECTOR_SIZE);
+        smifEraseSector = MEM_NO_SECTOR;
+    }
+}
+
+/* Start a data phase. Given a buffer, the SMIF interrupts each time the FIFO 
+   needs the CPU; without, the DW channel moves it all and interrupts once */
+static void SmifHostStart(smif_xfer_t xfer, uint8_t *buffer, uint32_t size, uint32_t address)
+{
+    uint64_t now = HostTimeUs();
+
+    smifXfer = xfer;
+    smifXferBuffer = buffer;
+    smifXferSize = size;
+    smifXferAddress = address;
+    smifXferDma = (buffer == NULL);
+
+    if (smifXferDma)
+    {
+        HostAt(now + smifTiming.commandUs + (((uint64_t) size * smifTiming.transferNs + 999u) / 1000u),
+               SmifHostDmaDone, NULL);
+    }
+    else
+    {
+        smifXferChunks = (size + SMIF_HOST_FIFO_BYTES - 1u) / SMIF_HOST_FIFO_BYTES;
+        HostAt(now + smifTiming.commandUs + ((SMIF_HOST_FIFO_BYTES * (uint64_t) smifTiming.transferNs + 999u) / 1000u),
+               SmifHostXferDone, NULL);
+    }
+}
+
+/* The FIFO reached its trigger level, the SMIF raises its interrupt */
+static void SmifHostXferDone(void *arg)
+{
+    (void) arg;
+
+    smifStats.fifoInterrupts++;
+    HostRaiseIrq(smif_interrupt_IRQn);
+}
+
+/* The DW channel moved the last word: the data phase is over, the channel 
+   disables itself and interrupts */
+static void SmifHostDmaDone(void *arg)
+{
+    uint32_t channel = (smifXfer == SMIF_XFER_PROGRAM) ? SMIF_DMA_TX_CHANNEL : SMIF_DMA_RX_CHANNEL;
+    DW_CH_STRUCT_Type *regs = &hostDw1.CH_STRUCT[channel];
+    cy_stc_dma_descriptor_t *descriptor = (cy_stc_dma_descriptor_t *) regs->CH_CURR_PTR;
+
+    (void) arg;
+
+    if (smifXfer == SMIF_XFER_NONE)
+    {
+        return;
+    }
+
+    smifXferBuffer = (smifXfer == SMIF_XFER_PROGRAM) ? descriptor->config.srcAddress : descriptor->config.dstAddress;
+    SmifHostComplete();
+    smifStats.dmaPhases++;
+
+    if ((descriptor->config.channelState == CY_DMA_CHANNEL_DISABLED) || (descriptor->config.nextDescriptor == NULL))
+    {
+        regs->CH_CTL &= ~DW_CH_STRUCT_CH_CTL_ENABLED_Msk;
+    }
+    else
+    {
+        regs->CH_CURR_PTR = (uintptr_t) descriptor->config.nextDescriptor;
+    }
+
+    if ((descriptor->config.interruptType == CY_DMA_DESCR) && ((regs->INTR_MASK & CY_DMA_INTR_MASK) != 0u))
+    {
+        HostRaiseIrq((IRQn_Type) ((uint32_t) cpuss_interrupts_dw1_0_IRQn + channel));
+    }
+}
+
+/* Move the data of the data phase over, a page program keeps the memory busy */
+static void SmifHostComplete(void)
+{
+    smif_xfer_t xfer = smifXfer;
+
+    smifXfer = SMIF_XFER_NONE;
+    smifXferDma = false;
+
+    if (xfer == SMIF_XFER_PROGRAM)
+    {
+        ProgramImage(smifXferBuffer, smifXferSize, smifXferAddress);
+        smifWel = false;
+        smifBusyUntil = HostTimeUs() + smifTiming.programUs;
+        smifStats.programs++;
+        smifStats.bytesProgrammed += smifXferSize;
+        smifStats.busyUs += smifTiming.programUs;
+    }
+    else
+    {
+        memcpy(smifXferBuffer, &smifImage[smifXferAddress], smifXferSize);
+        smifStats.reads++;
+        smifStats.bytesRead += smifXferSize;
+    }
+}
+
+/* A data phase without buffer needs its DW1 channel enabled, fed by the FIFO
+   request and loaded with a descriptor moving the whole data phase by words */
+static bool SmifHostDmaReady(smif_xfer_t xfer, uint32_t size)
+{
+    bool program = (xfer == SMIF_XFER_PROGRAM);
+    uint32_t channel = program ? SMIF_DMA_TX_CHANNEL : SMIF_DMA_RX_CHANNEL;
+    const DW_CH_STRUCT_Type *regs = &hostDw1.CH_STRUCT[channel];
+    const cy_stc_dma_descriptor_t *descriptor = (const cy_stc_dma_descriptor_t *) regs->CH_CURR_PTR;
+    const char *problem = NULL;
+
+    if (((hostDw1.CTL & DW_CTL_ENABLED_Msk) == 0u) || ((regs->CH_CTL & DW_CH_STRUCT_CH_CTL_ENABLED_Msk) == 0u))
+    {
+        problem = "data phase without its DMA channel enabled";
+    }
+    else if (!SmifHostRouted(program ? TRIG13_IN_SMIF_TR_TX_REQ : TRIG13_IN_SMIF_TR_RX_REQ, channel))
+    {
+        problem = "data phase with its DMA channel not triggered by the SMIF";
+    }
+    else if ((program ? smifTxLevel : smifRxLevel) >= SMIF_HOST_FIFO_BYTES)
+    {
+        problem = "data phase without a FIFO trigger level";
+    }
+    else if ((descriptor == NULL) || (descriptor->config.dataSize != CY_DMA_WORD) ||
+             (descriptor->config.xCount * sizeof(uint32_t) != size) ||
+             (program ? (descriptor->config.dstAddress != (void *) &hostSmif.TX_DATA_FIFO_WR4) 
+                      : (descriptor->config.srcAddress != (void *) &hostSmif.RX_DATA_FIFO_RD4)))
+    {
+        problem = "data phase not matching the DMA descriptor";
+    }
+
+    if (problem != NULL)
+    {
+        SmifHostViolation(problem, channel);
+        return false;
+    }
+
+    return true;
+}
+
+/* A FIFO request reaches a DW1 channel through a group 13 output */
+static bool SmifHostRouted(uint32_t request, uint32_t channel)
+{
+    uint32_t output = MEM_NO_SECTOR;
+    uint32_t index;
+    uint32_t line;
+
+    for (index = 0; index < smifRouteCount; index++)
+    {
+        if (smifRoutes[index][0] == request)
+        {
+            output = smifRoutes[index][1] & 0xFFu;
+        }
+    }
+
+    for (index = 0; index < smifRouteCount; index++)
+    {
+        /* Group 1 inputs from 27 take the group 13 outputs from 16 */
+        line = smifRoutes[index][0] & 0xFFu;
+        if ((smifRoutes[index][1] == (TRIG1_OUT_CPUSS_DW1_TR_IN14 - SMIF_DMA_TX_CHANNEL + channel)) &&
+            ((smifRoutes[index][0] >> 8) == 1u) && (line >= SMIF_HOST_GROUP1_FIRST) &&
+            ((line - SMIF_HOST_GROUP1_FIRST + 16u) == output))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* A command is only accepted in command mode, with no data phase in progress
+   and the memory idle. Some are accepted while an erase is suspended */
+static bool SmifHostCheck(const char *command, bool allowSuspended)
+{
+    SmifHostUpdate();
+
+    if (!smifEnabled || smifMapped)
+    {
+        SmifHostViolation(command, 0u);
+        fprintf(stderr, "smif_host:   SMIF not in command mode\n");
+        return false;
+    }
+    if (smifXfer != SMIF_XFER_NONE)
+    {
+        SmifHostViolation(command, smifXferAddress);
+        fprintf(stderr, "smif_host:   data phase in progress\n");
+        return false;
+    }
+    if (HostTimeUs() < smifBusyUntil)
+    {
+        SmifHostViolation(command, 0u);
+        fprintf(stderr, "smif_host:   memory busy\n");
+        return false;
+    }
+    if (smifEraseSuspended && !allowSuspended)
+    {
+        SmifHostViolation(command, smifEraseSector * SECTOR_SIZE);
+        fprintf(stderr, "smif_host:   erase suspended\n");
+        return false;
+    }
+
+    return true;
+}
+
+/* Access inside of the memory */
+static bool SmifHostRange(uint32_t address, uint32_t size)
+{
+    if ((address >= SMIF_HOST_SIZE) || (size > (SMIF_HOST_SIZE - address)))
+    {
+        SmifHostViolation("access out of the memory", address);
+        return false;
+    }
+
+    return true;
+}
+
+/* The memory would not do what the firmware meant */
+static void SmifHostViolation(const char *message, uint32_t address)
+{
+    if (smifStats.violations < SMIF_HOST_REPORTS)
+    {
+        fprintf(stderr, "smif_host: %s at 0x%08lx, %llu us\n", message, (unsigned long) address,
+                (unsigned long long) HostTimeUs());
+    }
+    smifStats.violations++;
+}
+
+/* Program bits to zero only, the address wraps inside the program buffer */
+static void ProgramImage(const uint8_t *data, uint32_t size, uint32_t address)
+{
+    uint32_t page = address & ~(SMIF_HOST_PAGE - 1u);
+    uint32_t offset = address & (SMIF_HOST_PAGE - 1u);
+    uint32_t index;
+    bool violation = false;
+    uint8_t *cell;
+
+    for (index = 0; index < size; index++)
+    {
+        cell = &smifImage[page + ((offset + index) & (SMIF_HOST_PAGE - 1u))];
+
+        /* A one can only come back with an erase */
+        if (((data[index] & (uint8_t) ~(*cell)) != 0u) && !violation)
+        {
+            SmifHostViolation("page program over data not erased", (uint32_t) (cell - smifImage));
+            violation = true;
+        }
+
+        *cell &= data[index];
+    }
+}
+
+/* The 3-byte address of a command */
+static uint32_t AddressBytes(uint8_t const *addr)
+{
+    return ((uint32_t) addr[0] << 16) | ((uint32_t) addr[1] << 8) | (uint32_t) addr[2];
+}
+
+/* [] END OF FILE */
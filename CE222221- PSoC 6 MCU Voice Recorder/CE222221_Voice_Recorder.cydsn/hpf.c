@@ -0,0 +1,170 @@
+/******************************************************************************
+* File Name: hpf.c
+*
+* Version: 1.0
+*
+* Description: This file contains the high-pass filter, a processing stage
+*              that removes the DC offset and the rumble of the microphones
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include <math.h>
+#include "hpf.h"
+
+static void HpfDesign(hpf_t *hpf, uint32_t sampleRate);
+
+/*******************************************************************************
+* Function Name: HpfInit
+********************************************************************************
+* Summary:
+*   This function clears the history of a high-pass filter. The coefficients 
+*   are set on the first block.
+*
+* Parameters:
+*   hpf: Filter to reset.
+*   enabled: false to leave the blocks unchanged.
+*
+*******************************************************************************/
+void HpfInit(hpf_t *hpf, bool enabled)
+{
+    uint32_t channel;
+    
+    hpf->enabled = enabled;
+    hpf->sampleRate = 0;
+    
+    for (channel = 0; channel < 2u; channel++)
+    {
+        hpf->x1[channel] = 0;
+        hpf->x2[channel] = 0;
+        hpf->y1[channel] = 0;
+        hpf->y2[channel] = 0;
+    }
+}
+
+/*******************************************************************************
+* Function Name: HpfProcess
+********************************************************************************
+* Summary:
+*   This function is the process of a high-pass stage, its state is an hpf_t.
+*   The 16-bit samples are filtered at the 24-bit scale, so the rounding of 
+*   the feedback stays well below their last bit. The output saturates.
+*
+* Parameters:
+*   stage: Stage run, its state is the filter.
+*   block: Block processed in place.
+*
+*******************************************************************************/
+void HpfProcess(dsp_stage_t *stage, dsp_block_t *block)
+{
+    hpf_t *hpf = (hpf_t *) stage->state;
+    bool wide = (block->sampleSize == sizeof(int32_t));
+    uint32_t shift = wide ? 0u : 8u;
+    int32_t scale = (int32_t) (1u << shift);
+    int32_t high = wide ? 0x7FFFFF : 0x7FFF;
+    uint32_t frame;
+    uint32_t channel;
+    uint32_t index;
+    int64_t acc;
+    int32_t x;
+    int32_t y;
+    
+    if (!hpf->enabled || (block->channels > 2u))
+    {
+        return;
+    }
+    
+    if (block->sampleRate != hpf->sampleRate)
+    {
+        HpfDesign(hpf, block->sampleRate);
+    }
+    
+    for (frame = 0; frame < block->frames; frame++)
+    {
+        for (channel = 0; channel < block->channels; channel++)
+        {
+            index = frame*block->channels + channel;
+            x = (wide ? ((int32_t *) block->samples)[index] : ((int16_t *) block->samples)[index]) * scale;
+            
+            acc = ((int64_t) hpf->b0 * x) + ((int64_t) hpf->b1 * hpf->x1[channel]) + 
+                  ((int64_t) hpf->b2 * hpf->x2[channel]) - ((int64_t) hpf->a1 * hpf->y1[channel]) - 
+                  ((int64_t) hpf->a2 * hpf->y2[channel]);
+            y = (int32_t) (acc >> 30);
+            
+            hpf->x2[channel] = hpf->x1[channel];
+            hpf->x1[channel] = x;
+            hpf->y2[channel] = hpf->y1[channel];
+            hpf->y1[channel] = y;
+            
+            /* Back to the sample scale, saturated */
+            y >>= shift;
+            if (y > high)
+            {
+                y = high;
+            }
+            else if (y < (-high - 1))
+            {
+                y = -high - 1;
+            }
+            
+            if (wide)
+            {
+                ((int32_t *) block->samples)[index] = y;
+            }
+            else
+            {
+                ((int16_t *) block->samples)[index] = (int16_t) y;
+            }
+        }
+    }
+}
+
+/* Butterworth high-pass at HPF_CUTOFF_HZ, from the audio EQ cookbook, once per rate */
+static void HpfDesign(hpf_t *hpf, uint32_t sampleRate)
+{
+    float omega = (2.0f*3.14159265f*(float) HPF_CUTOFF_HZ) / (float) sampleRate;
+    float alpha = sinf(omega) / (2.0f*0.70710678f);
+    float cosine = cosf(omega);
+    float a0 = 1.0f + alpha;
+    float q30 = 1073741824.0f;
+    
+    hpf->b0 = (int32_t) (((1.0f + cosine) / (2.0f*a0)) * q30);
+    hpf->b1 = -2*hpf->b0;
+    hpf->b2 = hpf->b0;
+    hpf->a1 = (int32_t) (((-2.0f*cosine) / a0) * q30);
+    hpf->a2 = (int32_t) (((1.0f - alpha) / a0) * q30);
+    hpf->sampleRate = sampleRate;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,84 @@
+/******************************************************************************
+* File Name: hpf.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the hpf.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef HPF_H
+#define HPF_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp.h"
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+/* State of a high-pass biquad, one per path. Second-order Butterworth, direct
+   form I, Q30 coefficients set for the sample rate of the blocks */
+typedef struct hpf
+{
+    bool enabled;                     /* Blocks are left unchanged when false */
+    uint32_t sampleRate;              /* Rate the coefficients are set for, 0 for none */
+    int32_t b0;                       /* Feed-forward coefficients, Q30 */
+    int32_t b1;
+    int32_t b2;
+    int32_t a1;                       /* Feedback coefficients, Q30, a0 is one */
+    int32_t a2;
+    int32_t x1[2];                    /* Last inputs, by channel, 24-bit scale */
+    int32_t x2[2];
+    int32_t y1[2];                    /* Last outputs, by channel, 24-bit scale */
+    int32_t y2[2];
+} hpf_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void HpfInit(hpf_t *hpf, bool enabled);
+void HpfProcess(dsp_stage_t *stage, dsp_block_t *block);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define HPF_CUTOFF_HZ       (80u)           /* Cut-off, below the voice, above the rumble */
+#define HPF_BUDGET_CYCLES   (10000u)        /* Cycles declared for a page */
+
+#endif
+/* [] END OF FILE */
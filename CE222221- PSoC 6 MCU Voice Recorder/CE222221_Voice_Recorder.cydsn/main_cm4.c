@@ -46,9 +46,7 @@
 /* RTOS Queue Variables */
 QueueHandle_t EventsQueue;
 QueueHandle_t GUIQueue;
-
-/* RTOS Semaphore/Mutex Variables */
-SemaphoreHandle_t SmifSemphr;
+QueueHandle_t StorageQueue;
 
 /* RTOS Event Group bits */
 EventGroupHandle_t DmaEvents;
@@ -90,14 +88,13 @@ int main(void)
     /* Create Queues */
     EventsQueue = xQueueCreate(QUEUE_SIZE, sizeof(uint32_t));
     GUIQueue = xQueueCreate(QUEUE_SIZE, sizeof(uint32_t));
-    
-    /* Create Semaphores */
-    SmifSemphr = xSemaphoreCreateBinary();
+    StorageQueue = xQueueCreate(STORAGE_QUEUE_SIZE, sizeof(mem_request_t));
     
     /* Create Event Group Bits */
     DmaEvents = xEventGroupCreate();
     
     /* Create Tasks */
+    xTaskCreate(StorageTask, "Storage Task", STACK_DEPTH, NULL, 2, NULL);
     xTaskCreate(RecorderTask, "Recorder Task", STACK_DEPTH, NULL, 1, NULL);
     xTaskCreate(TouchTask, "Touch Task", STACK_DEPTH, NULL, 1, NULL);
     xTaskCreate(GraphicsTask, "Graphics Task", STACK_DEPTH, NULL, 1, NULL);
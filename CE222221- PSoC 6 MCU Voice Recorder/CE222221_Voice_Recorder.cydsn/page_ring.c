@@ -0,0 +1,186 @@
+/******************************************************************************
+* File Name: page_ring.c
+*
+* Version: 1.0
+*
+* Description: This file contains the single-producer single-consumer ring
+*              of pages filled by a DMA and drained by a task
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include "page_ring.h"
+#include "project.h"
+
+/*******************************************************************************
+* Function Name: PageRingInit
+********************************************************************************
+* Summary:
+*   This function empties a ring. The producer must be stopped.
+*
+* Parameters:
+*   ring: Ring to reset.
+*   depth: Number of slots.
+*
+*******************************************************************************/
+void PageRingInit(page_ring_t *ring, uint32_t depth)
+{
+    ring->head = 0;
+    ring->read = 0;
+    ring->tail = 0;
+    ring->lost = 0;
+    ring->overruns = 0;
+    ring->depth = depth;
+}
+
+/*******************************************************************************
+* Function Name: PageRingProduce
+********************************************************************************
+* Summary:
+*   This function publishes the pages written by the producer, from an 
+*   interrupt. The producer then writes the slot of the page after them. When 
+*   that slot is not released, the page it holds and the ones before are lost:
+*   they are counted, and the consumer skips those not taken yet, so the pages 
+*   stay in order.
+*
+* Parameters:
+*   ring: Ring to produce in.
+*   count: Pages completed since the last call.
+*
+* Return:
+*   bool: true if the consumer had taken all the pages, it must be woken up.
+*         Otherwise it is still draining and sees the new pages.
+*
+*******************************************************************************/
+bool PageRingProduce(page_ring_t *ring, uint32_t count)
+{
+    uint32_t head = ring->head;
+    bool wake = (head == ring->read);
+    uint32_t tail = ring->tail;
+    uint32_t lost;
+    
+    head += count;
+    
+    /* The slot written next holds page (head - depth), is it released? */
+    lost = head + 1u - ring->depth;
+    if ((int32_t) (lost - tail) > 0)
+    {
+        ring->overruns += ((int32_t) (ring->lost - tail) > 0) ? (lost - ring->lost) : (lost - tail);
+        ring->lost = lost;
+    }
+    
+    /* Release, the page data before the index */
+    __DMB();
+    ring->head = head;
+    
+    return wake;
+}
+
+/*******************************************************************************
+* Function Name: PageRingTake
+********************************************************************************
+* Summary:
+*   This function takes the next page produced, skipping the pages lost to an
+*   overrun. The slot stays in use until PageRingRelease.
+*
+* Parameters:
+*   ring: Ring to consume from.
+*   page: Index of the page taken, its slot is (page % depth).
+*
+* Return:
+*   bool: false if no page is left.
+*
+*******************************************************************************/
+bool PageRingTake(page_ring_t *ring, uint32_t *page)
+{
+    uint32_t head = ring->head;
+    uint32_t read = ring->read;
+    uint32_t lost;
+    
+    /* Acquire, the index before the page data */
+    __DMB();
+    
+    if (read == head)
+    {
+        return false;
+    }
+    
+    lost = ring->lost;
+    if ((int32_t) (lost - read) > 0)
+    {
+        read = lost;
+    }
+    
+    *page = read;
+    ring->read = read + 1u;
+    
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: PageRingRelease
+********************************************************************************
+* Summary:
+*   This function frees the slots of the pages up to a page taken, once their 
+*   data is no longer needed. Pages are released in order.
+*
+* Parameters:
+*   ring: Ring the page was taken from.
+*   page: Index of the last page released.
+*
+*******************************************************************************/
+void PageRingRelease(page_ring_t *ring, uint32_t page)
+{
+    /* Release, the slot is read before it can be reused */
+    __DMB();
+    
+    if ((int32_t) (page + 1u - ring->tail) > 0)
+    {
+        ring->tail = page + 1u;
+    }
+}
+
+/*******************************************************************************
+* Function Name: PageRingOverruns
+********************************************************************************
+* Summary:
+*   Return the number of pages the producer overwrote before they were released.
+*
+*******************************************************************************/
+uint32_t PageRingOverruns(const page_ring_t *ring)
+{
+    return ring->overruns;
+}
+
+/* [] END OF FILE */
@@ -0,0 +1,78 @@
+/******************************************************************************
+* File Name: page_ring.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the page_ring.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef PAGE_RING_H
+#define PAGE_RING_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+
+/* Ring of pages between a producer, usually a DMA interrupt, and a consumer 
+   task. The indices run freely, a page goes to slot (index % depth). Each 
+   index has a single writer, so no lock is needed: the producer writes head 
+   and lost, the consumer read, the one releasing the slots tail */
+typedef struct
+{
+    volatile uint32_t head;           /* Pages produced */
+    volatile uint32_t read;           /* Pages taken by the consumer */
+    volatile uint32_t tail;           /* Pages released, their slots are free */
+    volatile uint32_t lost;           /* Pages before this one were overwritten */
+    volatile uint32_t overruns;       /* Pages overwritten before being released */
+    uint32_t depth;                   /* Slots in the ring */
+} page_ring_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void PageRingInit(page_ring_t *ring, uint32_t depth);
+bool PageRingProduce(page_ring_t *ring, uint32_t count);
+bool PageRingTake(page_ring_t *ring, uint32_t *page);
+void PageRingRelease(page_ring_t *ring, uint32_t page);
+uint32_t PageRingOverruns(const page_ring_t *ring);
+
+#endif
+/* [] END OF FILE */
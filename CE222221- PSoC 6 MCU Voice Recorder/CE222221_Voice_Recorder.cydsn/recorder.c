@@ -40,11 +40,38 @@
 * liability. Use of this Software may be limited by and subject to the applicable
 * Cypress software license agreement.
 *****************************************************************************/
+#include <string.h>
 #include "recorder.h"
 #include "project.h"
 #include "smif_mem.h"
 #include "graphics.h"
 #include "rtos.h"
+#include "adpcm.h"
+#include "page_ring.h"
+#include "codec.h"
+#include "vad.h"
+#include "agc.h"
+#include "hpf.h"
+#include "denoise.h"
+
+/* A compressed block fills exactly the payload of one memory page */
+#if (ADPCM_BLOCK_SIZE != PAGE_PAYLOAD_SIZE)
+#error "ADPCM_BLOCK_SIZE must match PAGE_PAYLOAD_SIZE"
+#endif
+
+/* Stored pages map to the pool modulo its size, the loop history drops a sector */
+#if ((TX_POOL_PAGES & (TX_POOL_PAGES - 1u)) != 0u) || (TX_POOL_PAGES > LOOP_SECTOR_PAGES)
+#error "TX_POOL_PAGES must be a power of two, up to a sector of pages"
+#endif
+
+/* Pages of a pool riding over a stall, page time and stall in microseconds */
+#define TX_POOL_NEED(pageUs, stallUs) ((((stallUs) + (pageUs) - 1u)/(pageUs)) + TX_POOL_SPARE_PAGES)
+
+/* The pool holds the stall of the typical timing at the fastest page rate, 24-bit stereo at 48 kHz */
+#if (TX_POOL_NEED(((PAGE_PAYLOAD_SIZE/8u)*1000000u)/48000u, \
+                  TX_POOL_HOLD_US + TX_POOL_PROGRAMS*(MEM_PROGRAM_US + MEM_SUSPEND_US)) > TX_POOL_PAGES)
+#error "TX_POOL_PAGES does not hold the longest stall of the storage path"
+#endif
 
 /*******************************************************************************
 *            Local Interrupt Handlers
@@ -52,21 +79,193 @@
 void PDM_Interrupt_User(void);
 void I2S_Interrupt_User(void);
 
+/* Storage completion callbacks */
+static void PageWrittenCallback(mem_op_t op, uint32_t address, void *arg);
+
+/* Order of the sectors erased ahead of the recording */
+static uint32_t NextRecordSector(uint32_t sector);
+static uint32_t NextEraseSector(uint32_t sector);
+static void PrepareNextRecord(void);
+static uint32_t PickRecordSector(void);
+static uint32_t RecordAddress(uint32_t sector, uint32_t page);
+
+/* Pages to store, encoded when the format is compressed */
+static void StoreRecordedPages(void);
+static uint8_t * StoredPageBuffer(uint32_t page);
+static void SealRecordedPage(uint32_t page);
+static bool RecordLimitReached(void);
+static void ReleaseSilence(void);
+static uint32_t ProcessingFlags(void);
+
+/* Processing of the captured and the played pages */
+static void PageBlock(dsp_block_t *block, uint8_t *page, const record_format_t *format);
+static uint32_t DspDeadline(const record_format_t *format);
+
+/* Power-loss recovery */
+static void RecoverRecord(void);
+static bool ValidRecordedPage(const uint8_t *page, uint32_t tag, uint32_t number);
+static uint16_t PageCrc(const uint8_t *page);
+
+#if (RECORD_BENCHMARK_SECTORS != 0u)
+/* Flash benchmark mode */
+static void BenchmarkRecorder(void);
+static uint32_t BenchCyclesPerPage(const mem_bench_xfer_t *cost);
+#endif
+
+/* Hardware set for the format of a recording */
+static uint32_t RecordFlashTime(const record_format_t *format);
+static uint32_t TxPoolNeed(const record_format_t *format);
+static void SetAudioClock(uint32_t clockHz);
+static void ConfigureCapture(void);
+static void ConfigurePlayback(void);
+static void InitPlayDescr(cy_stc_dma_descriptor_t *descr, const uint8_t *payload, cy_stc_dma_descriptor_t *next);
+static void EnablePlayDma(void);
+
+/* Capture into the sectors prepared for the next record */
+static void StartCapture(void);
+static void LoadTxPool(void);
+static uint32_t DroppedTxPages(void);
+
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+/* Loop recording ahead of the record button */
+static void StartLoopRecorder(void);
+static void StopLoopRecorder(void);
+static void CommitLoopRecorder(void);
+static void TrimLoopHistory(void);
+#endif
+
+#if (PLAY_FROM_XIP != 0u)
+/* Memory-mapped playback */
+static void LoadXipPage(uint32_t page);
+#endif
+
+/* Read-ahead playback */
+static void StepPlayRing(void);
+static void ProcessPlayRing(void);
+static void FillPlayRing(void);
+static void DecodePlayRing(void);
+static void ExpandPlayRing(void);
+static void PageReadCallback(mem_op_t op, uint32_t address, void *arg);
+
+/* Random access in the played record */
+static void StartPlayAt(uint32_t page);
+static uint32_t StoredPageAt(uint32_t page, uint32_t *skip);
+static uint16_t StoredPosition(uint32_t stored);
+
+/* Playback and capture at the same time */
+static bool DuplexAllowed(const record_format_t *format);
+static void StopPlayer(void);
+static void StartMonitor(void);
+static void MonitorPage(uint32_t page);
+
 /*******************************************************************************
 *            Internal Global Variables
 *******************************************************************************/
-uint32_t pageExCount = 0;                   /* Current page access to SMIF */
-uint32_t pageTxCount = 0;                   /* Current page to TX buffer */
+volatile uint32_t pageExCount = 0;          /* Pages programmed to SMIF */
+uint32_t pageQueuedCount = 0;               /* Pages submitted to the storage task */
+uint32_t pageBacklogPeak = 0;               /* Most pages captured but not programmed */
+page_ring_t pdmRing;                        /* Pages of the TX pool, filled by the PDM DMA */
+uint32_t pdmLastSlot = 0;                   /* Record DMA descriptor at the last interrupt */
+uint32_t pdmLastCycles = 0;                 /* DWT cycle count at the last interrupt */
+uint32_t pdmPageCycles = 1;                 /* CPU cycles to capture a page */
+uint32_t pageCaptured[TX_POOL_PAGES];       /* Ring page held by each stored PCM page */
+cy_stc_dma_descriptor_t txPoolDescr[TX_POOL_PAGES]; /* Record DMA chain, one per page */
+tx_pool_stats_t txPoolStats = {TX_POOL_PAGES, 0, 0, 0}; /* Occupancy of the TX pool */
+dsp_chain_t captureChain;                   /* Stages run on each captured page */
+dsp_chain_t playChain;                      /* Stages run on each page to play */
+hpf_t captureHpf;                           /* High-pass of the captured pages */
+dsp_stage_t hpfStage = {"HPF", HpfProcess, &captureHpf, HPF_BUDGET_CYCLES, 0, 0, 0, NULL};
+                                            /* First stage of the capture chain */
+vad_t captureVad;                           /* Voice activity of the captured pages */
+dsp_stage_t vadStage = {"VAD", VadProcess, &captureVad, VAD_BUDGET_CYCLES, 0, 0, 0, NULL};
+                                            /* Stage after the high-pass */
+denoise_t captureDenoise;                   /* Noise suppression of the captured pages */
+dsp_stage_t denoiseStage = {"Denoise", DenoiseProcess, &captureDenoise, DENOISE_BUDGET_CYCLES,
+                            0, 0, 0, NULL};
+                                            /* Stage after the voice activity */
+agc_t captureAgc;                           /* Gain control of the captured pages */
+dsp_stage_t agcStage = {"AGC", AgcProcess, &captureAgc, AGC_BUDGET_CYCLES, 0, 0, 0, NULL};
+                                            /* Last stage of the capture chain */
+SemaphoreHandle_t processLock = NULL;       /* One task processes the pages at a time */
+uint32_t captureLoadShown = 0;              /* Capture chain load on the display, percent */
+uint32_t silentPages = 0;                   /* Captured pages not stored, compact records */
+uint32_t silenceHeld = 0;                   /* Silent page released after the programs, plus one */
+uint32_t silenceLast = 0;                   /* Last page captured if silent, plus one */
+uint32_t pageStoreCount = 0;                /* Pages ready to be programmed */
 uint32_t pageRxCount = 0;                   /* Current page to RX buffer */
-uint8_t txBuffer[PACKET_SIZE*TX_PAGE_MAX_COUNT] = {0};     
-                                            /* TX buffer from PDM to SMIF */
-uint8_t rxBuffer[PACKET_SIZE*2] = {0};      /* RX buffer from SMIF to I2S */
-sector_info_t sectorInfo;                   /* Information of the current sector */
+CY_ALIGN(4) uint8_t txPool[PACKET_SIZE*TX_POOL_PAGES] = {0};
+                                            /* TX pages from PDM to SMIF, words for the DMA */
+CY_ALIGN(4) uint8_t adpcmTxBuffer[PACKET_SIZE*ADPCM_TX_PAGES] = {0};
+                                            /* Encoded pages from TX buffer to SMIF */
+adpcm_codec_t recordCodec;                  /* Encoder of the recording */
+record_format_t recordFormat;               /* Format of the next recording */
+uint32_t pdmFormat = 0;                     /* Format the PDM/PCM is set for, mono 16-bit 8 kHz as generated */
+#if (PLAY_FROM_XIP != 0u)
+cy_stc_dma_descriptor_t xipDescr[XIP_DESCR_COUNT]; /* Play DMA ring over the flash */
+uint32_t xipPageLoaded = 0;                 /* Pages of the record loaded in the ring */
+#endif
+cy_stc_dma_descriptor_t ringDescr[PLAY_RING_DEPTH]; /* Play DMA ring over rxBuffer */
+volatile uint32_t playPagesDone = 0;        /* Pages played since the play DMA started */
+uint32_t i2sLastCycles = 0;                 /* DWT cycle count at the last play interrupt */
+uint32_t i2sPageCycles = 1;                 /* CPU cycles to play a page */
+bool playXip = false;                       /* Playing from the memory-mapped flash */
+bool playRingActive = false;                /* Read-ahead ring in use */
+bool playing = false;                       /* Play DMA in use, in any state */
+record_handle_t playHandle = NO_RECORD_HANDLE; /* Record played, none when monitoring */
+bool monitorEnabled = (RECORD_DEF_MONITOR != 0u); /* Monitor the recordings */
+bool monitorActive = false;                 /* Capture played through the ring */
+CY_ALIGN(4) uint8_t rxBuffer[PACKET_SIZE*PLAY_RING_DEPTH] = {0};
+                                            /* Read-ahead ring from SMIF to I2S */
+uint32_t ringRequested = 0;                 /* Pages submitted for reading */
+volatile uint32_t ringRead = 0;             /* Pages read into the ring */
+volatile uint32_t ringFilled = 0;           /* Pages read and processed, ready to play */
+volatile uint32_t ringGeneration = 0;       /* Drops reads of a previous play */
+uint32_t playUnderrunCount = 0;             /* Pages played before being read */
+CY_ALIGN(4) uint8_t adpcmRxBuffer[PACKET_SIZE*ADPCM_RX_PAGES] = {0};
+                                            /* Encoded or compact pages read ahead */
+adpcm_codec_t playCodec;                    /* Decoder of the played record */
+uint32_t playOrigin = 0;                    /* Position of the first page of a compact record */
+uint32_t adpcmRequested = 0;                /* Encoded pages submitted for reading */
+volatile uint32_t adpcmFilled = 0;          /* Encoded pages read */
+uint32_t adpcmOpened = 0;                   /* Encoded pages handed to the decoder */
+uint32_t ringDecodeOffset = 0;              /* Samples decoded in the current slot */
+uint32_t adpcmSkip = 0;                     /* Samples of the first block before the play position */
+uint32_t playSeekPage = 0;                  /* Page the play DMA was started from */
 recorder_states_t state = IDLE;             /* Current state */
 uint32_t startSectorRecorded = 0;           /* Start sector of the last record */
 uint32_t endSectorRecorded = 0;             /* Last sector of the last recorded */
-uint32_t currentInfoAddress;                /* Current address storing the index */
-uint32_t currentSector;                     /* Current sector being accessed */
+uint32_t nextSectorRecorded = FIRST_RECORD_SECTOR;  /* Start sector of the next record */
+record_handle_t recordHandle = NO_RECORD_HANDLE;    /* Recording in progress */
+uint32_t recordFlags = 0;                   /* Catalog flags of the recording */
+uint32_t recordTag = 0;                     /* Tag in the page headers of the recording */
+uint32_t progressFirstPage = 1;             /* Pages queued when the first progress is saved */
+bool loopActive = false;                    /* Capturing ahead of the record button */
+uint32_t recordPageBase = 0;                /* Stored pages dropped from the loop history */
+uint32_t playStartSector = 0;               /* Start sector of the played record */
+uint32_t playPageCount = 0;                 /* Number of pages to play */
+uint32_t playStoredPages = 0;               /* Number of pages stored in the record */
+record_format_t playFormat;                 /* Format of the played record */
+uint32_t i2sFormat = 0;                     /* Word and rate the I2S is set for, 16-bit 8 kHz as generated */
+uint32_t audioClockHz = 16384000u;          /* Frequency the audio PLL is set for, as generated */
+
+/* Audio clock settings, by rate index of the format word. Index 0 is the 
+   generated clock tree: PLL0 at 16.384 MHz, clk_hf[4] at 2.048 MHz, 256 fs,
+   and the PDM/PCM and the I2S keep their generated dividers */
+const audio_rate_t audioRates[] =
+{
+    {RECORD_SAMPLE_RATE, 16384000u, CY_SYSCLK_CLKHF_DIVIDE_BY_8, 3u, 64u, 
+     CODEC_MODE_CTRL2_FS_8kHz | CODEC_MODE_CTRL2_CM_256fs},
+    {16000u,             49152000u, CY_SYSCLK_CLKHF_DIVIDE_BY_8, 5u, 64u, 
+     CODEC_MODE_CTRL2_FS_16kHz | CODEC_MODE_CTRL2_CM_384fs},
+    {22050u,             45158400u, CY_SYSCLK_CLKHF_DIVIDE_BY_8, 3u, 64u, 
+     CODEC_MODE_CTRL2_FS_22k05Hz | CODEC_MODE_CTRL2_CM_256fs},
+    {32000u,             49152000u, CY_SYSCLK_CLKHF_DIVIDE_BY_4, 5u, 32u, 
+     CODEC_MODE_CTRL2_FS_32kHz | CODEC_MODE_CTRL2_CM_384fs},
+    {44100u,             45158400u, CY_SYSCLK_CLKHF_DIVIDE_BY_4, 3u, 32u, 
+     CODEC_MODE_CTRL2_FS_44k1Hz | CODEC_MODE_CTRL2_CM_256fs},
+    {48000u,             49152000u, CY_SYSCLK_CLKHF_DIVIDE_BY_4, 3u, 32u, 
+     CODEC_MODE_CTRL2_FS_48kHz | CODEC_MODE_CTRL2_CM_256fs},
+};
 
 /*******************************************************************************
 * Function Name: InitRecorder
@@ -78,8 +277,8 @@ uint32_t currentSector;                     /* Current sector being accessed */
 *******************************************************************************/
 void InitRecorder(void)
 {
-    uint32_t index;
-    uint32_t memAddress = 0;
+    /* The pages are processed by the recorder task, or the events task when it stops a capture */
+    processLock = xSemaphoreCreateMutex();
     
     /* Init Local Interrupts */
     Cy_SysInt_Init(&DMA_PDM_IRQ_cfg, PDM_Interrupt_User);
@@ -87,127 +286,57 @@ void InitRecorder(void)
     Cy_SysInt_Init(&DMA_I2S_IRQ_cfg, I2S_Interrupt_User);
     NVIC_EnableIRQ(DMA_I2S_IRQ_cfg.intrSrc);
     
-    /* Initialize the hardware blocks */
+    /* Initialize the hardware blocks, for mono 16-bit */
     Cy_I2S_Init(I2S_HW, &I2S_config);
     Cy_PDM_PCM_Init(PDM_PCM_HW, &PDM_PCM_config);
+    (void) RecordFormatDecode(RECORD_DEF_FORMAT, &recordFormat);
+    (void) RecordFormatDecode(RECORD_FORMAT_PCM16, &playFormat);
     
-    /* Initialize the DMAS and their descriptor addresses */
+    /* The high-pass comes first, the voice activity detector then sees the 
+       levels without the DC offset, before the noise suppression and the gain
+       control. Other stages are added later */
+    DspChainInit(&captureChain, DspDeadline(&recordFormat));
+    DspChainInit(&playChain, DspDeadline(&playFormat));
+    HpfInit(&captureHpf, (RECORD_DEF_HIGHPASS != 0u));
+    (void) DspChainAdd(&captureChain, &hpfStage);
+    VadInit(&captureVad);
+    (void) DspChainAdd(&captureChain, &vadStage);
+    DenoiseInit(&captureDenoise, (RECORD_DEF_DENOISE != 0u));
+    (void) DspChainAdd(&captureChain, &denoiseStage);
+    AgcInit(&captureAgc, (RECORD_DEF_AGC != 0u));
+    (void) DspChainAdd(&captureChain, &agcStage);
+    
+    /* Initialize the DMAS and their descriptor addresses, the record DMA runs
+       on the TX pool chain, loaded on each capture */
     DMA_Record_Init();
-    Cy_DMA_Descriptor_SetSrcAddress(&DMA_Record_PDM_to_SRAM, (void *) &PDM_PCM_HW->RX_FIFO_RD);
-    Cy_DMA_Descriptor_SetDstAddress(&DMA_Record_PDM_to_SRAM, (void *) &txBuffer[0]);
     DMA_Record_SetInterruptMask(DMA_Record_INTR_MASK);
             
-    DMA_PlayLeft_Init();
-    Cy_DMA_Descriptor_SetSrcAddress(&DMA_PlayLeft_SRAM_to_I2S, (void *) &rxBuffer[0]);
-    Cy_DMA_Descriptor_SetDstAddress(&DMA_PlayLeft_SRAM_to_I2S, (void *) &I2S_HW->TX_FIFO_WR);
-
+    /* The play DMA is routed for the format of each record */
     DMA_PlayRight_Init();
-    Cy_DMA_Descriptor_SetSrcAddress(&DMA_PlayRight_SRAM_to_I2S, (void *) &rxBuffer[0]);
-    Cy_DMA_Descriptor_SetDstAddress(&DMA_PlayRight_SRAM_to_I2S, (void *) &I2S_HW->TX_FIFO_WR);
     DMA_PlayRight_SetInterruptMask(DMA_PlayRight_INTR_MASK);    
     
-    /* Scan the SMIF memory sector ONE to obtain information of where to record/play */
-    /* Check if has anything in the memory */
-    ReadMemory((uint8_t *) &sectorInfo, PACKET_SIZE, 0);
-        
-    /* Check if signature was set */
-    if (sectorInfo.signature == SIGNATURE)
-    {       
-        /* Scan for the latest page available in the info sector */
-        for (index = 1; index < NUM_PAGES_IN_SECTOR; index++)
-        {     
-            /* Read information from the other pages in the info sector */
-            memAddress = index * PACKET_SIZE;
-            ReadMemory((uint8_t *) &sectorInfo, PACKET_SIZE, memAddress);
-            
-            /* Check if signature is presented */
-            if (sectorInfo.signature == SIGNATURE)
-            {                      
-                /* Signature match, keep searching */
-            }
-            else
-            {
-                /* No signature presented, found last page available */
-                
-                /* Recover the previous information */
-                memAddress = (index-1) * PACKET_SIZE;
-                ReadMemory((uint8_t *) &sectorInfo, PACKET_SIZE, memAddress);              
-                break;
-            }
-        }
-        
-        /* If no avaliable pages, erase the entire memory */
-        if (index == NUM_PAGES_IN_SECTOR)
-        {
-            EraseMemory(INFO_SECTOR);
-            
-            /* Write new signature */
-            /* Write a new signature */
-            sectorInfo.signature = SIGNATURE;
-            sectorInfo.currentSector = 1;
-            sectorInfo.numberOfPagesRecorded = 0;
-            
-            /* Write new info */
-            WriteMemory((uint8_t *) &sectorInfo, PACKET_SIZE, 0);
-            
-            /* Update current address storing the info sector */
-            currentInfoAddress = 0;
-        }
-        else
-        {
-            /* Update current info address */
-            memAddress = (index-1) * PACKET_SIZE;
-            /* Update current address storing the info sector */
-            currentInfoAddress = memAddress;
-            
-        }
-        
-    }
-    else /* If no signature, erase the memory */
-    {
-        EraseMemory(INFO_SECTOR);
-        
-        /* Write a new signature */
-        sectorInfo.signature = SIGNATURE;
-        sectorInfo.currentSector = 1;
-        sectorInfo.numberOfPagesRecorded = 0;
-        
-        /* Write new info */
-        WriteMemory((uint8_t *) &sectorInfo, PACKET_SIZE, 0);
-        
-        /* Update current address storing the info sector */
-        currentInfoAddress = 0;
-    }
-    
-    /* Update start/end sector variables */
-    startSectorRecorded = sectorInfo.currentSector;
-    endSectorRecorded = sectorInfo.currentSector + sectorInfo.numberOfPagesRecorded/NUM_PAGES_IN_SECTOR;
+    /* Mount the catalog of recordings from the info sector */
+    InitCatalog();
     
-    /* Update the TX Counter */
-    pageTxCount = sectorInfo.numberOfPagesRecorded;
-    pageExCount = pageTxCount;
+    /* Keep what was recorded before a power loss */
+    RecoverRecord();
     
-    /* If the end sector is higher the number of sectors in the memory, wrap it up */
-    if (endSectorRecorded >= NUM_PAGES_IN_SECTOR*NUM_SECTORS_IN_MEM)
+    /* Record after the newest recording, or from the first record sector */
+    if (CatalogLatest() != NO_RECORD_HANDLE)
     {
-        endSectorRecorded = endSectorRecorded - NUM_PAGES_IN_SECTOR*NUM_SECTORS_IN_MEM + 1;
-    }
-       
-    /* Erase the next sector to be ready for recording */
-    if (endSectorRecorded == (NUM_PAGES_IN_SECTOR*NUM_SECTORS_IN_MEM-1))
-    {
-        EraseMemory(FIRST_RECORD_SECTOR);
+        endSectorRecorded = CatalogEndSector(CatalogLatest());
     }
     else
     {
-        EraseMemory(endSectorRecorded+1);        
+        endSectorRecorded = INFO_SECTOR;
     }
     
+    /* Make room for the next recording, its sectors are erased in background */
+    EraseAheadInit(NextEraseSector);
+    PrepareNextRecord();
+    
     /* Enable PDM block */
     Cy_PDM_PCM_Enable(PDM_PCM_HW);
-    
-    /* Release SMIF semaphore */ 
-    xSemaphoreGive(SmifSemphr);
 }
 
 /*******************************************************************************
@@ -215,351 +344,2512 @@ void InitRecorder(void)
 ********************************************************************************
 * Summary:
 *   This function starts a record. It enables the DMA connected to the PDM/PCM.
+*   The recording is added to the catalog when stopped. In loop recording, the 
+*   capture is already running and the record keeps its history. A record 
+*   being played goes on, see StartCapture, otherwise the capture may be 
+*   monitored.
+*
+* Return:
+*   record_handle_t: handle of the new recording.
 *
 *******************************************************************************/
-void StartRecorder(void)
-{       
-    /* Set the start sector recorded */
-    startSectorRecorded = endSectorRecorded + 1;
-
-    if (startSectorRecorded >= NUM_SECTORS_IN_MEM)
+record_handle_t StartRecorder(void)
+{
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+    /* Keep what was captured before the button */
+    if (loopActive)
     {
-        startSectorRecorded = 1;
+        CommitLoopRecorder();
+    }
+    else
+#endif
+    {
+        recordHandle = CatalogReserve();
+        
+        StartCapture();
+        
+        state = RECORDING;
     }
     
-    /* Update end sector variable */
-    endSectorRecorded = startSectorRecorded;
-           
-    /* Initialize the page counters */
-    pageTxCount = 0;
-    pageExCount = 0;
-           
-    /* If playing, stop the I2S and DMAs */
-    Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
-    Cy_DMA_Channel_Disable(DMA_PlayLeft_HW, DMA_PlayLeft_DW_CHANNEL);  
-    I2S_Stop();    
-    
-    /* Reset the channel index for the next recording */
-    DMA_Record_HW->CH_STRUCT[DMA_Record_DW_CHANNEL].CH_IDX = 0;
-    
-    /* Clean-up the PDM_PCM FIFO */
-    Cy_PDM_PCM_ClearFifo(PDM_PCM_HW);
+    /* Listen to the capture, unless a record plays on */
+    if ((RECORD_DUPLEX != 0u) && monitorEnabled && !playing)
+    {
+        StartMonitor();
+    }
     
-    /* Enable DMA to record from the microphone */
-    Cy_DMA_Channel_Enable(DMA_Record_HW, DMA_Record_DW_CHANNEL);
-        
-    state = RECORDING;
+    return recordHandle;
 }
 
 /*******************************************************************************
-* Function Name: StopRecorder
+* Function Name: SetAudioClock
 ********************************************************************************
 * Summary:
-*   This function stops a record. It disables the DMA connected to the PDM/PCM.
+*   This function sets the audio PLL, which clocks the PDM/PCM, the I2S and the
+*   codec MCKI. It only changes between 8 kHz and the 48 kHz and the 44.1 kHz 
+*   families of rates, the blocks divide it down to the rate. The reference is
+*   the source of the clock path, the ECO in this design, read while the PLL 
+*   is bypassed. Neither block may be transferring.
+*
+* Parameters:
+*   clockHz: Frequency of the audio clock.
 *
 *******************************************************************************/
-void StopRecorder(void)
+static void SetAudioClock(uint32_t clockHz)
 {
-    uint32_t memAddress;
-                
-    /* On released, disable the record DMA */
-    Cy_DMA_Channel_Disable(DMA_Record_HW, DMA_Record_DW_CHANNEL);
-    
-    /* Update page in the Info Sector */
-    sectorInfo.signature = SIGNATURE;
-    sectorInfo.currentSector = startSectorRecorded;
-    sectorInfo.numberOfPagesRecorded = pageTxCount;
+    cy_stc_pll_config_t config;
     
-    memAddress = currentInfoAddress + PACKET_SIZE;
-    
-    /* Reserve the SMIF for this task */ 
-    xSemaphoreTake(SmifSemphr, portMAX_DELAY);
-    
-    /* Check if all pages were used */
-    if (memAddress >= SECTOR_SIZE)
+    if (clockHz == audioClockHz)
     {
-        /* Erase info sector */
-        EraseMemory(INFO_SECTOR);
-        
-        /* Reset address */
-        memAddress = 0;
+        return;
     }
-        
-    WriteMemory((uint8_t *) &sectorInfo, PACKET_SIZE, memAddress);
     
-    currentInfoAddress = memAddress;
+    /* The PLL is bypassed while it locks on the new frequency, the path then
+       runs at the frequency of its reference */
+    Cy_SysClk_PllDisable(AUDIO_CLOCK_PATH);
     
-    /* Erase the next sector to be recorded */
-    if (endSectorRecorded == (NUM_PAGES_IN_SECTOR*NUM_SECTORS_IN_MEM-1))
-    {        
-        /* Erase the sector, so data can be written to it */
-        EraseMemory(FIRST_RECORD_SECTOR); 
-    }
-    else
-    {        
-        /* Erase the sector, so data can be written to it */
-        EraseMemory(endSectorRecorded+1); 
+    config.inputFreq  = Cy_SysClk_ClkPathGetFrequency(AUDIO_CLOCK_PATH);
+    config.outputFreq = clockHz;
+    config.lfMode     = false;
+    config.outputMode = CY_SYSCLK_FLLPLL_OUTPUT_AUTO;
+    if ((config.inputFreq == 0u) || (config.inputFreq == audioClockHz))
+    {
+        /* Not reported for a bypassed path, the ECO of the design */
+        config.inputFreq = AUDIO_PLL_INPUT_HZ;
     }
-   
-    /* Release SMIF semaphore */ 
-    xSemaphoreGive(SmifSemphr);
     
-    state = IDLE;
+    Cy_SysClk_PllConfigure(AUDIO_CLOCK_PATH, &config);
+    Cy_SysClk_PllEnable(AUDIO_CLOCK_PATH, AUDIO_PLL_TIMEOUT);
+    
+    audioClockHz = clockHz;
 }
 
 /*******************************************************************************
-* Function Name: PlayRecorder
+* Function Name: ConfigureCapture
 ********************************************************************************
 * Summary:
-*   This function plays the last record. It enables the I2S and the DMAs 
-*   connected to it.
+*   This function sets the PDM/PCM for the format of the recording: one 
+*   microphone or the pair, 16 or 24-bit words sign-extended in the FIFO, and
+*   the clock dividers and decimation of the rate. The block is only 
+*   initialized again when the format changes, at 8 kHz with the generated
+*   dividers. The record DMA must be disabled.
 *
 *******************************************************************************/
-void PlayRecorder(void)
+static void ConfigureCapture(void)
 {
-    uint32_t memAddress;
+    cy_stc_pdm_pcm_config_t config;
+    uint32_t layout = recordFormat.word & (RECORD_FORMAT_STEREO | RECORD_FORMAT_24BIT | RECORD_FORMAT_RATE);
     
-    /* Reserve the SMIF for this task */ 
-    xSemaphoreTake(SmifSemphr, portMAX_DELAY);
+    /* The audio clock may have been set for the rate of a played record */
+    SetAudioClock(recordFormat.clock->clockHz);
     
-    /* Fill up rxBuffer */
-    memAddress = startSectorRecorded * SECTOR_SIZE;
-    ReadMemory(&rxBuffer[0], PACKET_SIZE, memAddress);
-        
-    memAddress = startSectorRecorded * SECTOR_SIZE + PACKET_SIZE;        
-    ReadMemory(&rxBuffer[PACKET_SIZE], PACKET_SIZE, memAddress);
+    if (layout == pdmFormat)
+    {
+        return;
+    }
     
-    /* Release SMIF semaphore */ 
-    xSemaphoreGive(SmifSemphr);
+    /* Same settings as generated, mono 16-bit, but for the rate, the channels and the word */
+    config = PDM_PCM_config;
+    if (recordFormat.clock != &audioRates[0])
+    {
+        config.clkDiv      = CY_PDM_PCM_CLK_DIV_1_4;
+        config.mclkDiv     = CY_PDM_PCM_CLK_DIV_BYPASS;
+        config.ckoDiv      = recordFormat.clock->pdmCkoDiv;
+        config.sincDecRate = recordFormat.clock->pdmSincRate;
+    }
+    if (recordFormat.channels == 2u)
+    {
+        config.chanSelect = CY_PDM_PCM_OUT_STEREO;
+    }
+    if (recordFormat.sampleBits == 24u)
+    {
+        config.wordLen = CY_PDM_PCM_WLEN_24_BIT;
+        config.signExtension = true;
+    }
     
-    pageRxCount = 2;
-             
-    DMA_PlayRight_HW->CH_STRUCT[DMA_PlayRight_DW_CHANNEL].CH_IDX = 0;
-    DMA_PlayLeft_HW->CH_STRUCT[DMA_PlayLeft_DW_CHANNEL].CH_IDX = 0;
+    Cy_PDM_PCM_Disable(PDM_PCM_HW);
+    Cy_PDM_PCM_DeInit(PDM_PCM_HW);
+    Cy_PDM_PCM_Init(PDM_PCM_HW, &config);
+    Cy_PDM_PCM_Enable(PDM_PCM_HW);
     
-    I2S_Start();
-                
-    /* Start playing the recorded data by enabling the DMAs */
-    Cy_DMA_Channel_Enable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
-    Cy_DMA_Channel_Enable(DMA_PlayLeft_HW, DMA_PlayLeft_DW_CHANNEL); 
-
-    state = PLAYING;
+    pdmFormat = layout;
 }
 
 /*******************************************************************************
-* Function Name: RecorderTask
+* Function Name: ConfigurePlayback
 ********************************************************************************
 * Summary:
-*   This function is responsible to housekeep the recording or the playing. It 
-*   checks the DMA flags and write/read data to/from the external memory.
-*
-* Parameters:
-*   arg: Required argument for task function.
+*   This function sets the I2S word and clock, the codec MCKI and rate, for 
+*   the format of the played record, and chains the play DMA descriptors on 
+*   the pages of the read-ahead ring. 16-bit records at 8 kHz use the 
+*   generated I2S settings. The I2S and the play DMA must be stopped.
 *
 *******************************************************************************/
-void RecorderTask(void *arg)
+static void ConfigurePlayback(void)
 {
-    uint32_t memAddress;
-    uint32_t event;
-    uint32_t graphics_event;
-    EventBits_t dmaBits;
-    uint32_t time = 0;
-    static uint32_t lastTime = 0;
-    (void) arg;
+    cy_stc_i2s_config_t i2sConfig;
+    uint32_t layout = playFormat.word & (RECORD_FORMAT_24BIT | RECORD_FORMAT_RATE);
+    uint32_t index;
     
-    InitRecorder();  
+    /* The audio clock may have been set for the rate of the capture */
+    SetAudioClock(playFormat.clock->clockHz);
     
-    while (1)
+    if (layout != i2sFormat)
     {
-        dmaBits = xEventGroupWaitBits(
-                        DmaEvents, 
-                        DMA_I2S_FLAG_BIT | DMA_PDM_FLAG_BIT | RECORD_FLAG_BIT,
-                        true,
-                        false,
-                        portMAX_DELAY);
-        
-        /* Handle writes to the External Memory in chucks */
-        if (pageTxCount > pageExCount)
+        /* 32-bit channels, long enough for 24 bits, the frame clock sets the rate */
+        i2sConfig = I2S_config;
+        if ((playFormat.clock != &audioRates[0]) || (playFormat.sampleBits == 24u))
         {
-            /* OK to keep recording */
-            memAddress = (startSectorRecorded * SECTOR_SIZE) + (pageExCount * PACKET_SIZE);
-            
-            /* If the address is higher than the size of the memory, wrap up the address */
-            if (memAddress >= (SECTOR_SIZE*NUM_SECTORS_IN_MEM))
-            {
-                memAddress = SECTOR_SIZE + memAddress-(SECTOR_SIZE*NUM_SECTORS_IN_MEM);
-            }
-            
-            /* Reserve the SMIF for this task */ 
-            xSemaphoreTake(SmifSemphr, portMAX_DELAY);
-            
-            /* Check if overlap sector */
-            if ((memAddress % SECTOR_SIZE == 0) && (memAddress != (startSectorRecorded * SECTOR_SIZE)))
-            {
-                /* Erase the sector first */
-                EraseMemory(memAddress/SECTOR_SIZE);
-                
-                endSectorRecorded = memAddress/SECTOR_SIZE;
-            }
-            
-            /* Write recorded data to the FLASH */
-            WriteMemory(&txBuffer[(pageExCount % TX_PAGE_MAX_COUNT)*PACKET_SIZE], PACKET_SIZE, memAddress);
-            
-            /* Release SMIF semaphore */ 
-            xSemaphoreGive(SmifSemphr);
-            
-            pageExCount++;    
+            i2sConfig.clkDiv = (uint8_t) ((playFormat.clock->clockHz / (I2S_FRAME_CLOCKS*playFormat.sampleRate)) - 1u);
+            i2sConfig.txChannelLength = CY_I2S_LEN32;
         }
-        
-        /* Handle the DMA PDM interrupt */
-        if (dmaBits & DMA_PDM_FLAG_BIT)
-        {                      
-            /* Increment the page TX count, if the limit not reached */
-            if (pageTxCount < (MAX_RECORD_SIZE*NUM_PAGES_IN_SECTOR))
-            {                
-                pageTxCount++;
-            }
-            else
-            {
-                /* No recording */
-                state = IDLE;
-            }
-            
-            if (state == IDLE)
-            {
-                StopRecorder();
-                
-                event = REACH_MEM_LIMIT;
-                xQueueSend(EventsQueue, &event, 0);
-            }
-            
-            xEventGroupSetBits(DmaEvents, RECORD_FLAG_BIT);
+        if (playFormat.sampleBits == 24u)
+        {
+            i2sConfig.txWordLength = CY_I2S_LEN24;
         }
         
-        /* Handle the DMA I2S interrupt */
-        if (dmaBits & DMA_I2S_FLAG_BIT)
-        {           
-            /* Reserve the SMIF for this task */ 
-            xSemaphoreTake(SmifSemphr, portMAX_DELAY);
-            
-            /* Read next part of the memory */
-            memAddress = (startSectorRecorded * SECTOR_SIZE) + (pageRxCount * PACKET_SIZE);
-            ReadMemory(&rxBuffer[(pageRxCount % 2)*PACKET_SIZE], PACKET_SIZE, memAddress);
-                 
-            /* Release SMIF semaphore */ 
-            xSemaphoreGive(SmifSemphr);
-            
-            pageRxCount++;
-            
-            if (pageRxCount < (pageTxCount) )
-            {
-                /* Keep playing */
-            }
-            else if (pageRxCount >= (pageTxCount))
-            {
-                Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
-                Cy_DMA_Channel_Disable(DMA_PlayLeft_HW, DMA_PlayLeft_DW_CHANNEL);  
-
-                I2S_Stop();
-                
-                /* Play the whole track */
-                state = IDLE;
-                
-                event = PLAY_COMPLETED;
-                xQueueSend(EventsQueue, &event, 0);
-            }            
-            
-            xEventGroupSetBits(DmaEvents, RECORD_FLAG_BIT);
-        }  
+        Cy_I2S_DeInit(I2S_HW);
+        Cy_I2S_Init(I2S_HW, &i2sConfig);
         
-        /* Update the timer on screen */
-        if (state == RECORDING)
-        {
-            /* If recording, play based on pageTxCount */
-            time = (pageTxCount/32);
-            
-        } else if (state == PLAYING)
-        {
-            /* If playing, show based on pageRx Count */
-            time = (pageRxCount/32 );           
-        }
+        /* The codec gets a supported multiple of the rate on MCKI, and runs its filters for the rate */
+        Cy_SysClk_ClkHfSetDivider(AUDIO_MCLK_HF, playFormat.clock->mclkDiv);
+        Codec_SetSamplingRate(playFormat.clock->codecMode);
         
-        /* Only update if the time changed */
-        if (time != lastTime)
-        {
-            graphics_event = SHOW_TIMER | (time);
-            xQueueSend(GUIQueue, &graphics_event, 0);
-        }
-            
-        lastTime = time;        
+        i2sFormat = layout;
+    }
+    
+    /* One descriptor per page of the ring, chained in a ring as well */
+    for (index = 0; index < PLAY_RING_DEPTH; index++)
+    {
+        InitPlayDescr(&ringDescr[index], &rxBuffer[index*PACKET_SIZE + PAGE_HEADER_SIZE],
+                      &ringDescr[(index + 1u) % PLAY_RING_DEPTH]);
     }
 }
 
 /*******************************************************************************
-* Function Name: RecorderState
+* Function Name: InitPlayDescr
 ********************************************************************************
 * Summary:
-*   Return the current state of the recording.
+*   This function sets a play DMA descriptor to move one page payload to the 
+*   I2S TX FIFO, in the format of the played record. The X loop writes the left
+*   and the right sample of a frame, the same sample twice for a mono record, 
+*   and the Y loop steps over the frames. The I2S gets its samples in order 
+*   from a single channel. The descriptor interrupts once the page is played.
 *
-* Return:
-*   recorder_states_t: current state of the recording.
-*     IDLE
-*     RECORDING
-*     PLAYING
-*     PAUSED
+* Parameters:
+*   descr: Descriptor to set.
+*   payload: First sample of the page, in SRAM or in the memory-mapped flash.
+*   next: Descriptor of the next page, NULL to disable the channel after it.
 *
 *******************************************************************************/
-recorder_states_t RecorderState(void)
+static void InitPlayDescr(cy_stc_dma_descriptor_t *descr, const uint8_t *payload, cy_stc_dma_descriptor_t *next)
 {
-    return state;
+    cy_stc_dma_descriptor_config_t config;
+    
+    config = DMA_PlayRight_SRAM_to_I2S_config;
+    config.interruptType  = CY_DMA_DESCR;
+    config.channelState   = (next == NULL) ? CY_DMA_CHANNEL_DISABLED : CY_DMA_CHANNEL_ENABLED;
+    config.descriptorType = CY_DMA_2D_TRANSFER;
+    config.dataSize       = (playFormat.sampleSize == sizeof(int32_t)) ? CY_DMA_WORD : CY_DMA_HALFWORD;
+    config.srcAddress     = (void *) payload;
+    config.dstAddress     = (void *) &I2S_HW->TX_FIFO_WR;
+    config.srcXincrement  = (int32_t) playFormat.channels - 1;
+    config.dstXincrement  = 0;
+    config.xCount         = 2u;
+    config.srcYincrement  = (int32_t) playFormat.channels;
+    config.dstYincrement  = 0;
+    config.yCount         = playFormat.pageFrames;
+    config.nextDescriptor = next;
+    Cy_DMA_Descriptor_Init(descr, &config);
+}
+
+/* Enable the play DMA, the interrupts time the pages from now */
+static void EnablePlayDma(void)
+{
+    i2sPageCycles = (uint32_t) (((uint64_t) playFormat.pageFrames * SystemCoreClock) / playFormat.sampleRate);
+    i2sLastCycles = DWT->CYCCNT;
+    Cy_DMA_Channel_Enable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
 }
 
 /*******************************************************************************
-* Function Name: PauseRecorder
+* Function Name: StartCapture
 ********************************************************************************
 * Summary:
-*   Pause the recording. It only disable the DMAs connected to the I2S.
+*   This function starts capturing into the sectors chosen and erased ahead by 
+*   PrepareNextRecord. It enables the DMA connected to the PDM/PCM. The caller 
+*   sets recordHandle first, NO_RECORD_HANDLE saves no progress. A playback 
+*   goes on when its rate shares the audio clock of the capture, it is 
+*   stopped otherwise. From the memory-mapped flash, it moves to the 
+*   read-ahead ring at the page playing: the programs leave the mapped mode.
 *
 *******************************************************************************/
-void PauseRecorder(void)
-{
-    state = PAUSED;
+static void StartCapture(void)
+{       
+    /* Set the start sector recorded, chosen and erased ahead by PrepareNextRecord */
+    startSectorRecorded = nextSectorRecorded;
     
-    Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
-    Cy_DMA_Channel_Disable(DMA_PlayLeft_HW, DMA_PlayLeft_DW_CHANNEL);  
+    /* Update end sector variable */
+    endSectorRecorded = startSectorRecorded;
+    
+    recordFlags = ProcessingFlags();
+    recordTag = CatalogNextSequence() & 0xFFFFu;
+           
+    /* Initialize the page counters, the whole pool rides over the flash stalls */
+    txPoolStats.peak = 0;
+    txPoolStats.needed = TxPoolNeed(&recordFormat);
+    PageRingInit(&pdmRing, TX_POOL_PAGES);
+    pdmLastSlot = 0;
+    pageStoreCount = 0;
+    pageExCount = 0;
+    pageQueuedCount = 0;
+    pageBacklogPeak = 0;
+    recordPageBase = 0;
+    progressFirstPage = 1u;
+    silentPages = 0;
+    silenceHeld = 0;
+    silenceLast = 0;
+    
+    /* The first captured page opens the first block */
+    AdpcmInit(&recordCodec);
+    
+    /* The page time of the format sets the processing deadline */
+    (void) DspChainSetDeadline(&captureChain, DspDeadline(&recordFormat));
+    DspChainResetStats(&captureChain);
+    captureLoadShown = 0;
+    
+    /* The filters restart, the noise profile is learned from the first frames */
+    HpfInit(&captureHpf, captureHpf.enabled);
+    VadInit(&captureVad);
+    DenoiseInit(&captureDenoise, captureDenoise.enabled);
+    AgcInit(&captureAgc, captureAgc.enabled);
+           
+    /* If playing at another clock, stop the I2S and its DMA */
+    if (playing && !DuplexAllowed(&playFormat))
+    {
+        StopPlayer();
+    }
+#if (PLAY_FROM_XIP != 0u)
+    else if (playing && playXip)
+    {
+        Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
+        Cy_DMA_Channel_ClearInterrupt(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
+        NVIC_ClearPendingIRQ(DMA_I2S_IRQ_cfg.intrSrc);
+        xEventGroupClearBits(DmaEvents, DMA_I2S_FLAG_BIT);
+        
+        /* Read the rest of the record through SRAM, from the page playing */
+        playXip = false;
+        StartPlayAt(((playSeekPage + playPagesDone) < playPageCount) ? (playSeekPage + playPagesDone) : (playPageCount - 1u));
+        SubmitMemory(MEM_OP_UNMAP, NULL, 0, 0, NULL, NULL);
+        
+        if (state == PLAYING)
+        {
+            EnablePlayDma();
+        }
+    }
+#endif
+    
+    /* The start sector is normally banked already, then this completes at once */
+    SubmitMemory(MEM_OP_ERASE, NULL, 0, startSectorRecorded, NULL, NULL);
+    
+    /* Set the PDM/PCM for the format, and restart the channel on the first page of the chain */
+    ConfigureCapture();
+    LoadTxPool();
+    DMA_Record_HW->CH_STRUCT[DMA_Record_DW_CHANNEL].CH_IDX = 0;
+    
+    /* Clean-up the PDM_PCM FIFO */
+    Cy_PDM_PCM_ClearFifo(PDM_PCM_HW);
+    
+    /* Enable DMA to record from the microphone, the interrupts time the pages from now */
+    pdmPageCycles = (uint32_t) (((uint64_t) recordFormat.pageFrames * SystemCoreClock) / recordFormat.sampleRate);
+    pdmLastCycles = DWT->CYCCNT;
+    Cy_DMA_Channel_Enable(DMA_Record_HW, DMA_Record_DW_CHANNEL);
 }
 
 /*******************************************************************************
-* Function Name: ResumeRecorder
+* Function Name: LoadTxPool
 ********************************************************************************
 * Summary:
-*   Resume the recording. It only enable the DMAs connected to the I2S.
+*   This function chains the pages of the TX pool in a ring of record DMA 
+*   descriptors, one page payload each, and sets the channel on the first one.
+*   Each descriptor interrupts when its page is full. A page takes whole 
+*   frames of the recording format, the FIFO interleaves the channels. The 
+*   channel must be disabled.
 *
 *******************************************************************************/
-void ResumeRecorder(void)
+static void LoadTxPool(void)
 {
-    state = PLAYING;
+    cy_stc_dma_descriptor_config_t config;
+    uint32_t index;
     
-    Cy_DMA_Channel_Enable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
-    Cy_DMA_Channel_Enable(DMA_PlayLeft_HW, DMA_PlayLeft_DW_CHANNEL);
+    /* Same transfer as the generated descriptor, without its Y loop over a fixed buffer */
+    config = DMA_Record_PDM_to_SRAM_config;
+    config.interruptType  = CY_DMA_DESCR;
+    config.channelState   = CY_DMA_CHANNEL_ENABLED;
+    config.descriptorType = CY_DMA_1D_TRANSFER;
+    config.dataSize       = (recordFormat.sampleSize == sizeof(int32_t)) ? CY_DMA_WORD : CY_DMA_HALFWORD;
+    config.srcAddress     = (void *) &PDM_PCM_HW->RX_FIFO_RD;
+    config.srcXincrement  = 0;
+    config.dstXincrement  = 1;
+    config.xCount         = recordFormat.pageFrames*recordFormat.channels;
+    
+    for (index = 0; index < TX_POOL_PAGES; index++)
+    {
+        /* Leave room for the page header */
+        config.dstAddress     = (void *) &txPool[index*PACKET_SIZE + PAGE_HEADER_SIZE];
+        config.nextDescriptor = &txPoolDescr[(index + 1u) % TX_POOL_PAGES];
+        Cy_DMA_Descriptor_Init(&txPoolDescr[index], &config);
+    }
+    
+    Cy_DMA_Channel_SetDescriptor(DMA_Record_HW, DMA_Record_DW_CHANNEL, &txPoolDescr[0]);
+}
+
+/*******************************************************************************
+* Function Name: StopRecorder
+********************************************************************************
+* Summary:
+*   This function stops a record. It disables the DMA connected to the PDM/PCM.
+*
+*******************************************************************************/
+void StopRecorder(void)
+{
+    TickType_t start;
+    uint32_t queued;
+    
+    /* On released, disable the record DMA */
+    Cy_DMA_Channel_Disable(DMA_Record_HW, DMA_Record_DW_CHANNEL);
+    
+    /* The monitor ends with the capture, a played record goes on */
+    if (monitorActive)
+    {
+        StopPlayer();
+    }
+    
+    /* Queue the pages not yet submitted, the catalog entry is ordered after them */
+    SubmitRecordedPages();
+    
+    /* Pad the last block with its last sample, it then decodes like the others */
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    vTaskSuspendAll();
+    if ((recordFormat.codec == RECORD_FORMAT_ADPCM) && !AdpcmBlockDone(&recordCodec))
+    {
+        int16_t pad = (int16_t) recordCodec.predictor;
+        
+        while (AdpcmEncode(&recordCodec, &pad, 1u) != 0u)
+        {
+        }
+        SealRecordedPage(pageStoreCount);
+        pageStoreCount++;
+    }
+    
+    /* Close a compact record on its silence, a page of zeros at the last position */
+    if (recordFormat.compact && (silenceLast != 0u) && !RecordLimitReached())
+    {
+        uint8_t *buffer = &txPool[((silenceLast - 1u) % TX_POOL_PAGES)*PACKET_SIZE];
+        
+        memset(&buffer[PAGE_HEADER_SIZE], 0, PAGE_PAYLOAD_SIZE);
+        ((page_header_t *) buffer)->position = (uint16_t) (silenceLast - 1u);
+        pageCaptured[pageStoreCount % TX_POOL_PAGES] = silenceLast - 1u;
+        SealRecordedPage(pageStoreCount);
+        pageStoreCount++;
+        silenceHeld = 0;
+        silenceLast = 0;
+    }
+    xTaskResumeAll();
+    xSemaphoreGive(processLock);
+    
+    /* Queue the rest as the storage task completes the programs before them, 
+       each one sets the record bit. The recorder task may take the bit and 
+       queue them itself, the wait is short. Without progress for a bounded 
+       time, the pages still not queued are lost to the record */
+    start = xTaskGetTickCount();
+    while (pageStoreCount > pageQueuedCount)
+    {
+        queued = pageQueuedCount;
+        xEventGroupClearBits(DmaEvents, RECORD_FLAG_BIT);
+        SubmitRecordedPages();
+        
+        if (pageQueuedCount != queued)
+        {
+            start = xTaskGetTickCount();
+        }
+        else if ((xTaskGetTickCount() - start) >= RECORD_DRAIN_TIMEOUT)
+        {
+            xSemaphoreTake(processLock, portMAX_DELAY);
+            pageStoreCount = pageQueuedCount;
+            recordFlags |= CATALOG_FLAG_OVERRUN;
+            xSemaphoreGive(processLock);
+        }
+        else
+        {
+            xEventGroupWaitBits(DmaEvents, RECORD_FLAG_BIT, pdFALSE, pdFALSE, RECORD_DRAIN_WAIT);
+        }
+    }
+    
+    /* Add the recording to the catalog */
+    if ((pageStoreCount == 0) || !CatalogCommit(recordHandle, startSectorRecorded, pageStoreCount, recordFormat.word, recordFlags))
+    {
+        CatalogRelease(recordHandle);
+    }
+    
+    recordHandle = NO_RECORD_HANDLE;
+    
+    /* Make room for the next recording, its sectors are erased in background */
+    PrepareNextRecord();
+    
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+    /* Capture the history of the next recording there */
+    StartLoopRecorder();
+#endif
+    
+    state = playing ? PLAYING : IDLE;
+}
+
+/*******************************************************************************
+* Function Name: PlayRecorder
+********************************************************************************
+* Summary:
+*   This function plays a record from the catalog. It enables the I2S and the 
+*   DMA connected to it. If there is nothing to play, PLAY_COMPLETED is sent 
+*   right away. While capturing, the record plays through the read-ahead ring
+*   if its rate shares the audio clock of the capture, and the recorder stays 
+*   in the RECORDING state. Otherwise the loop recording is stopped, and a 
+*   recording refuses the playback.
+*
+* Parameters:
+*   handle: handle of the recording.
+*
+*******************************************************************************/
+void PlayRecorder(record_handle_t handle)
+{
+    const catalog_record_t *record = CatalogGet(handle);
+    record_format_t format;
+    uint32_t event;
+    
+    if ((record == NULL) || !RecordFormatDecode(record->format, &format) ||
+        ((state == RECORDING) && !DuplexAllowed(&format)))
+    {
+        event = PLAY_COMPLETED;
+        xQueueSend(EventsQueue, &event, 0);
+        return;
+    }
+    
+    /* A single record plays at a time, the monitor makes way as well */
+    if (playing)
+    {
+        StopPlayer();
+    }
+    
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+    /* The microphone and the speaker only run together on the same clock */
+    if (loopActive && !DuplexAllowed(&format))
+    {
+        StopLoopRecorder();
+    }
+#endif
+    
+    playFormat = format;
+    playHandle = handle;
+    
+    playStartSector = record->startSector;
+    playStoredPages = record->numberOfPages;
+    
+    /* The play DMA counts pages of PCM samples */
+    if (playFormat.codec == RECORD_FORMAT_ADPCM)
+    {
+        playPageCount = (playStoredPages * ADPCM_BLOCK_SAMPLES) / PAGE_SAMPLES;
+    }
+    else if (playFormat.compact)
+    {
+        /* The last page stored holds the last position, the silence is not stored */
+        playOrigin = StoredPosition(0);
+        playPageCount = (uint16_t) (StoredPosition(playStoredPages - 1u) - playOrigin) + 1u;
+    }
+    else
+    {
+        playPageCount = playStoredPages;
+    }
+    
+    /* Compressed, compact or processed records go through SRAM, they cannot play from the flash.
+       Neither while capturing, the programs leave the memory-mapped mode */
+    playXip = (PLAY_FROM_XIP != 0u) && (playFormat.codec == RECORD_FORMAT_PCM16) && !playFormat.compact &&
+              (playChain.first == NULL) && (state != RECORDING) && !loopActive;
+    playUnderrunCount = 0;
+    (void) DspChainSetDeadline(&playChain, DspDeadline(&playFormat));
+    DspChainResetStats(&playChain);
+    
+    /* Switch to memory-mapped mode, after any program still in the queue */
+    if (playXip)
+    {
+        SyncMemory(MEM_OP_MAP, NULL, 0, 0);
+    }
+    
+    /* Set the I2S word and the play DMA for the format */
+    ConfigurePlayback();
+    
+    StartPlayAt(0);
+    
+    I2S_Start();
+                
+    /* Start playing the recorded data by enabling the DMA */
+    EnablePlayDma();
+    
+    playing = true;
+    if (state != RECORDING)
+    {
+        state = PLAYING;
+    }
+}
+
+/*******************************************************************************
+* Function Name: SeekRecorder
+********************************************************************************
+* Summary:
+*   This function moves the play position of the record being played or paused.
+*   The play DMA is stopped, the read-ahead ring is filled again from the new
+*   position and, if playing, the DMA restarts from there. The position is 
+*   rounded down to a page of PCM frames.
+*
+* Parameters:
+*   ms: Position from the start of the record, in milliseconds. Positions past
+*       the end seek to the last page.
+*
+*******************************************************************************/
+void SeekRecorder(uint32_t ms)
+{
+    uint32_t page;
+    
+    if (((state != PLAYING) && (state != PAUSED)) || (playPageCount == 0u))
+    {
+        return;
+    }
+    
+    page = (uint32_t) (((uint64_t) ms * playFormat.sampleRate) / (1000u * playFormat.pageFrames));
+    if (page >= playPageCount)
+    {
+        page = playPageCount - 1u;
+    }
+    
+    Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
+    
+    /* Drop the page event of the old position, if not handled yet */
+    Cy_DMA_Channel_ClearInterrupt(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
+    NVIC_ClearPendingIRQ(DMA_I2S_IRQ_cfg.intrSrc);
+    xEventGroupClearBits(DmaEvents, DMA_I2S_FLAG_BIT);
+    
+    StartPlayAt(page);
+    
+    if (state == PLAYING)
+    {
+        EnablePlayDma();
+    }
+}
+
+/*******************************************************************************
+* Function Name: RecorderPosition
+********************************************************************************
+* Summary:
+*   Return the play position in the record being played, in milliseconds.
+*
+*******************************************************************************/
+uint32_t RecorderPosition(void)
+{
+    return (uint32_t) (((uint64_t) pageRxCount * playFormat.pageFrames * 1000u) / playFormat.sampleRate);
+}
+
+/*******************************************************************************
+* Function Name: RecorderLength
+********************************************************************************
+* Summary:
+*   Return the length of the record being played, in milliseconds.
+*
+*******************************************************************************/
+uint32_t RecorderLength(void)
+{
+    return (uint32_t) (((uint64_t) playPageCount * playFormat.pageFrames * 1000u) / playFormat.sampleRate);
+}
+
+/*******************************************************************************
+* Function Name: StartPlayAt
+********************************************************************************
+* Summary:
+*   This function loads the play DMA to start from a page of the record. From 
+*   the flash, the descriptor ring is loaded with the pages from that one. 
+*   Through SRAM, the ring restarts at that page and is filled before 
+*   returning. The DMA is not enabled.
+*
+* Parameters:
+*   page: Page of PCM samples to play first.
+*
+*******************************************************************************/
+static void StartPlayAt(uint32_t page)
+{
+    uint32_t stored;
+    uint32_t skip;
+    uint32_t last;
+    
+    pageRxCount = page;
+    playSeekPage = page;
+    playPagesDone = 0;
+    
+#if (PLAY_FROM_XIP != 0u)
+    if (playXip)
+    {
+        /* Chain the pages from the one sought, the rest is loaded as they play */
+        for (xipPageLoaded = page; (xipPageLoaded < playPageCount) && (xipPageLoaded < (page + XIP_DESCR_COUNT)); xipPageLoaded++)
+        {
+            LoadXipPage(xipPageLoaded);
+        }
+        
+        Cy_DMA_Channel_SetDescriptor(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL, &xipDescr[page % XIP_DESCR_COUNT]);
+        
+        DMA_PlayRight_HW->CH_STRUCT[DMA_PlayRight_DW_CHANNEL].CH_IDX = 0;
+        return;
+    }
+#endif
+    
+    stored = StoredPageAt(page, &skip);
+    
+    /* Start a new ring, reads still queued for a previous position are dropped */
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    vTaskSuspendAll();
+    ringGeneration++;
+    ringRequested = page;
+    ringRead = page;
+    ringFilled = page;
+    ringDecodeOffset = 0;
+    adpcmRequested = stored;
+    adpcmFilled = stored;
+    adpcmOpened = stored;
+    adpcmSkip = skip;
+    AdpcmInit(&playCodec);
+    playRingActive = true;
+    xTaskResumeAll();
+    xSemaphoreGive(processLock);
+    
+    /* Fill up the ring before starting the DMA */
+    last = ((playPageCount - page) < PLAY_RING_DEPTH) ? playPageCount : (page + PLAY_RING_DEPTH);
+    StepPlayRing();
+    while (ringFilled < last)
+    {
+        MEM_DELAY_FUNC;
+        StepPlayRing();
+    }
+    
+    /* The ring slot of a page is its number modulo the depth */
+    Cy_DMA_Channel_SetDescriptor(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL, &ringDescr[page % PLAY_RING_DEPTH]);
+    
+    DMA_PlayRight_HW->CH_STRUCT[DMA_PlayRight_DW_CHANNEL].CH_IDX = 0;
+}
+
+/*******************************************************************************
+* Function Name: StoredPageAt
+********************************************************************************
+* Summary:
+*   This function maps a page of PCM samples to the stored page holding its 
+*   first sample. PCM pages are stored one to one. An ADPCM page holds one 
+*   block of ADPCM_BLOCK_SAMPLES samples, and each block restarts the decoder 
+*   from its own header, so the block index is computed and no table is kept.
+*   A compact record is searched for its first page stored at or after the 
+*   position, by the headers, the silence before it is played as zeros.
+*
+* Parameters:
+*   page: Page of PCM samples.
+*   skip: Receives the samples of the stored page before the first sample.
+*
+* Return:
+*   uint32_t: The stored page.
+*
+*******************************************************************************/
+static uint32_t StoredPageAt(uint32_t page, uint32_t *skip)
+{
+    uint32_t sample = page * PAGE_SAMPLES;
+    uint32_t stored;
+    uint32_t last;
+    
+    if (playFormat.compact)
+    {
+        stored = 0;
+        last = playStoredPages - 1u;
+        
+        /* The positions grow with the stored pages, the last one is the last page */
+        while (stored < last)
+        {
+            if ((uint16_t) (StoredPosition((stored + last) / 2u) - playOrigin) < page)
+            {
+                stored = ((stored + last) / 2u) + 1u;
+            }
+            else
+            {
+                last = (stored + last) / 2u;
+            }
+        }
+        
+        *skip = 0;
+        return stored;
+    }
+    
+    if (playFormat.codec != RECORD_FORMAT_ADPCM)
+    {
+        *skip = 0;
+        return page;
+    }
+    
+    stored = sample / ADPCM_BLOCK_SAMPLES;
+    *skip = sample - (stored * ADPCM_BLOCK_SAMPLES);
+    
+    return stored;
+}
+
+/* Position in the header of a page of the played record, read from the memory */
+static uint16_t StoredPosition(uint32_t stored)
+{
+    page_header_t header;
+    
+    SyncMemory(MEM_OP_READ, (uint8_t *) &header, sizeof(header), RecordAddress(playStartSector, stored));
+    
+    return header.position;
+}
+
+/*******************************************************************************
+* Function Name: DuplexAllowed
+********************************************************************************
+* Summary:
+*   This function tells if a record can play while capturing. The PDM/PCM and 
+*   the I2S divide the same audio clock, the PLL is set for 8 kHz alone, or 
+*   for the 48 kHz or the 44.1 kHz family.
+*
+* Parameters:
+*   format: Format of the played record.
+*
+* Return:
+*   bool: true if the playback and the capture can run together.
+*
+*******************************************************************************/
+static bool DuplexAllowed(const record_format_t *format)
+{
+    return (RECORD_DUPLEX != 0u) && (format->clock->clockHz == recordFormat.clock->clockHz);
+}
+
+/*******************************************************************************
+* Function Name: StopPlayer
+********************************************************************************
+* Summary:
+*   This function stops the I2S and its DMA, the playback of a record or the 
+*   monitor, and leaves the memory-mapped mode. The state is left to the 
+*   caller. The flags go first, the capture then no longer restarts the DMA.
+*
+*******************************************************************************/
+static void StopPlayer(void)
+{
+    /* Waits for the pages being processed, none is processed after */
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    vTaskSuspendAll();
+    playing = false;
+    playRingActive = false;
+    monitorActive = false;
+    playHandle = NO_RECORD_HANDLE;
+    xTaskResumeAll();
+    xSemaphoreGive(processLock);
+    
+    Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
+    
+    I2S_Stop();
+    
+    /* Leave the memory-mapped mode */
+    SubmitMemory(MEM_OP_UNMAP, NULL, 0, 0, NULL, NULL);
+}
+
+/*******************************************************************************
+* Function Name: StartMonitor
+********************************************************************************
+* Summary:
+*   This function plays the capture on the headphones. The pages processed by
+*   the capture chain are copied into the read-ahead ring, see MonitorPage, 
+*   and the play DMA starts once MONITOR_LATENCY_PAGES are there. Both run 
+*   from the audio clock, the ring neither fills up nor runs dry. Nothing is 
+*   read from the memory.
+*
+*******************************************************************************/
+static void StartMonitor(void)
+{
+    playFormat = recordFormat;
+    ConfigurePlayback();
+    
+    Cy_DMA_Channel_SetDescriptor(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL, &ringDescr[0]);
+    DMA_PlayRight_HW->CH_STRUCT[DMA_PlayRight_DW_CHANNEL].CH_IDX = 0;
+    
+    /* The capture copies its pages from now on, the play never completes */
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    vTaskSuspendAll();
+    ringGeneration++;
+    ringRequested = 0;
+    ringRead = 0;
+    ringFilled = 0;
+    pageRxCount = 0;
+    playSeekPage = 0;
+    playPagesDone = 0;
+    playPageCount = UINT32_MAX;
+    playUnderrunCount = 0;
+    playXip = false;
+    playRingActive = false;
+    playHandle = NO_RECORD_HANDLE;
+    monitorActive = true;
+    playing = true;
+    xTaskResumeAll();
+    xSemaphoreGive(processLock);
+}
+
+/* Copy a page processed by the capture chain to the monitor ring, called with processLock held */
+static void MonitorPage(uint32_t page)
+{
+    /* The slot playing is not overwritten, the page is not heard */
+    if ((ringFilled - playPagesDone) >= PLAY_RING_DEPTH)
+    {
+        return;
+    }
+    
+    memcpy(&rxBuffer[(ringFilled % PLAY_RING_DEPTH)*PACKET_SIZE + PAGE_HEADER_SIZE],
+           &txPool[(page % TX_POOL_PAGES)*PACKET_SIZE + PAGE_HEADER_SIZE], PAGE_PAYLOAD_SIZE);
+    
+    vTaskSuspendAll();
+    ringRead++;
+    ringFilled++;
+    
+    /* Enough pages ahead of the DMA, start playing */
+    if (ringFilled == MONITOR_LATENCY_PAGES)
+    {
+        I2S_Start();
+        EnablePlayDma();
+    }
+    xTaskResumeAll();
+}
+
+/*******************************************************************************
+* Function Name: RecorderTask
+********************************************************************************
+* Summary:
+*   This function is responsible to housekeep the recording or the playing. It 
+*   checks the DMA flags and write/read data to/from the external memory.
+*
+* Parameters:
+*   arg: Required argument for task function.
+*
+*******************************************************************************/
+void RecorderTask(void *arg)
+{
+    uint32_t event;
+    uint32_t graphics_event;
+    EventBits_t dmaBits;
+    uint32_t time = 0;
+    static uint32_t lastTime = 0;
+    (void) arg;
+    
+    InitRecorder();  
+    
+    /* Report how long the catalog took to mount, in 0.1 ms */
+    time = CatalogMountTime() / 100u;
+    graphics_event = SHOW_MOUNT_TIME | ((time > 0xFFFFu) ? 0xFFFFu : time);
+    xQueueSend(GUIQueue, &graphics_event, 0);
+    time = 0;
+    
+#if (RECORD_BENCHMARK_SECTORS != 0u)
+    BenchmarkRecorder();
+#endif
+    
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+    StartLoopRecorder();
+#endif
+    
+    while (1)
+    {
+        dmaBits = xEventGroupWaitBits(
+                        DmaEvents, 
+                        DMA_I2S_FLAG_BIT | DMA_PDM_FLAG_BIT | RECORD_FLAG_BIT | PLAY_FLAG_BIT,
+                        true,
+                        false,
+                        portMAX_DELAY);
+        
+        /* Handle the DMA PDM interrupt, a late one after the capture stopped is dropped */
+        if ((dmaBits & DMA_PDM_FLAG_BIT) && ((state == RECORDING) || loopActive))
+        {                      
+            /* Hand the pages captured since the wakeup over to the storage task */
+            SubmitRecordedPages();
+            
+            /* Track the worst backlog of the storage path */
+            if ((pageStoreCount - pageExCount) > pageBacklogPeak)
+            {
+                pageBacklogPeak = pageStoreCount - pageExCount;
+            }
+            
+            /* Show the TX pool occupancy when it reaches a new peak */
+            if (RecorderPoolStats()->used > txPoolStats.peak)
+            {
+                txPoolStats.peak = txPoolStats.used;
+                
+                graphics_event = SHOW_TX_POOL | (((txPoolStats.peak > 0xFFu) ? 0xFFu : txPoolStats.peak) << 8) | 
+                                 ((txPoolStats.depth > 0xFFu) ? 0xFFu : txPoolStats.depth);
+                xQueueSend(GUIQueue, &graphics_event, 0);
+            }
+            
+            /* Show the processing load when it reaches a new peak, with the rate */
+            if (RecorderCaptureLoad() > captureLoadShown)
+            {
+                captureLoadShown = RecorderCaptureLoad();
+                
+                graphics_event = SHOW_DSP_LOAD | (((captureLoadShown > 0xFFu) ? 0xFFu : captureLoadShown) << 8) | 
+                                 (recordFormat.sampleRate / 1000u);
+                xQueueSend(GUIQueue, &graphics_event, 0);
+            }
+            
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+            /* Slide the loop history */
+            if (loopActive)
+            {
+                xSemaphoreTake(processLock, portMAX_DELAY);
+                TrimLoopHistory();
+                xSemaphoreGive(processLock);
+            }
+#endif
+            
+            if (!RecordLimitReached())
+            {
+                /* Keep recording, the limit not reached */
+            }
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+            else if (loopActive)
+            {
+                /* The history could not slide past a recording, start it over */
+                StopLoopRecorder();
+                StartLoopRecorder();
+            }
+#endif
+            else
+            {
+                /* No recording */
+                state = IDLE;
+                recordFlags |= CATALOG_FLAG_MEM_LIMIT;
+            }
+            
+            if ((state == IDLE) && !loopActive)
+            {
+                StopRecorder();
+                
+                event = REACH_MEM_LIMIT;
+                xQueueSend(EventsQueue, &event, 0);
+            }
+        }
+        
+        /* Retry the pages that did not fit in the storage queue */
+        if ((dmaBits & RECORD_FLAG_BIT) && (pageStoreCount > pageQueuedCount))
+        {
+            SubmitRecordedPages();
+        }
+        
+        /* Process the pages read, and read the next ones */
+        if ((dmaBits & PLAY_FLAG_BIT) && !(dmaBits & DMA_I2S_FLAG_BIT))
+        {
+            StepPlayRing();
+        }
+        
+        /* Handle the DMA I2S interrupt */
+        if (dmaBits & DMA_I2S_FLAG_BIT)
+        {           
+#if (PLAY_FROM_XIP != 0u)
+            if (playXip)
+            {
+                /* The descriptors of the pages played take the pages XIP_DESCR_COUNT ahead */
+                pageRxCount = playSeekPage + playPagesDone;
+                
+                while ((xipPageLoaded < playPageCount) && (xipPageLoaded < (pageRxCount + XIP_DESCR_COUNT)))
+                {
+                    LoadXipPage(xipPageLoaded);
+                    xipPageLoaded++;
+                }
+            }
+            else
+#endif
+            {
+                /* The slots of the pages played can take the pages PLAY_RING_DEPTH ahead */
+                while (pageRxCount < (playSeekPage + playPagesDone))
+                {
+                    pageRxCount++;
+                    
+                    /* The DMA moves on to the next slot, check that its read completed */
+                    if ((pageRxCount < playPageCount) && (ringFilled <= pageRxCount))
+                    {
+                        playUnderrunCount++;
+                    }
+                }
+                
+                StepPlayRing();
+            }
+            
+            if (pageRxCount < (playPageCount) )
+            {
+                /* Keep playing */
+            }
+            else if (pageRxCount >= (playPageCount))
+            {
+                StopPlayer();
+                
+                /* Play the whole track, a recording goes on */
+                if (state != RECORDING)
+                {
+                    state = IDLE;
+                    
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+                    StartLoopRecorder();
+#endif
+                }
+                else if ((RECORD_DUPLEX != 0u) && monitorEnabled)
+                {
+                    /* Back to listening to the capture */
+                    StartMonitor();
+                }
+                
+                event = PLAY_COMPLETED;
+                xQueueSend(EventsQueue, &event, 0);
+            }            
+        }  
+        
+        /* Update the timer on screen */
+        if (state == RECORDING)
+        {
+            /* If recording, play based on the pages captured, less the history dropped */
+            time = ((pdmRing.head - DroppedTxPages())*recordFormat.pageFrames)/recordFormat.sampleRate;
+            
+        } else if (state == PLAYING)
+        {
+            /* If playing, show based on pageRx Count */
+            time = (pageRxCount*playFormat.pageFrames)/playFormat.sampleRate;           
+        }
+        
+        /* Only update if the time changed */
+        if (time != lastTime)
+        {
+            graphics_event = SHOW_TIMER | (time);
+            xQueueSend(GUIQueue, &graphics_event, 0);
+        }
+            
+        lastTime = time;        
+    }
+}
+
+/*******************************************************************************
+* Function Name: SubmitRecordedPages
+********************************************************************************
+* Summary:
+*   This function queues the pages captured in the TX buffer to the storage 
+*   task, encoding them first if the recording is compressed. A sector is 
+*   erased before its first page is programmed. Pages that do not fit in the 
+*   storage queue are retried on the next RECORD_FLAG_BIT, set when a page 
+*   completes. While a record plays through the read-ahead ring, at most 
+*   DUPLEX_PROGRAM_PAGES programs are queued: the storage queue is served in 
+*   order, this bounds the wait of each read, and the reads of the ring bound
+*   the wait of each program.
+*
+*******************************************************************************/
+void SubmitRecordedPages(void)
+{
+    uint32_t memAddress;
+    
+    /* Called by the recorder and the events tasks, keep the page order */
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    
+    StoreRecordedPages();
+    
+    vTaskSuspendAll();
+    
+    while (pageStoreCount > pageQueuedCount)
+    {
+        /* While the play ring reads, few programs are queued ahead of its reads.
+           The others wait in the TX pool, the next page written submits them */
+        if (playRingActive && ((pageQueuedCount - pageExCount) >= DUPLEX_PROGRAM_PAGES))
+        {
+            break;
+        }
+        
+        memAddress = RecordAddress(startSectorRecorded, pageQueuedCount);
+        
+        /* Check if overlap sector */
+        if ((memAddress % SECTOR_SIZE == 0) && (memAddress != (startSectorRecorded * SECTOR_SIZE))
+            && (endSectorRecorded != memAddress/SECTOR_SIZE))
+        {
+            /* While the play ring reads, a full erase in the queue would hold its
+               reads. The pages wait in the TX pool until the bank has the sector */
+            if (playRingActive && EraseAheadPending(memAddress/SECTOR_SIZE))
+            {
+                break;
+            }
+            
+            /* Erase the sector first, the queue keeps it ahead of the program.
+               Completes at once when the erase-ahead bank has it ready */
+            if (!SubmitMemory(MEM_OP_ERASE, NULL, 0, memAddress/SECTOR_SIZE, NULL, NULL))
+            {
+                break;
+            }
+            
+            endSectorRecorded = memAddress/SECTOR_SIZE;
+        }
+        
+        /* Write recorded data to the FLASH, a PCM page releases its slot of the TX buffer */
+        if (!SubmitMemory(MEM_OP_PROGRAM, StoredPageBuffer(pageQueuedCount), 
+                          PACKET_SIZE, memAddress, PageWrittenCallback, 
+                          (recordFormat.codec == RECORD_FORMAT_ADPCM) ? NULL :
+                          (void *) (uintptr_t) (pageCaptured[pageQueuedCount % TX_POOL_PAGES] + 1u)))
+        {
+            break;
+        }
+        
+        pageQueuedCount++;
+        
+        /* Save the progress, it is programmed after the pages queued before.
+           The loop history is not saved until the record button */
+        if ((recordHandle != NO_RECORD_HANDLE) && 
+            ((pageQueuedCount == progressFirstPage) || ((pageQueuedCount % RECORD_PROGRESS_PAGES) == 0u)))
+        {
+            CatalogProgress(recordHandle, startSectorRecorded, pageQueuedCount, recordFormat.word, recordFlags);
+        }
+    }
+    
+    xTaskResumeAll();
+    xSemaphoreGive(processLock);
+}
+
+/*******************************************************************************
+* Function Name: StoreRecordedPages
+********************************************************************************
+* Summary:
+*   This function makes the pages captured by the PDM DMA ready to store. The
+*   capture chain processes each page first. PCM pages are then stored as is, 
+*   but in a compact record the silent ones are dropped, the next page stored 
+*   gives the position. ADPCM pages are encoded in adpcmTxBuffer, one block per
+*   memory page, about four captured pages per block. Each page gets its 
+*   header. Called with processLock held: the pages are processed with the 
+*   scheduler running, it is only suspended around the index updates the 
+*   storage callbacks read.
+*
+*******************************************************************************/
+static void StoreRecordedPages(void)
+{
+    dsp_block_t block;
+    int16_t *pcm;
+    uint32_t page;
+    uint32_t done;
+    bool taken;
+    
+    for (;;)
+    {
+        /* Take the pages captured, the ones after the record limit stay in the ring.
+           An ADPCM page may close the open block and open the next one, both 
+           slots must be free of the blocks queued, else the page waits in the 
+           ring for the next PDM interrupt, and overruns it if the flash lags */
+        vTaskSuspendAll();
+        taken = !RecordLimitReached() && 
+                ((recordFormat.codec != RECORD_FORMAT_ADPCM) || 
+                 ((pageStoreCount - pageExCount) < (ADPCM_TX_PAGES - 1u))) &&
+                PageRingTake(&pdmRing, &page);
+        xTaskResumeAll();
+        
+        if (!taken)
+        {
+            break;
+        }
+        
+        /* The slot is ours until released, process it with the scheduler running */
+        PageBlock(&block, &txPool[(page % TX_POOL_PAGES)*PACKET_SIZE], &recordFormat);
+        DspChainRun(&captureChain, &block);
+        
+        /* The monitor hears every page processed, the silent ones as well */
+        if (monitorActive)
+        {
+            MonitorPage(page);
+        }
+        
+        if (recordFormat.compact && captureVad.silent)
+        {
+            /* Not stored, the slot is free once the pages before it are written */
+            vTaskSuspendAll();
+            silentPages++;
+            silenceHeld = page + 1u;
+            silenceLast = page + 1u;
+            ReleaseSilence();
+            xTaskResumeAll();
+        }
+        else if (recordFormat.codec != RECORD_FORMAT_ADPCM)
+        {
+            /* Programmed from its slot, released once written */
+            pageCaptured[pageStoreCount % TX_POOL_PAGES] = page;
+            ((page_header_t *) StoredPageBuffer(pageStoreCount))->position = recordFormat.compact ? (uint16_t) page : 0u;
+            SealRecordedPage(pageStoreCount);
+            
+            vTaskSuspendAll();
+            pageStoreCount++;
+            silenceLast = 0;
+            xTaskResumeAll();
+        }
+        else
+        {
+            pcm = (int16_t *) &txPool[(page % TX_POOL_PAGES)*PACKET_SIZE + PAGE_HEADER_SIZE];
+            
+            for (done = 0; done < PAGE_SAMPLES; )
+            {
+                /* Open the next block in the next free page */
+                if (AdpcmBlockDone(&recordCodec))
+                {
+                    AdpcmEncodeBlock(&recordCodec, &StoredPageBuffer(pageStoreCount)[PAGE_HEADER_SIZE]);
+                    ((page_header_t *) StoredPageBuffer(pageStoreCount))->position = 0;
+                }
+                
+                done += AdpcmEncode(&recordCodec, &pcm[done], PAGE_SAMPLES - done);
+                
+                if (AdpcmBlockDone(&recordCodec))
+                {
+                    SealRecordedPage(pageStoreCount);
+                    
+                    vTaskSuspendAll();
+                    pageStoreCount++;
+                    xTaskResumeAll();
+                }
+            }
+            
+            /* Encoded, the slot can take a new page */
+            vTaskSuspendAll();
+            PageRingRelease(&pdmRing, page);
+            xTaskResumeAll();
+        }
+    }
+    
+    /* The pages lost to an overrun are skipped, the recording has a gap there */
+    if (PageRingOverruns(&pdmRing) != 0u)
+    {
+        recordFlags |= CATALOG_FLAG_OVERRUN;
+    }
+}
+
+/* Buffer of a page to store, in the TX buffer or in the encoded pages */
+static uint8_t * StoredPageBuffer(uint32_t page)
+{
+    if (recordFormat.codec == RECORD_FORMAT_ADPCM)
+    {
+        return &adpcmTxBuffer[(page % ADPCM_TX_PAGES)*PACKET_SIZE];
+    }
+    
+    return &txPool[(pageCaptured[page % TX_POOL_PAGES] % TX_POOL_PAGES)*PACKET_SIZE];
+}
+
+/* Block of the samples of a page, in a format */
+static void PageBlock(dsp_block_t *block, uint8_t *page, const record_format_t *format)
+{
+    block->samples = &page[PAGE_HEADER_SIZE];
+    block->frames = format->pageFrames;
+    block->channels = format->channels;
+    block->sampleSize = format->sampleSize;
+    block->sampleRate = format->sampleRate;
+}
+
+/* CPU cycles a chain may take on a page, DSP_CPU_PERCENT of the page time */
+static uint32_t DspDeadline(const record_format_t *format)
+{
+    return (uint32_t) (((uint64_t) SystemCoreClock * format->pageFrames * DSP_CPU_PERCENT) / 
+                       (100u * format->sampleRate));
+}
+
+/* Fill the header of a page ready to store, its position is set already */
+static void SealRecordedPage(uint32_t page)
+{
+    uint8_t *buffer = StoredPageBuffer(page);
+    page_header_t *header = (page_header_t *) buffer;
+    
+    header->sequence = (recordTag << 16) | (page & 0xFFFFu);
+    header->crc = PageCrc(buffer);
+}
+
+/* The record is full, or a compact record spans all the header positions */
+static bool RecordLimitReached(void)
+{
+    return (pageStoreCount >= (MAX_RECORD_SIZE*NUM_PAGES_IN_SECTOR)) ||
+           (recordFormat.compact && (pdmRing.read >= COMPACT_MAX_PAGES));
+}
+
+/* Catalog flags of the processing enabled for the recording */
+static uint32_t ProcessingFlags(void)
+{
+    uint32_t flags = 0;
+    
+    if (captureHpf.enabled)
+    {
+        flags |= CATALOG_FLAG_HIGHPASS;
+    }
+    if (captureDenoise.enabled)
+    {
+        flags |= CATALOG_FLAG_DENOISE;
+    }
+    if (captureAgc.enabled)
+    {
+        flags |= CATALOG_FLAG_AGC;
+    }
+    
+    return flags;
+}
+
+/* Free the slots of the silent pages, the ring releases all slots up to a page,
+   so not before the pages stored ahead of them are written */
+static void ReleaseSilence(void)
+{
+    if ((silenceHeld != 0u) && (pageExCount == pageStoreCount))
+    {
+        PageRingRelease(&pdmRing, silenceHeld - 1u);
+        silenceHeld = 0;
+    }
+}
+
+/*******************************************************************************
+* Function Name: RecoverRecord
+********************************************************************************
+* Summary:
+*   This function recovers a recording interrupted by a power loss. The catalog
+*   knows how many pages were queued at the last saved progress. The pages 
+*   after it are read while their header carries the recording tag, the next 
+*   page number and a good CRC, for at most RECOVERY_TIME. The recording is 
+*   then committed with the length found.
+*
+*******************************************************************************/
+static void RecoverRecord(void)
+{
+    catalog_record_t record;
+    record_handle_t handle = CatalogInterrupted(&record);
+    TickType_t startTick = xTaskGetTickCount();
+    uint32_t pages;
+    
+    if (handle == NO_RECORD_HANDLE)
+    {
+        return;
+    }
+    
+    /* The first page read does not depend on the progress being right */
+    for (pages = record.numberOfPages - 1u; pages < (MAX_RECORD_SIZE*NUM_PAGES_IN_SECTOR); pages++)
+    {
+        if ((xTaskGetTickCount() - startTick) >= RECOVERY_TIME)
+        {
+            break;
+        }
+        
+        SyncMemory(MEM_OP_READ, rxBuffer, PACKET_SIZE, RecordAddress(record.startSector, pages));
+        
+        if (!ValidRecordedPage(rxBuffer, record.sequence & 0xFFFFu, pages))
+        {
+            break;
+        }
+    }
+    
+    if ((pages == 0) || 
+        !CatalogCommit(handle, record.startSector, pages, record.format, record.flags | CATALOG_FLAG_RECOVERED))
+    {
+        CatalogRelease(handle);
+    }
+}
+
+/* Check the header of a page read back from the memory */
+static bool ValidRecordedPage(const uint8_t *page, uint32_t tag, uint32_t number)
+{
+    const page_header_t *header = (const page_header_t *) page;
+    
+    return ((header->sequence == ((tag << 16) | (number & 0xFFFFu))) && (header->crc == PageCrc(page)));
+}
+
+/* CRC-16-CCITT of the page, without the CRC field, a nibble at a time */
+static uint16_t PageCrc(const uint8_t *page)
+{
+    static const uint16_t crcNibble[16] =
+    {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+    };
+    uint16_t crc = 0xFFFFu;
+    uint32_t index;
+    
+    for (index = 0; index < PACKET_SIZE; index++)
+    {
+        /* Skip the CRC itself */
+        if ((index == offsetof(page_header_t, crc)) || (index == (offsetof(page_header_t, crc) + 1u)))
+        {
+            continue;
+        }
+        
+        crc = (uint16_t) ((crc << 4) ^ crcNibble[(crc >> 12) ^ (page[index] >> 4)]);
+        crc = (uint16_t) ((crc << 4) ^ crcNibble[(crc >> 12) ^ (page[index] & 0x0Fu)]);
+    }
+    
+    return crc;
+}
+
+/* Address of a page of a record, wrapping to the first record sector */
+static uint32_t RecordAddress(uint32_t sector, uint32_t page)
+{
+    uint32_t memAddress = (sector * SECTOR_SIZE) + (page * PACKET_SIZE);
+    
+    /* If the address is higher than the size of the memory, wrap up the address
+       to the first record sector, past the info sectors */
+    if (memAddress >= (SECTOR_SIZE*NUM_SECTORS_IN_MEM))
+    {
+        memAddress = (FIRST_RECORD_SECTOR*SECTOR_SIZE) + memAddress-(SECTOR_SIZE*NUM_SECTORS_IN_MEM);
+    }
+    
+    return memAddress;
+}
+
+/* Sectors are recorded in sequence, wrapping to the first record sector */
+static uint32_t NextRecordSector(uint32_t sector)
+{
+    sector++;
+    
+    if ((sector >= NUM_SECTORS_IN_MEM) || (sector < FIRST_RECORD_SECTOR))
+    {
+        sector = FIRST_RECORD_SECTOR;
+    }
+    
+    return sector;
+}
+
+/* Erase ahead only the sectors free in the catalog, runs in the storage task */
+static uint32_t NextEraseSector(uint32_t sector)
+{
+    sector = NextRecordSector(sector);
+    
+    return (CatalogOwner(sector) == NO_RECORD_HANDLE) ? sector : MEM_NO_SECTOR;
+}
+
+/*******************************************************************************
+* Function Name: PrepareNextRecord
+********************************************************************************
+* Summary:
+*   This function chooses where the next record starts, frees MAX_RECORD_SECTORS
+*   sectors from there, deleting the recordings found there, and restarts the 
+*   erase-ahead bank on them. The next record can then never overwrite a 
+*   catalogued one.
+*
+*******************************************************************************/
+static void PrepareNextRecord(void)
+{
+    uint32_t sector;
+    uint32_t index;
+    uint32_t event;
+    
+    nextSectorRecorded = PickRecordSector();
+    
+    sector = nextSectorRecorded;
+    for (index = 0; index < MAX_RECORD_SECTORS; index++)
+    {
+        /* A record played while recording is stopped before its sectors are erased */
+        if (playing && (playHandle != NO_RECORD_HANDLE) && (CatalogOwner(sector) == playHandle))
+        {
+            StopPlayer();
+            
+            event = PLAY_COMPLETED;
+            xQueueSend(EventsQueue, &event, 0);
+        }
+        
+        CatalogDelete(CatalogOwner(sector));
+        sector = NextRecordSector(sector);
+    }
+    
+    SubmitMemory(MEM_OP_ERASE_AHEAD, NULL, 0, nextSectorRecorded, NULL, NULL);
+}
+
+/* Captured pages of the loop history dropped before the record start */
+static uint32_t DroppedTxPages(void)
+{
+    if (recordFormat.codec == RECORD_FORMAT_ADPCM)
+    {
+        return (uint32_t) (((uint64_t) recordPageBase * ADPCM_BLOCK_SAMPLES) / PAGE_SAMPLES);
+    }
+    
+    return recordPageBase;
+}
+
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+/*******************************************************************************
+* Function Name: StartLoopRecorder
+********************************************************************************
+* Summary:
+*   This function starts the loop recording in the sectors prepared for the 
+*   next record. The recorder stays IDLE, no progress is saved in the catalog 
+*   until the record button commits the history with CommitLoopRecorder.
+*
+*******************************************************************************/
+static void StartLoopRecorder(void)
+{
+    if (loopActive)
+    {
+        return;
+    }
+    
+    /* Set before the capture, the PDM DMA handler checks it */
+    recordHandle = NO_RECORD_HANDLE;
+    loopActive = true;
+    
+    StartCapture();
+}
+
+/*******************************************************************************
+* Function Name: StopLoopRecorder
+********************************************************************************
+* Summary:
+*   This function stops the loop recording and drops its history. The next 
+*   record is prepared after the last sector captured, so the sectors of the 
+*   history are left to the erase-ahead bank.
+*
+*******************************************************************************/
+static void StopLoopRecorder(void)
+{
+    Cy_DMA_Channel_Disable(DMA_Record_HW, DMA_Record_DW_CHANNEL);
+    xEventGroupClearBits(DmaEvents, DMA_PDM_FLAG_BIT);
+    
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    loopActive = false;
+    
+    /* The counters restart with the next capture, let the queued pages complete */
+    while (pageExCount != pageQueuedCount)
+    {
+        MEM_DELAY_FUNC;
+    }
+    xSemaphoreGive(processLock);
+    
+    /* Make room for the next recording, its sectors are erased in background */
+    PrepareNextRecord();
+}
+
+/*******************************************************************************
+* Function Name: CommitLoopRecorder
+********************************************************************************
+* Summary:
+*   This function turns the loop recording into a record, when the record 
+*   button is pressed. The history older than RECORD_PRETRIGGER_SECONDS is 
+*   trimmed to the sector, and the pages not queued yet take the tag of the 
+*   recording. The pages already queued keep the loop numbering, the first 
+*   progress is saved after them so the power-loss recovery never checks them.
+*
+*******************************************************************************/
+static void CommitLoopRecorder(void)
+{
+    record_handle_t handle = CatalogReserve();
+    uint32_t page;
+    
+    /* No page is being encoded in the buffers sealed again */
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    vTaskSuspendAll();
+    
+    TrimLoopHistory();
+    
+    recordTag = CatalogNextSequence() & 0xFFFFu;
+    for (page = pageQueuedCount; page < pageStoreCount; page++)
+    {
+        SealRecordedPage(page);
+    }
+    
+    progressFirstPage = pageQueuedCount + 1u;
+    recordFlags = ProcessingFlags();
+    recordHandle = handle;
+    loopActive = false;
+    state = RECORDING;
+    
+    xTaskResumeAll();
+    xSemaphoreGive(processLock);
+}
+
+/*******************************************************************************
+* Function Name: TrimLoopHistory
+********************************************************************************
+* Summary:
+*   This function drops the sectors of the loop history all older than 
+*   RECORD_PRETRIGGER_SECONDS. The start sector moves to the next one, and the 
+*   page counters go back by the pages of a sector. A sector is only dropped 
+*   once all its pages are programmed, and when the sector after the end of 
+*   the longest record from the new start is free in the catalog: the record 
+*   committed later never overwrites a catalogued one. Otherwise the history 
+*   grows, up to the maximum record size.
+*
+*******************************************************************************/
+static void TrimLoopHistory(void)
+{
+    uint32_t samples = (recordFormat.codec == RECORD_FORMAT_ADPCM) ? ADPCM_BLOCK_SAMPLES : recordFormat.pageFrames;
+    uint32_t pretrigger = (RECORD_PRETRIGGER_SECONDS*recordFormat.sampleRate + samples - 1u) / samples;
+    uint32_t sector;
+    uint32_t index;
+    uint32_t page;
+    
+    /* Called with processLock held, the storage callbacks count the pages written */
+    vTaskSuspendAll();
+    
+    while ((pageStoreCount >= (pretrigger + LOOP_SECTOR_PAGES)) && (pageExCount >= LOOP_SECTOR_PAGES))
+    {
+        /* Last sector of the longest record from the next start sector */
+        sector = startSectorRecorded;
+        for (index = 0; index < MAX_RECORD_SECTORS; index++)
+        {
+            sector = NextRecordSector(sector);
+        }
+        
+        if (CatalogOwner(sector) != NO_RECORD_HANDLE)
+        {
+            break;
+        }
+        
+        startSectorRecorded = NextRecordSector(startSectorRecorded);
+        recordPageBase += LOOP_SECTOR_PAGES;
+        pageStoreCount -= LOOP_SECTOR_PAGES;
+        pageQueuedCount -= LOOP_SECTOR_PAGES;
+        pageExCount -= LOOP_SECTOR_PAGES;
+        
+        /* Number the pages not queued yet from the new start sector */
+        for (page = pageQueuedCount; page < pageStoreCount; page++)
+        {
+            SealRecordedPage(page);
+        }
+    }
+    
+    xTaskResumeAll();
+}
+#endif
+
+#if (RECORD_BENCHMARK_SECTORS != 0u)
+/*******************************************************************************
+* Function Name: BenchmarkRecorder
+********************************************************************************
+* Summary:
+*   This function runs the flash benchmark on the first recording sectors and
+*   shows the erase, program and read throughput, then the CPU cycles per page
+*   of each SMIF data transport. The recordings there are 
+*   deleted first, and the erase-ahead bank is restarted afterwards. The SMIF 
+*   latency statistics are cleared, so they cover the benchmark only.
+*
+*******************************************************************************/
+static void BenchmarkRecorder(void)
+{
+    mem_bench_t bench;
+    uint32_t graphics_event;
+    uint32_t sector;
+    uint32_t count = RECORD_BENCHMARK_SECTORS;
+    
+    if (count > (NUM_SECTORS_IN_MEM - FIRST_RECORD_SECTOR))
+    {
+        count = NUM_SECTORS_IN_MEM - FIRST_RECORD_SECTOR;
+    }
+    
+    for (sector = FIRST_RECORD_SECTOR; sector < (FIRST_RECORD_SECTOR + count); sector++)
+    {
+        CatalogDelete(CatalogOwner(sector));
+    }
+    
+    MemoryLatencyReset();
+    BenchmarkMemory(FIRST_RECORD_SECTOR, count, txPool, &bench);
+    
+    /* Throughput in kB/s, shown in MB/s */
+    graphics_event = SHOW_BENCH_ERASE | ((bench.eraseKBps > 0xFFFFu) ? 0xFFFFu : bench.eraseKBps);
+    xQueueSend(GUIQueue, &graphics_event, 0);
+    graphics_event = SHOW_BENCH_PROGRAM | ((bench.programKBps > 0xFFFFu) ? 0xFFFFu : bench.programKBps);
+    xQueueSend(GUIQueue, &graphics_event, 0);
+    graphics_event = SHOW_BENCH_READ | ((bench.readKBps > 0xFFFFu) ? 0xFFFFu : bench.readKBps);
+    xQueueSend(GUIQueue, &graphics_event, 0);
+    graphics_event = SHOW_BENCH_ISR | BenchCyclesPerPage(&bench.isr);
+    xQueueSend(GUIQueue, &graphics_event, 0);
+    if (bench.dma.pages != 0u)
+    {
+        graphics_event = SHOW_BENCH_DMA | BenchCyclesPerPage(&bench.dma);
+        xQueueSend(GUIQueue, &graphics_event, 0);
+    }
+    
+    PrepareNextRecord();
+}
+
+/* CPU cycles per page of a transport, saturated for the display event */
+static uint32_t BenchCyclesPerPage(const mem_bench_xfer_t *cost)
+{
+    uint32_t cycles = (cost->pages != 0u) ? (cost->cycles / cost->pages) : 0u;
+    
+    return (cycles > 0xFFFFu) ? 0xFFFFu : cycles;
+}
+#endif
+
+/*******************************************************************************
+* Function Name: PickRecordSector
+********************************************************************************
+* Summary:
+*   This function returns the start sector of the next record. Among the runs 
+*   of MAX_RECORD_SECTORS free sectors, the one erased the least is taken, so 
+*   the wear stays even over the memory. Ties go to the first run after the 
+*   last record. Without a free run, the record replaces the oldest one.
+*
+* Return:
+*   uint32_t: start sector of the next record.
+*
+*******************************************************************************/
+static uint32_t PickRecordSector(void)
+{
+    uint32_t start = NextRecordSector(endSectorRecorded);
+    uint32_t best = MEM_NO_SECTOR;
+    uint32_t bestWear = 0;
+    uint32_t wear;
+    uint32_t sector;
+    uint32_t index;
+    uint32_t count;
+    
+    for (count = FIRST_RECORD_SECTOR; count < NUM_SECTORS_IN_MEM; count++)
+    {
+        wear = 0;
+        sector = start;
+        
+        for (index = 0; index < MAX_RECORD_SECTORS; index++)
+        {
+            if (CatalogOwner(sector) != NO_RECORD_HANDLE)
+            {
+                break;
+            }
+            
+            wear += EraseCount(sector);
+            sector = NextRecordSector(sector);
+        }
+        
+        if ((index == MAX_RECORD_SECTORS) && ((best == MEM_NO_SECTOR) || (wear < bestWear)))
+        {
+            best = start;
+            bestWear = wear;
+        }
+        
+        start = NextRecordSector(start);
+    }
+    
+    if (best != MEM_NO_SECTOR)
+    {
+        return best;
+    }
+    
+    /* Memory full, reuse the sectors of the oldest record */
+    if (CatalogOldest() != NO_RECORD_HANDLE)
+    {
+        return CatalogGet(CatalogOldest())->startSector;
+    }
+    
+    return NextRecordSector(endSectorRecorded);
+}
+
+/* Count the pages stored, runs in the storage task */
+static void PageWrittenCallback(mem_op_t op, uint32_t address, void *arg)
+{
+    (void) op;
+    (void) address;
+    
+    pageExCount++;
+    
+    /* A PCM page is programmed from the TX buffer, its slot is free now */
+    if (arg != NULL)
+    {
+        PageRingRelease(&pdmRing, (uint32_t) (uintptr_t) arg - 1u);
+    }
+    
+    /* And the silent pages captured after it, in a compact record */
+    ReleaseSilence();
+    
+    /* Room in the storage queue, let the recorder submit the pending pages */
+    if (pageStoreCount > pageQueuedCount)
+    {
+        xEventGroupSetBits(DmaEvents, RECORD_FLAG_BIT);
+    }
+}
+
+#if (PLAY_FROM_XIP != 0u)
+/*******************************************************************************
+* Function Name: LoadXipPage
+********************************************************************************
+* Summary:
+*   This function loads a page of the record in the play DMA descriptor ring,
+*   its samples are read from the memory-mapped flash. The descriptor of the 
+*   last page ends the chain and disables the channel.
+*
+* Parameters:
+*   page: Page of the record.
+*
+*******************************************************************************/
+static void LoadXipPage(uint32_t page)
+{
+    uint32_t memAddress = (playStartSector * SECTOR_SIZE) + (page * PACKET_SIZE);
+    
+    /* If the address is higher than the size of the memory, wrap up the address
+       to the first record sector, past the info sectors */
+    if (memAddress >= (SECTOR_SIZE*NUM_SECTORS_IN_MEM))
+    {
+        memAddress = (FIRST_RECORD_SECTOR*SECTOR_SIZE) + memAddress-(SECTOR_SIZE*NUM_SECTORS_IN_MEM);
+    }
+    
+    InitPlayDescr(&xipDescr[page % XIP_DESCR_COUNT], MappedAddress(memAddress) + PAGE_HEADER_SIZE,
+                  ((page + 1u) < playPageCount) ? &xipDescr[(page + 1u) % XIP_DESCR_COUNT] : NULL);
+}
+#endif
+
+/*******************************************************************************
+* Function Name: StepPlayRing
+********************************************************************************
+* Summary:
+*   This function processes the pages read into the ring, then queues the next
+*   reads. It is called on each played page and when a read completes, the 
+*   storage task sets PLAY_FLAG_BIT, so the ring refills as soon as the storage
+*   task gets the bus. Called by the recorder and the events tasks, the pages 
+*   are processed with the scheduler running.
+*
+*******************************************************************************/
+static void StepPlayRing(void)
+{
+    xSemaphoreTake(processLock, portMAX_DELAY);
+    
+    ProcessPlayRing();
+    FillPlayRing();
+    
+    xSemaphoreGive(processLock);
+}
+
+/* Run the play chain on the pages read, decode or expand the stored pages, called with processLock held */
+static void ProcessPlayRing(void)
+{
+    dsp_block_t block;
+    
+    if (!playRingActive)
+    {
+        return;
+    }
+    
+    if (playFormat.compact)
+    {
+        ExpandPlayRing();
+    }
+    else if (playFormat.codec == RECORD_FORMAT_ADPCM)
+    {
+        DecodePlayRing();
+    }
+    else
+    {
+        /* Reads complete in order, the slots up to ringRead are there */
+        while (ringFilled < ringRead)
+        {
+            PageBlock(&block, &rxBuffer[(ringFilled % PLAY_RING_DEPTH)*PACKET_SIZE], &playFormat);
+            DspChainRun(&playChain, &block);
+            
+            ringFilled++;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: FillPlayRing
+********************************************************************************
+* Summary:
+*   This function queues the reads of the pages ahead of the play DMA, as long 
+*   as the ring has free slots. A slot is free once the DMA has played it. 
+*   ADPCM records are read in adpcmRxBuffer instead and decoded into the ring,
+*   compact records are read there as well and expanded into the ring with 
+*   their silence. Called with processLock held.
+*
+*******************************************************************************/
+static void FillPlayRing(void)
+{
+    uint32_t memAddress;
+    
+    if (playRingActive && ((playFormat.codec == RECORD_FORMAT_ADPCM) || playFormat.compact))
+    {
+        /* The block being decoded keeps its page, the others are read ahead */
+        while ((adpcmRequested < playStoredPages) && 
+               ((adpcmRequested - adpcmOpened) < (ADPCM_RX_PAGES - 1u)))
+        {
+            memAddress = RecordAddress(playStartSector, adpcmRequested);
+            
+            if (!SubmitMemory(MEM_OP_READ, &adpcmRxBuffer[(adpcmRequested % ADPCM_RX_PAGES)*PACKET_SIZE], 
+                              PACKET_SIZE, memAddress, PageReadCallback, (void *) (uintptr_t) ringGeneration))
+            {
+                break;
+            }
+            
+            adpcmRequested++;
+        }
+    }
+    
+    while (playRingActive && (playFormat.codec == RECORD_FORMAT_PCM16) && !playFormat.compact &&
+           (ringRequested < playPageCount) && (ringRequested < (pageRxCount + PLAY_RING_DEPTH)))
+    {
+        memAddress = RecordAddress(playStartSector, ringRequested);
+        
+        if (!SubmitMemory(MEM_OP_READ, &rxBuffer[(ringRequested % PLAY_RING_DEPTH)*PACKET_SIZE], 
+                          PACKET_SIZE, memAddress, PageReadCallback, (void *) (uintptr_t) ringGeneration))
+        {
+            break;
+        }
+        
+        ringRequested++;
+    }
+}
+
+/*******************************************************************************
+* Function Name: DecodePlayRing
+********************************************************************************
+* Summary:
+*   This function decodes the ADPCM blocks already read into the free slots of 
+*   the ring. A block spans about four slots, a slot may start in one block and
+*   end in the next. The play chain processes each slot once decoded. Called 
+*   with processLock held.
+*
+*******************************************************************************/
+static void DecodePlayRing(void)
+{
+    dsp_block_t block;
+    int16_t *slot;
+    
+    while ((ringFilled < playPageCount) && (ringFilled < (pageRxCount + PLAY_RING_DEPTH)))
+    {
+        if (AdpcmBlockDone(&playCodec))
+        {
+            /* Wait for the read of the next block */
+            if (adpcmOpened >= adpcmFilled)
+            {
+                break;
+            }
+            
+            AdpcmDecodeBlock(&playCodec, &adpcmRxBuffer[(adpcmOpened % ADPCM_RX_PAGES)*PACKET_SIZE + PAGE_HEADER_SIZE]);
+            adpcmOpened++;
+        }
+        
+        slot = (int16_t *) &rxBuffer[(ringFilled % PLAY_RING_DEPTH)*PACKET_SIZE + PAGE_HEADER_SIZE];
+        
+        /* After a seek, the samples of the block before the position are decoded over the slot */
+        while (adpcmSkip > 0u)
+        {
+            adpcmSkip -= AdpcmDecode(&playCodec, slot, (adpcmSkip < PAGE_SAMPLES) ? adpcmSkip : PAGE_SAMPLES);
+        }
+        ringDecodeOffset += AdpcmDecode(&playCodec, &slot[ringDecodeOffset], PAGE_SAMPLES - ringDecodeOffset);
+        
+        if (ringDecodeOffset >= PAGE_SAMPLES)
+        {
+            PageBlock(&block, &rxBuffer[(ringFilled % PLAY_RING_DEPTH)*PACKET_SIZE], &playFormat);
+            DspChainRun(&playChain, &block);
+            
+            ringDecodeOffset = 0;
+            ringFilled++;
+        }
+    }
+}
+
+/*******************************************************************************
+* Function Name: ExpandPlayRing
+********************************************************************************
+* Summary:
+*   This function fills the free slots of the ring from the pages of a compact
+*   record already read. A slot before the position of the next stored page is
+*   silence, it is zeroed, the slot at its position takes its samples. The 
+*   play chain processes each slot once filled. Called with processLock held.
+*
+*******************************************************************************/
+static void ExpandPlayRing(void)
+{
+    dsp_block_t block;
+    uint8_t *stored;
+    uint8_t *slot;
+    
+    while ((ringFilled < playPageCount) && (ringFilled < (pageRxCount + PLAY_RING_DEPTH)))
+    {
+        /* Wait for the read of the next stored page, its position ends the silence */
+        if (adpcmOpened >= adpcmFilled)
+        {
+            break;
+        }
+        
+        stored = &adpcmRxBuffer[(adpcmOpened % ADPCM_RX_PAGES)*PACKET_SIZE];
+        slot = &rxBuffer[(ringFilled % PLAY_RING_DEPTH)*PACKET_SIZE];
+        
+        if ((uint16_t) (((page_header_t *) stored)->position - playOrigin) == ringFilled)
+        {
+            memcpy(&slot[PAGE_HEADER_SIZE], &stored[PAGE_HEADER_SIZE], PAGE_PAYLOAD_SIZE);
+            adpcmOpened++;
+        }
+        else
+        {
+            memset(&slot[PAGE_HEADER_SIZE], 0, PAGE_PAYLOAD_SIZE);
+        }
+        
+        PageBlock(&block, slot, &playFormat);
+        DspChainRun(&playChain, &block);
+        
+        ringFilled++;
+    }
+}
+
+/* Count the pages read, the recorder task processes them before the DMA plays them, runs in the storage task */
+static void PageReadCallback(mem_op_t op, uint32_t address, void *arg)
+{
+    (void) op;
+    (void) address;
+    
+    if ((uintptr_t) arg == ringGeneration)
+    {
+        if ((playFormat.codec == RECORD_FORMAT_ADPCM) || playFormat.compact)
+        {
+            adpcmFilled++;
+        }
+        else
+        {
+            ringRead++;
+        }
+        
+        /* Pages to process, reads that did not fit in the storage queue */
+        xEventGroupSetBits(DmaEvents, PLAY_FLAG_BIT);
+    }
+}
+
+/*******************************************************************************
+* Function Name: RecorderState
+********************************************************************************
+* Summary:
+*   Return the current state of the recording.
+*
+* Return:
+*   recorder_states_t: current state of the recording.
+*     IDLE
+*     RECORDING
+*     PLAYING
+*     PAUSED
+*
+*******************************************************************************/
+recorder_states_t RecorderState(void)
+{
+    return state;
+}
+
+/*******************************************************************************
+* Function Name: SetRecorderFormat
+********************************************************************************
+* Summary:
+*   Select the format of the next recordings. Refused while recording, if the 
+*   format is not supported, if the memory cannot program it as fast as it is
+*   captured, see RECORD_FLASH_BUDGET_US, or if the TX pool does not ride over 
+*   the program latency measured, see TX_POOL_PAGES. The format of a 
+*   recording is stored with it in the catalog.
+*
+* Parameters:
+*   format: RECORD_FORMAT_PCM16 or RECORD_FORMAT_ADPCM, PCM with the layout 
+*           bits RECORD_FORMAT_STEREO and RECORD_FORMAT_24BIT, and the
+*           RECORD_FORMAT_COMPACT flag.
+*
+* Return:
+*   bool: false if the format was refused, the previous one is kept.
+*
+*******************************************************************************/
+bool SetRecorderFormat(uint32_t format)
+{
+    record_format_t decoded;
+    
+    if (format == recordFormat.word)
+    {
+        return true;
+    }
+    if ((state == RECORDING) || !RecordFormatDecode(format, &decoded) ||
+        (RecordFlashTime(&decoded) > RECORD_FLASH_BUDGET_US) || (TxPoolNeed(&decoded) > TX_POOL_PAGES))
+    {
+        return false;
+    }
+    
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+    /* The loop history is in the previous format, start it over */
+    if (loopActive)
+    {
+        StopLoopRecorder();
+        recordFormat = decoded;
+        StartLoopRecorder();
+        return true;
+    }
+#endif
+    recordFormat = decoded;
+    
+    return true;
+}
+
+/* Flash time, in microseconds, a second of capture in a format takes. ADPCM 
+   is counted as PCM, four times over */
+static uint32_t RecordFlashTime(const record_format_t *format)
+{
+    uint32_t pages = (format->sampleRate + format->pageFrames - 1u) / format->pageFrames;
+    
+    return (pages * (MEM_PROGRAM_US + MEM_SUSPEND_US)) + 
+           (uint32_t) (((uint64_t) pages * MEM_ERASE_US) / (SECTOR_SIZE / PACKET_SIZE));
+}
+
+/* Pages of the TX pool a format needs, each program taking the typical time 
+   or the longest one measured */
+static uint32_t TxPoolNeed(const record_format_t *format)
+{
+    mem_latency_t latency;
+    uint32_t pageUs = (format->pageFrames*1000000u) / format->sampleRate;
+    uint32_t programUs = MEM_PROGRAM_US + MEM_SUSPEND_US;
+    
+    MemoryLatency(MEM_LAT_PROGRAM, &latency);
+    if ((latency.count != 0u) && (latency.maxUs > programUs))
+    {
+        programUs = latency.maxUs;
+    }
+    
+    return TX_POOL_NEED(pageUs, TX_POOL_HOLD_US + TX_POOL_PROGRAMS*programUs);
+}
+
+/*******************************************************************************
+* Function Name: SetRecorderRate
+********************************************************************************
+* Summary:
+*   Select the sample rate of the next recordings, keeping the rest of their 
+*   format. Refused while recording, if the rate is not supported or if the
+*   format at that rate is over the flash budget. The records play at their 
+*   own rate.
+*
+* Parameters:
+*   rate: Frames per second: 8000, 16000, 22050, 32000, 44100 or 48000.
+*
+* Return:
+*   bool: false if the rate was refused, see SetRecorderFormat.
+*
+*******************************************************************************/
+bool SetRecorderRate(uint32_t rate)
+{
+    uint32_t index;
+    
+    for (index = 0; index < (sizeof(audioRates)/sizeof(audioRates[0])); index++)
+    {
+        if (audioRates[index].sampleRate == rate)
+        {
+            return SetRecorderFormat((recordFormat.word & ~RECORD_FORMAT_RATE) | (index << RECORD_FORMAT_RATE_POS));
+        }
+    }
+    
+    return false;
+}
+
+/*******************************************************************************
+* Function Name: SetRecorderAgc
+********************************************************************************
+* Summary:
+*   Switch the automatic gain control of the next recordings. Ignored while 
+*   recording, a recording is levelled all through or not at all, and its 
+*   catalog flags tell which with CATALOG_FLAG_AGC. The loop history is 
+*   levelled from now on.
+*
+* Parameters:
+*   enable: true to level the captured pages.
+*
+*******************************************************************************/
+void SetRecorderAgc(bool enable)
+{
+    if (state != RECORDING)
+    {
+        captureAgc.enabled = enable;
+    }
+}
+
+/*******************************************************************************
+* Function Name: SetRecorderHighPass
+********************************************************************************
+* Summary:
+*   Switch the high-pass filter of the next recordings, which removes the DC 
+*   offset and the rumble of the microphones below HPF_CUTOFF_HZ. Ignored while
+*   recording, CATALOG_FLAG_HIGHPASS tells the recordings filtered.
+*
+* Parameters:
+*   enable: true to filter the captured pages.
+*
+*******************************************************************************/
+void SetRecorderHighPass(bool enable)
+{
+    if (state != RECORDING)
+    {
+        captureHpf.enabled = enable;
+    }
+}
+
+/*******************************************************************************
+* Function Name: SetRecorderDenoise
+********************************************************************************
+* Summary:
+*   Switch the noise suppression of the next recordings, mono 16-bit only. The
+*   background is learned over the first DENOISE_LEARN_MS of each capture, so 
+*   the recording should not start with speech, and it is a frame late. 
+*   Ignored while recording, CATALOG_FLAG_DENOISE tells the recordings 
+*   processed.
+*
+* Parameters:
+*   enable: true to suppress the noise of the captured pages.
+*
+*******************************************************************************/
+void SetRecorderDenoise(bool enable)
+{
+    if (state != RECORDING)
+    {
+        captureDenoise.enabled = enable;
+    }
+}
+
+/*******************************************************************************
+* Function Name: SetRecorderMonitor
+********************************************************************************
+* Summary:
+*   Switch the live monitoring of the recordings: the captured pages, once 
+*   processed, play on the headphones MONITOR_LATENCY_PAGES later. A record 
+*   played while recording is heard instead, the monitor resumes after it. 
+*   Takes effect at once.
+*
+* Parameters:
+*   enable: true to monitor the recordings.
+*
+*******************************************************************************/
+void SetRecorderMonitor(bool enable)
+{
+    monitorEnabled = enable;
+    
+    if (!enable && monitorActive)
+    {
+        StopPlayer();
+    }
+    else if ((RECORD_DUPLEX != 0u) && enable && (state == RECORDING) && !playing)
+    {
+        StartMonitor();
+    }
+}
+
+/*******************************************************************************
+* Function Name: RecordFormatDecode
+********************************************************************************
+* Summary:
+*   Decode the format word of a recording. A page holds whole frames, so a 
+*   stereo or 24-bit page holds fewer of them. ADPCM is mono 16-bit only, and
+*   never compact.
+*
+* Parameters:
+*   word: Format word, as stored in the catalog.
+*   format: Receives the decoded format.
+*
+* Return:
+*   bool: false if the format is not supported, format is then unchanged.
+*
+*******************************************************************************/
+bool RecordFormatDecode(uint32_t word, record_format_t *format)
+{
+    uint32_t codec = word & RECORD_FORMAT_CODEC;
+    uint32_t rate = (word & RECORD_FORMAT_RATE) >> RECORD_FORMAT_RATE_POS;
+    
+    if (((word & ~(RECORD_FORMAT_CODEC | RECORD_FORMAT_STEREO | RECORD_FORMAT_24BIT | RECORD_FORMAT_RATE | 
+                   RECORD_FORMAT_COMPACT)) != 0u) ||
+        (rate >= (sizeof(audioRates)/sizeof(audioRates[0]))) ||
+        ((codec != RECORD_FORMAT_PCM16) && (codec != RECORD_FORMAT_ADPCM)) ||
+        ((codec == RECORD_FORMAT_ADPCM) && 
+         ((word & (RECORD_FORMAT_STEREO | RECORD_FORMAT_24BIT | RECORD_FORMAT_COMPACT)) != 0u)))
+    {
+        return false;
+    }
+    
+    format->word = word;
+    format->codec = codec;
+    format->channels = ((word & RECORD_FORMAT_STEREO) != 0u) ? 2u : 1u;
+    format->sampleBits = ((word & RECORD_FORMAT_24BIT) != 0u) ? 24u : 16u;
+    format->sampleRate = audioRates[rate].sampleRate;
+    format->clock = &audioRates[rate];
+    format->sampleSize = ((word & RECORD_FORMAT_24BIT) != 0u) ? sizeof(int32_t) : sizeof(int16_t);
+    format->pageFrames = PAGE_PAYLOAD_SIZE/(format->sampleSize*format->channels);
+    format->compact = ((word & RECORD_FORMAT_COMPACT) != 0u);
+    
+    return true;
+}
+
+/*******************************************************************************
+* Function Name: RecorderBacklogPeak
+********************************************************************************
+* Summary:
+*   Return the largest number of pages captured and not yet programmed during 
+*   the last recording. Up to the pages of the TX pool, the PDM DMA then 
+*   overwrites pages not stored yet, see RecorderOverruns.
+*
+* Return:
+*   uint32_t: peak backlog in pages.
+*
+*******************************************************************************/
+uint32_t RecorderBacklogPeak(void)
+{
+    return pageBacklogPeak;
+}
+
+/*******************************************************************************
+* Function Name: RecorderUnderruns
+********************************************************************************
+* Summary:
+*   Return the number of pages the play DMA reached before they were read from 
+*   the memory during the last play. Each one replays stale data. Always zero 
+*   when playing from the memory-mapped flash.
+*
+* Return:
+*   uint32_t: number of underruns.
+*
+*******************************************************************************/
+uint32_t RecorderUnderruns(void)
+{
+    return playUnderrunCount;
+}
+
+/*******************************************************************************
+* Function Name: RecorderOverruns
+********************************************************************************
+* Summary:
+*   Return the number of pages the PDM DMA overwrote in the TX buffer before 
+*   they were stored, since the capture started. The recording skips them and
+*   is flagged with CATALOG_FLAG_OVERRUN.
+*
+* Return:
+*   uint32_t: number of overruns.
+*
+*******************************************************************************/
+uint32_t RecorderOverruns(void)
+{
+    return PageRingOverruns(&pdmRing);
+}
+
+/*******************************************************************************
+* Function Name: RecorderSilentPages
+********************************************************************************
+* Summary:
+*   Return the pages of the last compact recording found silent, and not 
+*   stored. Each saves a page program, and a sector erase every 
+*   NUM_PAGES_IN_SECTOR of them.
+*
+* Return:
+*   uint32_t: number of silent pages.
+*
+*******************************************************************************/
+uint32_t RecorderSilentPages(void)
+{
+    return silentPages;
+}
+
+/*******************************************************************************
+* Function Name: RecorderCaptureChain
+********************************************************************************
+* Summary:
+*   Return the chain of stages run on each captured page, before it is encoded
+*   or stored. Its deadline follows the page time of the recording format. 
+*   The stages and the chain count their cycles.
+*
+* Return:
+*   dsp_chain_t *: chain to add stages to, or to read the cycles of.
+*
+*******************************************************************************/
+dsp_chain_t * RecorderCaptureChain(void)
+{
+    return &captureChain;
+}
+
+/*******************************************************************************
+* Function Name: RecorderPlayChain
+********************************************************************************
+* Summary:
+*   Return the chain of stages run on each page to play, once read or decoded
+*   in the read-ahead ring and before the play DMA reads it. Records do not 
+*   play from the memory-mapped flash while the chain has stages.
+*
+* Return:
+*   dsp_chain_t *: chain to add stages to, or to read the cycles of.
+*
+*******************************************************************************/
+dsp_chain_t * RecorderPlayChain(void)
+{
+    return &playChain;
+}
+
+/*******************************************************************************
+* Function Name: RecorderCaptureLoad
+********************************************************************************
+* Summary:
+*   Return the peak load of the capture chain since the capture started, in 
+*   percent of the time of a page at the recording rate. What is left of the 
+*   CPU goes to the storage path and the display. It is shown with the rate.
+*
+* Return:
+*   uint32_t: Load, in percent.
+*
+*******************************************************************************/
+uint32_t RecorderCaptureLoad(void)
+{
+    if (captureChain.deadlineCycles == 0u)
+    {
+        return 0;
+    }
+    
+    return (uint32_t) (((uint64_t) captureChain.peakCycles * DSP_CPU_PERCENT) / captureChain.deadlineCycles);
+}
+
+/*******************************************************************************
+* Function Name: RecorderPoolStats
+********************************************************************************
+* Summary:
+*   Return the occupancy of the TX pool: the pages chained for the capture, the
+*   pages captured and not yet programmed, or encoded, and the peak since the 
+*   capture started. The pages captured over a full pool overwrite the oldest
+*   ones, they are counted by RecorderOverruns, not here.
+*
+* Return:
+*   const tx_pool_stats_t *: occupancy, valid until the next call.
+*
+*******************************************************************************/
+const tx_pool_stats_t * RecorderPoolStats(void)
+{
+    uint32_t used = pdmRing.head - pdmRing.tail;
+    
+    txPoolStats.used = (used > txPoolStats.depth) ? txPoolStats.depth : used;
+    
+    return &txPoolStats;
+}
+
+/*******************************************************************************
+* Function Name: PauseRecorder
+********************************************************************************
+* Summary:
+*   Pause the recording. It only disable the DMA connected to the I2S.
+*
+*******************************************************************************/
+void PauseRecorder(void)
+{
+    state = PAUSED;
+    
+    Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
+}
+
+/*******************************************************************************
+* Function Name: ResumeRecorder
+********************************************************************************
+* Summary:
+*   Resume the recording. It only enable the DMA connected to the I2S.
+*
+*******************************************************************************/
+void ResumeRecorder(void)
+{
+    state = PLAYING;
+    
+    EnablePlayDma();
 }
    
 /*******************************************************************************
 * Function Name: ResetRecorder
 ********************************************************************************
 * Summary:
-*   Stops sending data over I2S and disable DMAs.
+*   Stops sending data over I2S and disable the DMA.
 *
 *******************************************************************************/
 void ResetRecorder(void)
 {
     state = IDLE;
     
-    Cy_DMA_Channel_Disable(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
-    Cy_DMA_Channel_Disable(DMA_PlayLeft_HW, DMA_PlayLeft_DW_CHANNEL);
+    StopPlayer();
     
-    I2S_Stop();
-
+#if (RECORD_PRETRIGGER_SECONDS != 0u)
+    StartLoopRecorder();
+#endif
 }
 
 /*******************************************************************************
@@ -567,16 +2857,38 @@ void ResetRecorder(void)
 ********************************************************************************
 * Summary:
 *   This interrupt is triggered when the PDM DMA transfer cycle is completed.
+*   The pages completed are counted from the descriptor the DMA moved to, so 
+*   interrupts that coalesce lose none. The descriptor repeats every lap of the
+*   pool: the time since the last interrupt gives the laps made meanwhile, their
+*   pages were overwritten and PageRingProduce counts them as overruns. The 
+*   recorder is only woken up when it had taken all the pages: while it drains
+*   the ring, it sees the new ones.
 *
 *******************************************************************************/
 void PDM_Interrupt_User(void)
 {
-    BaseType_t higherPriorityTaskWoken, result;
-    
-    result = xEventGroupSetBitsFromISR(DmaEvents, DMA_PDM_FLAG_BIT, &higherPriorityTaskWoken);
+    BaseType_t higherPriorityTaskWoken = pdFALSE, result = pdFAIL;
+    uint32_t slot = (uint32_t) (Cy_DMA_Channel_GetCurrentDescriptor(DMA_Record_HW, DMA_Record_DW_CHANNEL) - txPoolDescr);
+    uint32_t pages = (slot + TX_POOL_PAGES - pdmLastSlot) % TX_POOL_PAGES;
+    uint32_t now = DWT->CYCCNT;
+    uint32_t elapsed = (now - pdmLastCycles) / pdmPageCycles;
     
     Cy_DMA_Channel_ClearInterrupt(DMA_Record_HW, DMA_Record_DW_CHANNEL);
     
+    /* Whole laps: the pages timed are the ones counted, give or take half a pool */
+    if (elapsed > pages)
+    {
+        pages += ((elapsed - pages + (TX_POOL_PAGES/2u)) / TX_POOL_PAGES) * TX_POOL_PAGES;
+    }
+    
+    pdmLastSlot = slot;
+    pdmLastCycles = now;
+    
+    if ((pages != 0u) && PageRingProduce(&pdmRing, pages))
+    {
+        result = xEventGroupSetBitsFromISR(DmaEvents, DMA_PDM_FLAG_BIT, &higherPriorityTaskWoken);
+    }
+    
     if (result != pdFAIL)
     {
         portYIELD_FROM_ISR(higherPriorityTaskWoken);
@@ -587,12 +2899,50 @@ void PDM_Interrupt_User(void)
 * Function Name: I2S_Interrupt_User
 ********************************************************************************
 * Summary:
-*   This interrupt is triggered when the I2S DMA transfer cycle is completed.
+*   This interrupt is triggered when the I2S DMA has played a page. The pages
+*   are counted here, so the task can catch up on several of them at once. As
+*   for the capture, they are counted from the descriptor the DMA moved to, 
+*   the page p playing from descriptor (p % depth) of the ring in use, and the
+*   time since the last interrupt gives the laps of the ring. The last page of
+*   a record leaves no descriptor, all the pages are then played.
 *
 *******************************************************************************/
 void I2S_Interrupt_User(void)
 {
-    BaseType_t higherPriorityTaskWoken, result;
+    BaseType_t higherPriorityTaskWoken = pdFALSE, result;
+    const cy_stc_dma_descriptor_t *chain = ringDescr;
+    const cy_stc_dma_descriptor_t *current = Cy_DMA_Channel_GetCurrentDescriptor(DMA_PlayRight_HW, DMA_PlayRight_DW_CHANNEL);
+    uint32_t depth = PLAY_RING_DEPTH;
+    uint32_t played = playSeekPage + playPagesDone;
+    uint32_t now = DWT->CYCCNT;
+    uint32_t elapsed = (now - i2sLastCycles) / i2sPageCycles;
+    uint32_t pages;
+    
+#if (PLAY_FROM_XIP != 0u)
+    if (playXip)
+    {
+        chain = xipDescr;
+        depth = XIP_DESCR_COUNT;
+    }
+#endif
+    
+    if ((current < chain) || (current >= &chain[depth]))
+    {
+        pages = (playPageCount > played) ? (playPageCount - played) : 0u;
+    }
+    else
+    {
+        pages = ((uint32_t) (current - chain) + depth - (played % depth)) % depth;
+        
+        /* Whole laps: the pages timed are the ones counted, give or take half a ring */
+        if (elapsed > pages)
+        {
+            pages += ((elapsed - pages + (depth/2u)) / depth) * depth;
+        }
+    }
+    
+    playPagesDone += pages;
+    i2sLastCycles = now;
     
     result = xEventGroupSetBitsFromISR(DmaEvents, DMA_I2S_FLAG_BIT, &higherPriorityTaskWoken);
     
@@ -45,18 +45,12 @@
 #define RECORDER_H
 
 #include "project.h"
+#include "catalog.h"
+#include "dsp.h"
 
 /*******************************************************************************
 *            Structures and Enums
 *******************************************************************************/
-typedef struct sector_info
-{
-    uint32_t signature;               /* Signature to validate content on FLASH */
-    uint32_t currentSector;           /* Current sector to be written */
-    uint32_t numberOfPagesRecorded;   /* Number of pages recorded */
-    uint32_t reserved[125];           /* For future use */
-} sector_info_t;
-    
 /* Enumerated data type for different states of the recorder */
 typedef enum
 {
@@ -76,30 +70,212 @@ typedef enum
     REACH_MEM_LIMIT = 0x20000002u,
 }   record_events_t;
 
+/* Header at the start of each recorded page, the samples follow. Pages of the
+   recording in progress are found with it after a power loss */
+typedef struct page_header
+{
+    uint32_t sequence;                /* Recording tag in the upper half, page
+                                         number in the lower half */
+    uint16_t crc;                     /* CRC-16 of the sequence and the payload */
+    uint16_t position;                /* Captured page held, in a compact record,
+                                         zero otherwise */
+} page_header_t;
+
+/* Audio clock settings of a sample rate. The PDM/PCM clock is the audio clock
+   divided by 4, then by pdmCkoDiv + 1, and decimated by twice pdmSincRate. 
+   The codec MCKI is the audio clock divided by mclkDiv, a multiple of the 
+   rate given by the CM bits of codecMode */
+typedef struct audio_rate
+{
+    uint32_t sampleRate;              /* Frames per second */
+    uint32_t clockHz;                 /* Audio PLL frequency, to clk_hf[1] */
+    cy_en_clkhf_dividers_t mclkDiv;   /* Divider of clk_hf[4], the codec MCKI */
+    uint8_t  pdmCkoDiv;               /* PDM clock divider, less one */
+    uint8_t  pdmSincRate;             /* PDM decimation, half the oversampling */
+    uint8_t  codecMode;               /* Codec sampling rate and MCKI settings */
+} audio_rate_t;
+
+/* Format of a recording, decoded from the format word of its catalog entry.
+   It sets the PDM and I2S word, the DMA geometry and the page layout */
+typedef struct record_format
+{
+    uint32_t word;                    /* Format word, as stored in the catalog */
+    uint32_t codec;                   /* RECORD_FORMAT_PCM16 or RECORD_FORMAT_ADPCM */
+    uint32_t channels;                /* 1, or 2 interleaved */
+    uint32_t sampleBits;              /* 16, or 24 in 32-bit words */
+    uint32_t sampleRate;              /* Frames per second */
+    const audio_rate_t *clock;        /* Audio clock settings of the rate */
+    uint32_t sampleSize;              /* Bytes of a PCM sample in a page */
+    uint32_t pageFrames;              /* PCM frames, all channels, in a page */
+    bool compact;                     /* Silent pages are not stored */
+} record_format_t;
+
+/* Occupancy of the capture pool, see RecorderPoolStats */
+typedef struct tx_pool_stats
+{
+    uint32_t depth;                   /* Pages chained for the capture */
+    uint32_t used;                    /* Pages captured and not released yet, up to depth */
+    uint32_t peak;                    /* Most pages used since the capture started */
+    uint32_t needed;                  /* Pages the format needs, see TX_POOL_PAGES */
+} tx_pool_stats_t;
+
 /*******************************************************************************
 *            Function Prototypes
 *******************************************************************************/
 void InitRecorder(void);
-void StartRecorder(void);
+record_handle_t StartRecorder(void);
 void StopRecorder(void);
-void PlayRecorder(void);
+void PlayRecorder(record_handle_t handle);
 void PauseRecorder(void);
 void ResumeRecorder(void);
 void ResetRecorder(void);
+void SeekRecorder(uint32_t ms);
+uint32_t RecorderPosition(void);
+uint32_t RecorderLength(void);
 void RecorderTask(void *arg);
+void SubmitRecordedPages(void);
 recorder_states_t RecorderState(void);
+bool SetRecorderFormat(uint32_t format);
+bool SetRecorderRate(uint32_t rate);
+void SetRecorderAgc(bool enable);
+void SetRecorderHighPass(bool enable);
+void SetRecorderDenoise(bool enable);
+void SetRecorderMonitor(bool enable);
+bool RecordFormatDecode(uint32_t word, record_format_t *format);
+uint32_t RecorderBacklogPeak(void);
+uint32_t RecorderUnderruns(void);
+uint32_t RecorderOverruns(void);
+uint32_t RecorderSilentPages(void);
+const tx_pool_stats_t * RecorderPoolStats(void);
+uint32_t RecorderCaptureLoad(void);
+dsp_chain_t * RecorderCaptureChain(void);
+dsp_chain_t * RecorderPlayChain(void);
 
 /*******************************************************************************
 *            Constants
 *******************************************************************************/
-#define SIGNATURE           (0xDEADBEEFu)   /* Signature for Sector Info */
 #define MAX_RECORD_SIZE     (32u)           /* Maximum number of sectors per record */
-#define FIRST_RECORD_SECTOR (1u)            /* First sector for recording */
-#define INFO_SECTOR         (0u)            /* Sector reserved for info */
-#define TX_PAGE_MAX_COUNT   (32u)           /* Maximum number of pages on TX buffer */
+#define MAX_RECORD_SECTORS  ((MAX_RECORD_SIZE*NUM_PAGES_IN_SECTOR*PACKET_SIZE + SECTOR_SIZE - 1u)/SECTOR_SIZE)
+                                            /* Memory sectors kept free for a record */
+#define FIRST_RECORD_SECTOR (2u)            /* First sector for recording */
+#define INFO_SECTOR         (0u)            /* First sector reserved for info */
+#define INFO_SECTOR_COUNT   (2u)            /* Info sectors, the catalog rotates on them */
+#define RECORD_SAMPLE_RATE  (8000u)         /* Samples per second of the rate index 0 */
 #define DMA_I2S_FLAG_BIT    (0x01u)         /* Bit flag for DMA I2S events */
 #define DMA_PDM_FLAG_BIT    (0x02u)         /* Bit flag for DMA PDM events */
 #define RECORD_FLAG_BIT     (0x04u)         /* Bit flag for record */
+#define PLAY_FLAG_BIT       (0x08u)         /* Bit flag for pages read to play */
+
+/* Layout of a recorded page */
+#define PAGE_HEADER_SIZE    (8u)            /* Size of page_header_t */
+#define PAGE_PAYLOAD_SIZE   (PACKET_SIZE - PAGE_HEADER_SIZE)
+#define PAGE_SAMPLES        (PAGE_PAYLOAD_SIZE/sizeof(int16_t))
+                                            /* 16-bit samples in a PCM page */
+
+/* Power-loss recovery. The progress is saved in the catalog on the first page
+   and then every RECORD_PROGRESS_PAGES, the pages after it are found by 
+   scanning their headers when mounting */
+#define RECORD_PROGRESS_PAGES (128u)        /* Pages between two saved progress */
+#define RECOVERY_TIME       pdMS_TO_TICKS(250u) /* Longest recovery scan */
+
+/* Capture pool. The PDM DMA fills pages linked by a chain of descriptors, a 
+   page goes back to the DMA once programmed, or encoded. The whole pool is 
+   always chained. A format needs the pages captured during the longest stall
+   from the capture of a page to the end of its program, plus the spare ones:
+   the stall is an erase running MEM_RESUME_DELAY plus one tick before it is
+   suspended, then the programs queued ahead, see DUPLEX_PROGRAM_PAGES, with 
+   a catalog entry and the page itself. TX_POOL_PAGES is checked at build 
+   time against the fastest format with the typical timing. SetRecorderFormat
+   checks it again with the longest program MemoryLatency measured, and 
+   refuses the formats it does not fit. The DMA fills one page, so 16 pages
+   ride over 15 pages of stall: 473 ms at 8 kHz mono, 79 ms at 48 kHz mono, 
+   21 ms at 44.1 kHz 24-bit stereo. The sector erases are kept off the 
+   recording path by the erase-ahead bank. The peak occupancy is shown on 
+   the display, see RecorderPoolStats */
+#define TX_POOL_PAGES       (16u)           /* Pages in the pool, a power of two */
+#define TX_POOL_SPARE_PAGES (2u)            /* Pages filled and programmed */
+#define TX_POOL_PROGRAMS    (DUPLEX_PROGRAM_PAGES + 2u) /* Programs a page waits for */
+#define TX_POOL_HOLD_US     ((MEM_RESUME_DELAY + 1u)*(1000000u/configTICK_RATE_HZ)) /* Erase before a suspend */
+#define RECORD_DRAIN_TIMEOUT pdMS_TO_TICKS(3000u) /* Max wait without progress to queue the 
+                                               last pages at stop, a sector erase at tSE max, 2.6 s */
+#define RECORD_DRAIN_WAIT   pdMS_TO_TICKS(1u) /* Wait for a program at stop, the recorder task 
+                                               may take its wakeup */
+
+/* Playback straight from the memory-mapped flash, no RX buffer in SRAM */
+#define PLAY_FROM_XIP       (1u)            /* Set to 0 to play through rxBuffer */
+#define XIP_DESCR_COUNT     (8u)            /* Pages chained ahead of the play DMA */
+
+/* Playback through SRAM, pages are read ahead in a ring. A deeper ring costs
+   PACKET_SIZE bytes per page and absorbs longer programs or erases */
+#define PLAY_RING_DEPTH     (4u)            /* Pages in the read-ahead ring, 2 to 256 */
+
+/* Recording format. ADPCM stores about four times longer records in the same
+   sectors, its records always play through the read-ahead ring. It is mono
+   16-bit only. PCM can add RECORD_FORMAT_STEREO, a microphone pair at twice 
+   the bandwidth, and RECORD_FORMAT_24BIT, twice again. RECORD_FORMAT_COMPACT
+   drops the pages the voice activity detector finds silent, the header of 
+   each stored page gives its position and the silence is played as zeros */
+#define RECORD_DEF_FORMAT   RECORD_FORMAT_PCM16 /* Format after reset */
+#define ADPCM_TX_PAGES      (8u)            /* Encoded pages waiting to be programmed */
+#define ADPCM_RX_PAGES      (3u)            /* Encoded or compact pages read ahead, 2 or more */
+#define COMPACT_MAX_PAGES   (0xFFFFu)       /* Pages captured in a compact record, 
+                                               the header position is 16-bit */
+
+/* Flash time a second of recording may take: its pages programmed, each after
+   an erase suspend, and the sectors they fill erased, from MEM_PROGRAM_US, 
+   MEM_SUSPEND_US and MEM_ERASE_US. SetRecorderFormat refuses the formats over
+   it, which the erase-ahead bank would only delay: with the typical S25FL512S 
+   timing, PCM stereo 24-bit is limited to 44.1 kHz (98% of the second), its 
+   762 pages per second at 48 kHz need 1.07 s */
+#define RECORD_FLASH_BUDGET_US (1000000u)
+
+/* Processing of the pages, see RecorderCaptureChain and RecorderPlayChain. 
+   Each chain may take a share of the page time, the rest is left to the 
+   storage path and the display */
+#define DSP_CPU_PERCENT     (50u)           /* Share of a page time for a chain */
+#define RECORD_DEF_AGC      (0u)            /* Gain control after reset, see SetRecorderAgc */
+#define RECORD_DEF_HIGHPASS (1u)            /* High-pass after reset, see SetRecorderHighPass */
+#define RECORD_DEF_DENOISE  (0u)            /* Noise suppression after reset, see SetRecorderDenoise */
+
+/* Full duplex. The PDM/PCM and the I2S share the audio clock, so a record of 
+   the same audio clock plays on while capturing, and the capture can be 
+   monitored on the headphones. The programs of the capture are kept few in 
+   the storage queue, a read of the play ring waits for DUPLEX_PROGRAM_PAGES 
+   programs at most, and a program for the reads of the ring. No sector erase
+   is queued ahead of the reads while the bank erases it: the erase ahead is 
+   suspended for each read, which then waits up to MEM_RESUME_DELAY plus one 
+   tick. The capture waits for the sector meanwhile, a full erase is 0.52 s 
+   typical and 2.6 s at most on the S25FL512S, more with the suspends, 
+   longer than the TX pool at most rates: the record then gets 
+   CATALOG_FLAG_OVERRUN. An erase of a sector the bank does not reach, after
+   a restart of the bank, is still queued and holds the reads for its length */
+#define RECORD_DUPLEX       (1u)            /* Set to 0 to stop the playback when capturing */
+#define DUPLEX_PROGRAM_PAGES (2u)           /* Programs queued while playing through the ring */
+#define RECORD_DEF_MONITOR  (0u)            /* Live monitoring after reset, see SetRecorderMonitor */
+#define MONITOR_LATENCY_PAGES (2u)          /* Pages captured before the monitor plays, 
+                                               less than PLAY_RING_DEPTH */
+
+/* Sample rates, 8, 16, 22.05, 32, 44.1 or 48 kHz, see SetRecorderRate. The 
+   PDM/PCM and the I2S run from the audio clock, set by the PLL: 16.384 MHz 
+   for 8 kHz as generated, 1024 times 48 kHz or 44.1 kHz for the others. The
+   codec MCKI, clk_hf[4], divides it down to 256 or 384 times the rate */
+#define AUDIO_CLOCK_PATH    (1u)            /* Clock path of the audio PLL, PLL0 */
+#define AUDIO_PLL_INPUT_HZ  (17203200u)     /* PLL reference if the path gives none, the ECO */
+#define AUDIO_MCLK_HF       (4u)            /* clk_hf[4], AudioClk to the codec MCKI */
+#define AUDIO_PLL_TIMEOUT   (10000u)        /* PLL lock timeout, in microseconds */
+#define I2S_FRAME_CLOCKS    (512u)          /* Audio clocks per I2S frame, 8 per bit of 2x32 */
+
+/* Flash benchmark at start-up, to qualify a memory part. The recordings on the
+   benchmarked sectors are deleted, the results are shown in MB/s */
+#define RECORD_BENCHMARK_SECTORS (0u)       /* Sectors to benchmark, 0 to disable */
+
+/* Loop recording. While idle, the microphone is captured in a window of sectors
+   sliding through the free memory, the oldest sector is dropped once it is all
+   older than the pre-trigger time. The record button keeps that history: a
+   record starts on a sector, so at least RECORD_PRETRIGGER_SECONDS are kept,
+   and less than one more sector (16 s of PCM, about 64 s of ADPCM) */
+#define RECORD_PRETRIGGER_SECONDS (0u)      /* Seconds kept before the button, 0 to disable */
+#define LOOP_SECTOR_PAGES   (SECTOR_SIZE/PACKET_SIZE) /* Pages dropped with a sector */
 
 #endif
 /* [] END OF FILE */
@@ -51,13 +51,12 @@
     
     /* Size of the queues */
     #define QUEUE_SIZE      8u
+    #define STORAGE_QUEUE_SIZE  48u
         
     /* Queues */
     extern QueueHandle_t EventsQueue;
     extern QueueHandle_t GUIQueue;
-    
-    /* Semaphores */
-    extern SemaphoreHandle_t SmifSemphr;
+    extern QueueHandle_t StorageQueue;
     
     /* Event Group bits */
     extern EventGroupHandle_t DmaEvents;
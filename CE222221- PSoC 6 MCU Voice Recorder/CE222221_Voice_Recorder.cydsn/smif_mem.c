@@ -42,11 +42,56 @@
 
 #include "smif_mem.h"
 #include "stdio.h"
+#include <string.h>
 #include "project.h"
 #include "rtos.h"
 
 /* SMIF interrupt function */
 void SMIF_Interrupt_User(void);
+#if (SMIF_DMA_DATA != 0u)
+void SMIF_DMA_Interrupt_User(void);
+static void InitDataDma(void);
+static bool StartDataDma(bool transmit, uint8_t buffer[], uint32_t size);
+#endif
+
+/* Callback used by SyncMemory to wake up the calling task */
+static void WakeMemoryCallback(mem_op_t op, uint32_t address, void *arg);
+
+/* Storage task internals */
+static void ExecuteMemory(mem_request_t *request);
+static void ProgramBurstMemory(void);
+static void QuadEnableMemory(void);
+static void ProgramMemory(uint8_t txBuffer[], uint32_t txSize, uint32_t address);
+static void EraseAheadStep(void);
+static bool SuspendEraseMemory(void);
+static void ResumeEraseMemory(void);
+static bool TakeErasedSector(uint32_t sector);
+static void PollDelayMemory(void);
+static void RecordLatency(mem_lat_op_t op, uint32_t start, uint32_t polls);
+static void QueueBenchMemory(mem_op_t op, uint8_t buffer[], uint32_t address);
+static TickType_t BenchPass(mem_op_t op, uint8_t buffer[], uint32_t address, 
+                    uint32_t pages, bool dma, mem_bench_xfer_t *cost);
+static uint32_t BenchRate(uint32_t bytes, TickType_t ticks);
+
+/*******************************************************************************
+*            Internal Global Variables
+*******************************************************************************/
+TaskHandle_t storageTaskHandle = NULL;      /* Task that owns the SMIF */
+bool memMapped = false;                     /* SMIF in memory-mapped (XIP) mode */
+mem_next_sector_t eraseNextSector = NULL;   /* Order in which sectors are banked */
+uint32_t eraseNext = MEM_NO_SECTOR;         /* Next sector to erase ahead */
+uint32_t erasePool[ERASE_AHEAD_SECTORS];    /* Sectors erased and not yet used */
+uint32_t erasePoolCount = 0;                /* Number of sectors in the pool */
+uint32_t memBurstPeak = 0;                  /* Most pages programmed in one burst */
+uint32_t memEraseCount[NUM_SECTORS_IN_MEM]; /* Erases of each sector */
+mem_xfer_stats_t memXferStats;              /* CPU cost of the data phases */
+mem_latency_t memLatency[MEM_LAT_OPS];      /* Latency of each operation */
+uint32_t memPollCount = 0;                  /* Tick sleeps while polling the memory */
+#if (SMIF_DMA_DATA != 0u)
+bool memDataDma = true;                     /* Data phases moved by the DW channels */
+cy_stc_dma_descriptor_t smifTxDescriptor;   /* Data phase of a program */
+cy_stc_dma_descriptor_t smifRxDescriptor;   /* Data phase of a read */
+#endif
 
 /*******************************************************************************
 * Function Name: InitMemory
@@ -76,8 +121,24 @@ void InitMemory(void)
     Cy_SMIF_SetDataSelect(SMIF_1_HW, CY_SMIF_SLAVE_SELECT_0, CY_SMIF_DATA_SEL0);
     Cy_SMIF_Enable(SMIF_1_HW, &SMIF_1_context);  
     
+    /* Configure the memory-mapped window, the SMIF stays in command mode */
+    smif_status = Cy_SMIF_Memslot_Init(SMIF_1_HW, (cy_stc_smif_block_config_t *) &smifBlockConfig, &SMIF_1_context);
+    if(smif_status!=CY_SMIF_SUCCESS)
+    {
+        HandleErrorMemory();
+    }
+    Cy_SMIF_SetMode(SMIF_1_HW, CY_SMIF_NORMAL);
+    
     /* Enable the SMIF interrupt */
     NVIC_EnableIRQ(smif_interrupt_IRQn);
+    
+#if (SMIF_DMA_DATA != 0u)
+    InitDataDma();
+#endif
+    
+    /* Start the cycle counter used by MemoryXferStats */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
 }
 
 /*******************************************************************************
@@ -91,12 +152,45 @@ void InitMemory(void)
 *
 *******************************************************************************/
 void EraseMemory(uint32_t sector)
+{
+    uint32_t start = DWT->CYCCNT;
+    uint32_t polls = memPollCount;
+    
+    StartEraseMemory(sector);
+    
+    while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
+    {
+        /* Wait till the memory controller command is completed */
+        PollDelayMemory();
+    }
+    
+    RecordLatency(MEM_LAT_ERASE, start, polls);
+}
+
+/*******************************************************************************
+* Function Name: StartEraseMemory
+********************************************************************************
+* Summary:
+*   This function sends the sector erase command and returns while the memory 
+*   is still busy erasing.
+*
+* Parameters:
+*   sector: The sector to be erased
+*
+*******************************************************************************/
+void StartEraseMemory(uint32_t sector)
 {
     cy_en_smif_status_t smif_status;
     uint8_t arrayAddress[ADDRESS_SIZE] = {0};
     
     arrayAddress[0] = sector * SECTOR_MULTIPLIER;
     
+    /* Count the wear, a suspended erase is still one */
+    if (sector < NUM_SECTORS_IN_MEM)
+    {
+        memEraseCount[sector]++;
+    }
+    
     smif_status = Cy_SMIF_Memslot_CmdWriteEnable(SMIF_1_HW, smifMemConfigs[0], &SMIF_1_context);
     if(smif_status!=CY_SMIF_SUCCESS)
     {
@@ -108,12 +202,6 @@ void EraseMemory(uint32_t sector)
     {
         HandleErrorMemory();
     }
-    
-    while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
-    {
-        /* Wait till the memory controller command is completed */
-        MEM_DELAY_FUNC;
-    }
 }
 
 /*******************************************************************************
@@ -133,13 +221,14 @@ void WriteMemory(uint8_t txBuffer[],
                     uint32_t txSize, 
                     uint32_t address)
 {
-    cy_en_smif_status_t smif_status;
-    uint8_t arrayAddress[ADDRESS_SIZE];
+    QuadEnableMemory();
+    ProgramMemory(txBuffer, txSize, address);
+}
 
-    /* Convert 32-bit address to 3-byte array */
-    arrayAddress[0] = CY_LO8(address >> 16);
-    arrayAddress[1] = CY_LO8(address >> 8);
-    arrayAddress[2] = CY_LO8(address);
+/* Set QE and wait for the memory, once per burst of programs */
+static void QuadEnableMemory(void)
+{
+    cy_en_smif_status_t smif_status;
     
     /* Set QE */    
     smif_status = Cy_SMIF_Memslot_QuadEnable(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context);
@@ -151,8 +240,26 @@ void WriteMemory(uint8_t txBuffer[],
     while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
     {
         /* Wait till the memory controller command is completed */
-        MEM_DELAY_FUNC;
+        PollDelayMemory();
     }
+}
+
+/* Program one page, QE must be set already. The write enable latch is cleared
+   by the memory after each program, so it is sent every time */
+static void ProgramMemory(uint8_t txBuffer[], 
+                    uint32_t txSize, 
+                    uint32_t address)
+{
+    cy_en_smif_status_t smif_status;
+    uint8_t arrayAddress[ADDRESS_SIZE];
+    uint32_t begin = DWT->CYCCNT;
+    uint32_t polls = memPollCount;
+    uint32_t start;
+
+    /* Convert 32-bit address to 3-byte array */
+    arrayAddress[0] = CY_LO8(address >> 16);
+    arrayAddress[1] = CY_LO8(address >> 8);
+    arrayAddress[2] = CY_LO8(address);
 	
     /* Send Write Enable to external memory */	
     smif_status = Cy_SMIF_Memslot_CmdWriteEnable(SMIF_1_HW, smifMemConfigs[0], &SMIF_1_context);
@@ -162,17 +269,35 @@ void WriteMemory(uint8_t txBuffer[],
     }
 	
 	/* Quad Page Program command */       
-    smif_status = Cy_SMIF_Memslot_CmdProgram(SMIF_1_HW, smifMemConfigs[0], arrayAddress, txBuffer, txSize, &RxCmpltMemoryCallback, &SMIF_1_context);
+    start = DWT->CYCCNT;
+#if (SMIF_DMA_DATA != 0u)
+    if (memDataDma && StartDataDma(true, txBuffer, txSize))
+    {
+        /* No buffer: the SMIF leaves the TX FIFO to the DMA */
+        smif_status = Cy_SMIF_Memslot_CmdProgram(SMIF_1_HW, smifMemConfigs[0], arrayAddress, NULL, txSize, NULL, &SMIF_1_context);
+    }
+    else
+#endif
+    {
+        smif_status = Cy_SMIF_Memslot_CmdProgram(SMIF_1_HW, smifMemConfigs[0], arrayAddress, txBuffer, txSize, &RxCmpltMemoryCallback, &SMIF_1_context);
+    }
     if(smif_status!=CY_SMIF_SUCCESS)
     {
         HandleErrorMemory();
     }	
+    memXferStats.issueCycles += DWT->CYCCNT - start;
+    memXferStats.pages++;
+    
+    /* Sleep until the data is pushed out, then poll the memory WIP bit */
+    ulTaskNotifyTake(pdTRUE, MEM_XFER_TIMEOUT);
         
     while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
     {
         /* Wait till the memory controller command is completed */
-        MEM_DELAY_FUNC;
+        PollDelayMemory();
     }
+    
+    RecordLatency(MEM_LAT_PROGRAM, begin, polls);
 }
 
 /*******************************************************************************
@@ -194,6 +319,9 @@ void ReadMemory(uint8_t rxBuffer[],
 {   
     cy_en_smif_status_t smif_status;
     uint8_t arrayAddress[ADDRESS_SIZE];
+    uint32_t begin = DWT->CYCCNT;
+    uint32_t polls = memPollCount;
+    uint32_t start;
 
     /* Convert 32-bit address to 3-byte array */
     arrayAddress[0] = CY_LO8(address >> 16);
@@ -210,23 +338,799 @@ void ReadMemory(uint8_t rxBuffer[],
     while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
     {
         /* Wait till the memory controller command is completed */
-        MEM_DELAY_FUNC;
+        PollDelayMemory();
     }
 	
 	/* The 4 Page program command */    
-    smif_status = Cy_SMIF_Memslot_CmdRead(SMIF_1_HW, smifMemConfigs[0], arrayAddress, rxBuffer, rxSize, &RxCmpltMemoryCallback, &SMIF_1_context);
+    start = DWT->CYCCNT;
+#if (SMIF_DMA_DATA != 0u)
+    if (memDataDma && StartDataDma(false, rxBuffer, rxSize))
+    {
+        /* No buffer: the SMIF leaves the RX FIFO to the DMA */
+        smif_status = Cy_SMIF_Memslot_CmdRead(SMIF_1_HW, smifMemConfigs[0], arrayAddress, NULL, rxSize, NULL, &SMIF_1_context);
+    }
+    else
+#endif
+    {
+        smif_status = Cy_SMIF_Memslot_CmdRead(SMIF_1_HW, smifMemConfigs[0], arrayAddress, rxBuffer, rxSize, &RxCmpltMemoryCallback, &SMIF_1_context);
+    }
     if(smif_status!=CY_SMIF_SUCCESS)
     {
         HandleErrorMemory();
     }
+    memXferStats.issueCycles += DWT->CYCCNT - start;
+    memXferStats.pages++;
+    
+    /* Sleep until the RX complete callback, instead of polling the SMIF */
+    ulTaskNotifyTake(pdTRUE, MEM_XFER_TIMEOUT);
     
     while(Cy_SMIF_BusyCheck(SMIF_1_HW))
     {
         /* Wait until the SMIF IP operation is completed. */
-        MEM_DELAY_FUNC;
+        PollDelayMemory();
+    }
+    
+    RecordLatency(MEM_LAT_READ, begin, polls);
+}
+
+/*******************************************************************************
+* Function Name: MapMemory
+********************************************************************************
+* Summary:
+*   This function switches the SMIF to the memory-mapped (XIP) mode, so the 
+*   external memory can be read by the CPU or a DMA through the mapped window.
+*   The SMIF caches are invalidated, as pages may have been programmed since
+*   the last time the window was used.
+*
+*******************************************************************************/
+void MapMemory(void)
+{
+    cy_en_smif_status_t smif_status;
+    
+    if (!memMapped)
+    {
+        /* The XIP read command is a quad command, make sure QE is set */
+        smif_status = Cy_SMIF_Memslot_QuadEnable(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context);
+        if(smif_status!=CY_SMIF_SUCCESS)
+        {
+            HandleErrorMemory();
+        }
+        
+        while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
+        {
+            /* Wait till the memory controller command is completed */
+            PollDelayMemory();
+        }
+        
+        Cy_SMIF_CacheInvalidate(SMIF_1_HW, CY_SMIF_CACHE_BOTH);
+        Cy_SMIF_SetMode(SMIF_1_HW, CY_SMIF_MEMORY);
+        
+        memMapped = true;
     }
 }
 
+/*******************************************************************************
+* Function Name: UnmapMemory
+********************************************************************************
+* Summary:
+*   This function switches the SMIF back to the command mode, required before
+*   any program or erase command. Any DMA reading the mapped window must be 
+*   stopped before.
+*
+*******************************************************************************/
+void UnmapMemory(void)
+{
+    if (memMapped)
+    {
+        while(Cy_SMIF_BusyCheck(SMIF_1_HW))
+        {
+            /* Wait until the last XIP access is completed */
+            PollDelayMemory();
+        }
+        
+        Cy_SMIF_SetMode(SMIF_1_HW, CY_SMIF_NORMAL);
+        
+        memMapped = false;
+    }
+}
+
+/*******************************************************************************
+* Function Name: IsMemoryMapped
+********************************************************************************
+* Summary:
+*   Return whether the SMIF is in memory-mapped (XIP) mode.
+*
+*******************************************************************************/
+bool IsMemoryMapped(void)
+{
+    return memMapped;
+}
+
+/*******************************************************************************
+* Function Name: MappedAddress
+********************************************************************************
+* Summary:
+*   Return the address of a memory location in the memory-mapped window.
+*
+* Parameters:
+*   address: Offset in the external memory.
+*
+*******************************************************************************/
+uint8_t * MappedAddress(uint32_t address)
+{
+    return (uint8_t *) (smifMemConfigs[0]->baseAddress + address);
+}
+
+/*******************************************************************************
+* Function Name: StorageTask
+********************************************************************************
+* Summary:
+*   This task owns the SMIF. It executes the read/program/erase requests in the
+*   order they were submitted and calls the completion callback of each request.
+*
+* Parameters:
+*   arg: Required argument for task function.
+*
+*******************************************************************************/
+void StorageTask(void *arg)
+{
+    mem_request_t request;
+    (void) arg;
+    
+    /* Register this task to be notified by the SMIF transfer callback */
+    storageTaskHandle = xTaskGetCurrentTaskHandle();
+    
+    while (1)
+    {
+        /* Only block on the queue when there is nothing to erase ahead */
+        if (xQueueReceive(StorageQueue, &request, 
+                          ((eraseNext != MEM_NO_SECTOR) && !memMapped) ? 0 : portMAX_DELAY))
+        {
+            ExecuteMemory(&request);
+        }
+        else
+        {
+            /* The bus is idle, bank one more erased sector */
+            EraseAheadStep();
+        }
+    }
+}
+
+/* Execute a request and call its completion callback */
+static void ExecuteMemory(mem_request_t *request)
+{
+    switch (request->op)
+    {
+        case MEM_OP_READ:
+            if (memMapped)
+            {
+                /* Already in XIP mode, read through the mapped window */
+                memcpy(request->buffer, MappedAddress(request->address), request->size);
+            }
+            else
+            {
+                ReadMemory(request->buffer, request->size, request->address);
+            }
+            break;
+        case MEM_OP_PROGRAM:
+            UnmapMemory();
+            WriteMemory(request->buffer, request->size, request->address);
+            break;
+        case MEM_OP_ERASE:
+            /* Nothing to do if the sector was erased ahead */
+            if (!TakeErasedSector(request->address))
+            {
+                UnmapMemory();
+                EraseMemory(request->address);
+
+                /* The writer fills it now, the bank must not erase it again */
+                if (eraseNext == request->address)
+                {
+                    eraseNext = (eraseNextSector != NULL) ? eraseNextSector(eraseNext) : MEM_NO_SECTOR;
+                }
+            }
+            break;
+        case MEM_OP_MAP:
+            MapMemory();
+            break;
+        case MEM_OP_UNMAP:
+            UnmapMemory();
+            break;
+        case MEM_OP_ERASE_AHEAD:
+            /* The writer moved, drop the bank and restart from the given sector */
+            taskENTER_CRITICAL();
+            erasePoolCount = 0;
+            taskEXIT_CRITICAL();
+            eraseNext = request->address;
+            break;
+        case MEM_OP_SYNC:
+        default:
+            break;
+    }
+    
+    /* Signal the completion to the requester */
+    if (request->callback != NULL)
+    {
+        request->callback(request->op, request->address, request->arg);
+    }
+    
+    /* Pages queued behind this one reuse its quad enable session */
+    if (request->op == MEM_OP_PROGRAM)
+    {
+        ProgramBurstMemory();
+    }
+}
+
+/*******************************************************************************
+* Function Name: ProgramBurstMemory
+********************************************************************************
+* Summary:
+*   This function programs the run of page programs waiting at the head of the 
+*   queue, right after a program. QE was set by that program and is not sent 
+*   again. Pages are not merged: the memory program buffer is one page, the 
+*   size the recorder already writes.
+*
+*******************************************************************************/
+static void ProgramBurstMemory(void)
+{
+    mem_request_t request;
+    uint32_t count = 1;
+    
+    while ((xQueuePeek(StorageQueue, &request, 0) == pdTRUE) && (request.op == MEM_OP_PROGRAM))
+    {
+        xQueueReceive(StorageQueue, &request, 0);
+        
+        ProgramMemory(request.buffer, request.size, request.address);
+        count++;
+        
+        if (request.callback != NULL)
+        {
+            request.callback(request.op, request.address, request.arg);
+        }
+    }
+    
+    if (count > memBurstPeak)
+    {
+        memBurstPeak = count;
+    }
+}
+
+/*******************************************************************************
+* Function Name: MemoryBurstPeak
+********************************************************************************
+* Summary:
+*   Return the largest number of pages programmed in one burst.
+*
+*******************************************************************************/
+uint32_t MemoryBurstPeak(void)
+{
+    return memBurstPeak;
+}
+
+/*******************************************************************************
+* Function Name: MemoryXferStats
+********************************************************************************
+* Summary:
+*   Return the CPU cycles spent on the data phases of reads and programs, by 
+*   the storage task and by the interrupts, since the start. BenchmarkMemory
+*   splits them between the SMIF ISR and the DMA transports (SMIF_DMA_DATA).
+*
+*******************************************************************************/
+const mem_xfer_stats_t * MemoryXferStats(void)
+{
+    return &memXferStats;
+}
+
+/* Sleep one tick while polling the memory, counted in the latency statistics */
+static void PollDelayMemory(void)
+{
+    memPollCount++;
+    MEM_DELAY_FUNC;
+}
+
+/* Add the time since start (DWT cycles) to the statistics of an operation */
+static void RecordLatency(mem_lat_op_t op, uint32_t start, uint32_t polls)
+{
+    mem_latency_t *latency = &memLatency[op];
+    uint32_t us = (DWT->CYCCNT - start) / (SystemCoreClock / 1000000u);
+    uint32_t bucket = 32u - __CLZ(us);
+    
+    if (bucket >= MEM_LAT_BUCKETS)
+    {
+        bucket = MEM_LAT_BUCKETS - 1u;
+    }
+    
+    taskENTER_CRITICAL();
+    if ((latency->count == 0u) || (us < latency->minUs))
+    {
+        latency->minUs = us;
+    }
+    if (us > latency->maxUs)
+    {
+        latency->maxUs = us;
+    }
+    latency->count++;
+    latency->totalUs += us;
+    latency->polls += memPollCount - polls;
+    latency->histogram[bucket]++;
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+* Function Name: MemoryLatency
+********************************************************************************
+* Summary:
+*   This function copies the latency statistics of an operation, kept by the 
+*   storage task since the start or the last MemoryLatencyReset. A latency 
+*   runs from the first command to the moment the memory is ready again, so it
+*   includes the tick sleeps while polling (MEM_DELAY_FUNC).
+*
+* Parameters:
+*   op: The operation.
+*   latency: Receives the statistics.
+*
+*******************************************************************************/
+void MemoryLatency(mem_lat_op_t op, mem_latency_t *latency)
+{
+    taskENTER_CRITICAL();
+    *latency = memLatency[op];
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+* Function Name: MemoryLatencyReset
+********************************************************************************
+* Summary:
+*   This function clears the latency statistics of all operations.
+*
+*******************************************************************************/
+void MemoryLatencyReset(void)
+{
+    taskENTER_CRITICAL();
+    memset(memLatency, 0, sizeof(memLatency));
+    taskEXIT_CRITICAL();
+}
+
+/*******************************************************************************
+* Function Name: BenchmarkMemory
+********************************************************************************
+* Summary:
+*   This function measures the sustained erase, program and read throughput on
+*   a range of sectors, going through the storage task like the recorder. The 
+*   sectors are erased, every page is programmed and then read back. Their 
+*   content is lost. The erase-ahead bank is stopped so that it does not hide
+*   the erase time, the caller restarts it with MEM_OP_ERASE_AHEAD. Must not 
+*   be called from the storage task.
+*   The CPU cost of both data transports is measured on the same pages: the 
+*   first half of the range is programmed through the SMIF ISR and the second
+*   half through the DW channels, then the whole range is read with each. The
+*   read throughput is the one of the transport the build uses.
+*
+* Parameters:
+*   firstSector: The first sector of the range.
+*   sectorCount: The number of sectors.
+*   buffer: PACKET_SIZE bytes, word aligned, programmed in every page and read
+*           back.
+*   result: Receives the throughput of each operation and the transport costs.
+*
+*******************************************************************************/
+void BenchmarkMemory(uint32_t firstSector, 
+                    uint32_t sectorCount, 
+                    uint8_t buffer[], 
+                    mem_bench_t *result)
+{
+    uint32_t pages = sectorCount * (SECTOR_SIZE / PACKET_SIZE);
+    uint32_t dmaPages = (SMIF_DMA_DATA != 0u) ? (pages / 2u) : 0u;
+    uint32_t address = firstSector * SECTOR_SIZE;
+    uint32_t index;
+    TickType_t start;
+    TickType_t ticks;
+    TickType_t dmaTicks;
+    
+    memset(result, 0, sizeof(*result));
+    
+    SyncMemory(MEM_OP_ERASE_AHEAD, NULL, 0, MEM_NO_SECTOR);
+    SyncMemory(MEM_OP_UNMAP, NULL, 0, 0);
+    
+    start = xTaskGetTickCount();
+    for (index = 0; index < sectorCount; index++)
+    {
+        SyncMemory(MEM_OP_ERASE, NULL, 0, firstSector + index);
+    }
+    result->eraseKBps = BenchRate(sectorCount * SECTOR_SIZE, xTaskGetTickCount() - start);
+    
+    for (index = 0; index < PACKET_SIZE; index++)
+    {
+        buffer[index] = (uint8_t) index;
+    }
+    
+    ticks = BenchPass(MEM_OP_PROGRAM, buffer, address, pages - dmaPages, false, &result->isr);
+    ticks += BenchPass(MEM_OP_PROGRAM, buffer, address + ((pages - dmaPages) * PACKET_SIZE), 
+                       dmaPages, true, &result->dma);
+    result->programKBps = BenchRate(pages * PACKET_SIZE, ticks);
+    
+    ticks = BenchPass(MEM_OP_READ, buffer, address, pages, false, &result->isr);
+    dmaTicks = BenchPass(MEM_OP_READ, buffer, address, (dmaPages != 0u) ? pages : 0u, true, &result->dma);
+    result->readKBps = BenchRate(pages * PACKET_SIZE, (dmaPages != 0u) ? dmaTicks : ticks);
+    
+#if (SMIF_DMA_DATA != 0u)
+    /* Back to the transport of the build, the storage task is idle */
+    memDataDma = true;
+#endif
+}
+
+/* Queue a run of benchmark pages with one transport and wait for them. Their 
+   CPU cost is added to the transport, return the time they took */
+static TickType_t BenchPass(mem_op_t op, uint8_t buffer[], uint32_t address, 
+                    uint32_t pages, bool dma, mem_bench_xfer_t *cost)
+{
+    mem_xfer_stats_t before = memXferStats;
+    TickType_t start;
+    uint32_t index;
+    
+#if (SMIF_DMA_DATA != 0u)
+    memDataDma = dma;
+#else
+    (void) dma;
+#endif
+    
+    /* The UNMAP request returns once all the pages queued before it are done */
+    start = xTaskGetTickCount();
+    for (index = 0; index < pages; index++)
+    {
+        QueueBenchMemory(op, buffer, address + (index * PACKET_SIZE));
+    }
+    SyncMemory(MEM_OP_UNMAP, NULL, 0, 0);
+    
+    cost->pages += memXferStats.pages - before.pages;
+    cost->cycles += (memXferStats.issueCycles - before.issueCycles) + 
+                    (memXferStats.isrCycles - before.isrCycles);
+    cost->interrupts += memXferStats.interrupts - before.interrupts;
+    
+    return xTaskGetTickCount() - start;
+}
+
+/* Queue a benchmark page, or wait for it when the queue is full */
+static void QueueBenchMemory(mem_op_t op, uint8_t buffer[], uint32_t address)
+{
+    if (!SubmitMemory(op, buffer, PACKET_SIZE, address, NULL, NULL))
+    {
+        SyncMemory(op, buffer, PACKET_SIZE, address);
+    }
+}
+
+/* Throughput in kB/s of a number of bytes moved in a number of ticks */
+static uint32_t BenchRate(uint32_t bytes, TickType_t ticks)
+{
+    if (ticks == 0u)
+    {
+        ticks = 1u;
+    }
+    
+    return (uint32_t) (((uint64_t) bytes * configTICK_RATE_HZ) / ((uint64_t) ticks * 1000u));
+}
+
+/*******************************************************************************
+* Function Name: MemoryQueueSpace
+********************************************************************************
+* Summary:
+*   Return the number of requests that can still be queued. With the scheduler
+*   suspended, that many SubmitMemory calls cannot fail.
+*
+*******************************************************************************/
+uint32_t MemoryQueueSpace(void)
+{
+    return uxQueueSpacesAvailable(StorageQueue);
+}
+
+/*******************************************************************************
+* Function Name: EraseCountInit
+********************************************************************************
+* Summary:
+*   This function restores the erase counters saved before the last reset. 
+*   The counters are kept by StartEraseMemory for every sector erased.
+*
+* Parameters:
+*   counts: Erases of each sector, NUM_SECTORS_IN_MEM counters.
+*
+*******************************************************************************/
+void EraseCountInit(const uint32_t counts[])
+{
+    memcpy(memEraseCount, counts, sizeof(memEraseCount));
+}
+
+/*******************************************************************************
+* Function Name: EraseCount
+********************************************************************************
+* Summary:
+*   Return the number of times a sector was erased.
+*
+* Parameters:
+*   sector: The sector.
+*
+*******************************************************************************/
+uint32_t EraseCount(uint32_t sector)
+{
+    return (sector < NUM_SECTORS_IN_MEM) ? memEraseCount[sector] : 0;
+}
+
+/*******************************************************************************
+* Function Name: EraseAheadInit
+********************************************************************************
+* Summary:
+*   This function sets the order in which the sectors are erased ahead. The 
+*   bank starts with a MEM_OP_ERASE_AHEAD request giving the first sector. Then
+*   the storage task keeps up to ERASE_AHEAD_SECTORS sectors erased, using the 
+*   time the bus is idle. A MEM_OP_ERASE of a banked sector completes at once.
+*
+* Parameters:
+*   nextSector: Returns the sector to erase after a given one.
+*
+*******************************************************************************/
+void EraseAheadInit(mem_next_sector_t nextSector)
+{
+    eraseNextSector = nextSector;
+}
+
+/*******************************************************************************
+* Function Name: EraseAheadBanked
+********************************************************************************
+* Summary:
+*   Return the number of sectors erased ahead and not yet used. This is the 
+*   headroom left before the writer has to wait for a full sector erase.
+*
+*******************************************************************************/
+uint32_t EraseAheadBanked(void)
+{
+    return erasePoolCount;
+}
+
+/*******************************************************************************
+* Function Name: EraseAheadPending
+********************************************************************************
+* Summary:
+*   This function tells if a sector is not banked yet but is the next one the
+*   bank erases. A MEM_OP_ERASE of it would hold the queue for a full erase, 
+*   while the erase ahead lets the reads and the programs through.
+*
+* Parameters:
+*   sector: The sector the writer needs next.
+*
+* Return:
+*   bool: true if the sector is about to be banked.
+*
+*******************************************************************************/
+bool EraseAheadPending(uint32_t sector)
+{
+    bool banked = false;
+    uint32_t index;
+    
+    taskENTER_CRITICAL();
+    for (index = 0; index < erasePoolCount; index++)
+    {
+        banked |= (erasePool[index] == sector);
+    }
+    taskEXIT_CRITICAL();
+    
+    return !banked && (eraseNext == sector) && !memMapped;
+}
+
+/* Remove a sector from the erased pool, return false if it is not banked */
+static bool TakeErasedSector(uint32_t sector)
+{
+    bool found = false;
+    uint32_t index;
+    
+    taskENTER_CRITICAL();
+    for (index = 0; index < erasePoolCount; index++)
+    {
+        if (found)
+        {
+            erasePool[index-1] = erasePool[index];
+        }
+        else if (erasePool[index] == sector)
+        {
+            found = true;
+        }
+    }
+    if (found)
+    {
+        erasePoolCount--;
+    }
+    taskEXIT_CRITICAL();
+    
+    return found;
+}
+
+/*******************************************************************************
+* Function Name: EraseAheadStep
+********************************************************************************
+* Summary:
+*   This function erases the next sector of the bank. While the erase is in
+*   progress, read and program requests are served by suspending the erase, so
+*   playback and recording are never stuck behind it. Other requests wait for
+*   the end of the erase.
+*
+*******************************************************************************/
+static void EraseAheadStep(void)
+{
+    mem_request_t request;
+    uint32_t sector = eraseNext;
+    uint32_t start;
+    uint32_t polls;
+    
+    /* Bank full, wait for the writer to use a sector */
+    if (erasePoolCount >= ERASE_AHEAD_SECTORS)
+    {
+        if (xQueuePeek(StorageQueue, &request, portMAX_DELAY))
+        {
+            /* Let the main loop serve the request */
+        }
+        return;
+    }
+    
+    start = DWT->CYCCNT;
+    polls = memPollCount;
+    StartEraseMemory(sector);
+    
+    while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
+    {
+        /* Sleep, but wake up as soon as a request is submitted */
+        if (xQueuePeek(StorageQueue, &request, 1) == pdTRUE)
+        {
+            if (((request.op == MEM_OP_READ) || (request.op == MEM_OP_PROGRAM)) && SuspendEraseMemory())
+            {
+                /* Serve the urgent requests while the erase is suspended */
+                while ((xQueuePeek(StorageQueue, &request, 0) == pdTRUE) &&
+                       ((request.op == MEM_OP_READ) || (request.op == MEM_OP_PROGRAM)))
+                {
+                    xQueueReceive(StorageQueue, &request, 0);
+                    ExecuteMemory(&request);
+                }
+                
+                ResumeEraseMemory();
+            }
+            else
+            {
+                /* Other requests are served once the erase is completed */
+                PollDelayMemory();
+            }
+        }
+    }
+    RecordLatency(MEM_LAT_ERASE_AHEAD, start, polls);
+    
+    /* Bank the sector, unless the writer restarted the bank meanwhile */
+    if (eraseNext == sector)
+    {
+        taskENTER_CRITICAL();
+        erasePool[erasePoolCount] = sector;
+        erasePoolCount++;
+        taskEXIT_CRITICAL();
+        
+        eraseNext = (eraseNextSector != NULL) ? eraseNextSector(sector) : MEM_NO_SECTOR;
+    }
+}
+
+/* Suspend the erase in progress, return false if it completed meanwhile */
+static bool SuspendEraseMemory(void)
+{
+    uint8_t status = 0;
+    
+    Cy_SMIF_TransmitCommand(SMIF_1_HW, MEM_CMD_ERASE_SUSPEND, CY_SMIF_WIDTH_SINGLE, NULL, 0, 
+                            CY_SMIF_WIDTH_SINGLE, smifMemConfigs[0]->slaveSelect, CY_SMIF_TX_LAST_BYTE, &SMIF_1_context);
+    
+    while(Cy_SMIF_Memslot_IsBusy(SMIF_1_HW, (cy_stc_smif_mem_config_t*)smifMemConfigs[0], &SMIF_1_context))
+    {
+        /* Wait till the memory enters the suspended state */
+        PollDelayMemory();
+    }
+    
+    Cy_SMIF_Memslot_CmdReadSts(SMIF_1_HW, smifMemConfigs[0], &status, MEM_CMD_READ_STS2, &SMIF_1_context);
+    
+    return ((status & MEM_STS2_ERASE_SUSPEND) != 0u);
+}
+
+/* Resume the suspended erase and let it progress before the next suspend */
+static void ResumeEraseMemory(void)
+{
+    Cy_SMIF_TransmitCommand(SMIF_1_HW, MEM_CMD_ERASE_RESUME, CY_SMIF_WIDTH_SINGLE, NULL, 0, 
+                            CY_SMIF_WIDTH_SINGLE, smifMemConfigs[0]->slaveSelect, CY_SMIF_TX_LAST_BYTE, &SMIF_1_context);
+    
+    vTaskDelay(MEM_RESUME_DELAY);
+}
+
+/*******************************************************************************
+* Function Name: SubmitMemory
+********************************************************************************
+* Summary:
+*   This function queues a request to the storage task and returns immediately.
+*   The callback is called from the storage task once the request is completed.
+*
+* Parameters:
+*   op: Operation to execute.
+*   buffer: Data buffer, must remain valid until completion.
+*   size: The size of data.
+*   address: The address to access, or the sector to erase.
+*   callback: Function called on completion, can be NULL.
+*   arg: Argument passed to the callback.
+*
+* Return:
+*   bool: false if the storage queue is full.
+*
+*******************************************************************************/
+bool SubmitMemory(mem_op_t op, 
+                    uint8_t buffer[], 
+                    uint32_t size, 
+                    uint32_t address, 
+                    mem_callback_t callback, 
+                    void *arg)
+{
+    mem_request_t request =
+    {
+        .op = op,
+        .buffer = buffer,
+        .size = size,
+        .address = address,
+        .callback = callback,
+        .arg = arg
+    };
+    
+    return (xQueueSend(StorageQueue, &request, 0) == pdPASS);
+}
+
+/*******************************************************************************
+* Function Name: SyncMemory
+********************************************************************************
+* Summary:
+*   This function queues a request to the storage task and blocks the calling
+*   task until it is completed. Must not be called from the storage task. The
+*   queue is served in order, so MEM_OP_SYNC waits for the requests submitted
+*   before. A storage task stalled for MEM_SYNC_TIMEOUT is an unrecoverable 
+*   error.
+*
+* Parameters:
+*   op: Operation to execute.
+*   buffer: Data buffer.
+*   size: The size of data.
+*   address: The address to access, or the sector to erase.
+*
+*******************************************************************************/
+void SyncMemory(mem_op_t op, 
+                    uint8_t buffer[], 
+                    uint32_t size, 
+                    uint32_t address)
+{
+    mem_request_t request =
+    {
+        .op = op,
+        .buffer = buffer,
+        .size = size,
+        .address = address,
+        .callback = WakeMemoryCallback,
+        .arg = xTaskGetCurrentTaskHandle()
+    };
+    
+    if (xQueueSend(StorageQueue, &request, MEM_SYNC_TIMEOUT) != pdPASS)
+    {
+        HandleErrorMemory();
+    }
+    
+    /* Wait till the storage task completes the request */
+    if (ulTaskNotifyTake(pdTRUE, MEM_SYNC_TIMEOUT) == 0u)
+    {
+        HandleErrorMemory();
+    }
+}
+
+/* Wake up the task blocked in SyncMemory */
+static void WakeMemoryCallback(mem_op_t op, uint32_t address, void *arg)
+{
+    (void) op;
+    (void) address;
+    
+    xTaskNotifyGive((TaskHandle_t) arg);
+}
+
 /*******************************************************************************
 * Function Name: handle_error
 ********************************************************************************
@@ -259,14 +1163,172 @@ void HandleErrorMemory(void)
 *******************************************************************************/
 void SMIF_Interrupt_User(void)
 {
+    uint32_t start = DWT->CYCCNT;
+    
     Cy_SMIF_Interrupt(SMIF_1_HW, &SMIF_1_context);
+    
+    memXferStats.interrupts++;
+    memXferStats.isrCycles += DWT->CYCCNT - start;
 }
 
+#if (SMIF_DMA_DATA != 0u)
+/*******************************************************************************
+* Function Name: SMIF_DMA_Interrupt_User
+****************************************************************************//**
+* Summary:
+*   The ISR of both SMIF data channels. It runs once per page, when the channel
+*   has moved the whole buffer, and wakes up the storage task.
+*  
+*******************************************************************************/
+void SMIF_DMA_Interrupt_User(void)
+{
+    uint32_t start = DWT->CYCCNT;
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    
+    Cy_DMA_Channel_ClearInterrupt(SMIF_DMA_HW, SMIF_DMA_TX_CHANNEL);
+    Cy_DMA_Channel_ClearInterrupt(SMIF_DMA_HW, SMIF_DMA_RX_CHANNEL);
+    if (storageTaskHandle != NULL)
+    {
+        vTaskNotifyGiveFromISR(storageTaskHandle, &higherPriorityTaskWoken);
+    }
+    
+    memXferStats.interrupts++;
+    memXferStats.isrCycles += DWT->CYCCNT - start;
+    portYIELD_FROM_ISR(higherPriorityTaskWoken);
+}
+
+/*******************************************************************************
+* Function Name: InitDataDma
+****************************************************************************//**
+* Summary:
+*   This function sets up the two SMIF data channels of DW1. The design has no 
+*   component for them, so the trigger routes from the SMIF FIFO requests are
+*   connected here, as the fitter does for the DMA components.
+*
+*******************************************************************************/
+static void InitDataDma(void)
+{
+    cy_stc_sysint_t dmaIntConfig =
+    {
+        .intrSrc = SMIF_DMA_TX_IRQ,
+        .intrPriority = SMIF_PRIORITY
+    };
+    cy_stc_dma_channel_config_t channelConfig =
+    {
+        .descriptor  = &smifTxDescriptor,
+        .preemptable = false,
+        .priority    = SMIF_DMA_PRIORITY,
+        .enable      = false,
+        .bufferable  = false
+    };
+    
+    /* The FIFO requests a word each time it can take or give one */
+    Cy_SMIF_SetTxFifoTriggerLevel(SMIF_1_HW, SMIF_DMA_TX_LEVEL);
+    Cy_SMIF_SetRxFifoTriggerLevel(SMIF_1_HW, SMIF_DMA_RX_LEVEL);
+    
+    /* The requests stay active while the FIFO level holds, level triggers */
+    if ((Cy_TrigMux_Connect(SMIF_DMA_TX_TRIG_REQ, SMIF_DMA_TX_TRIG_GROUP, false, TRIGGER_TYPE_LEVEL) != CY_TRIGMUX_SUCCESS) ||
+        (Cy_TrigMux_Connect(SMIF_DMA_TX_TRIG_REDUCED, SMIF_DMA_TX_TRIG_CHANNEL, false, TRIGGER_TYPE_LEVEL) != CY_TRIGMUX_SUCCESS) ||
+        (Cy_TrigMux_Connect(SMIF_DMA_RX_TRIG_REQ, SMIF_DMA_RX_TRIG_GROUP, false, TRIGGER_TYPE_LEVEL) != CY_TRIGMUX_SUCCESS) ||
+        (Cy_TrigMux_Connect(SMIF_DMA_RX_TRIG_REDUCED, SMIF_DMA_RX_TRIG_CHANNEL, false, TRIGGER_TYPE_LEVEL) != CY_TRIGMUX_SUCCESS))
+    {
+        HandleErrorMemory();
+    }
+    
+    if (Cy_DMA_Channel_Init(SMIF_DMA_HW, SMIF_DMA_TX_CHANNEL, &channelConfig) != CY_DMA_SUCCESS)
+    {
+        HandleErrorMemory();
+    }
+    channelConfig.descriptor = &smifRxDescriptor;
+    if (Cy_DMA_Channel_Init(SMIF_DMA_HW, SMIF_DMA_RX_CHANNEL, &channelConfig) != CY_DMA_SUCCESS)
+    {
+        HandleErrorMemory();
+    }
+    Cy_DMA_Channel_SetInterruptMask(SMIF_DMA_HW, SMIF_DMA_TX_CHANNEL, CY_DMA_INTR_MASK);
+    Cy_DMA_Channel_SetInterruptMask(SMIF_DMA_HW, SMIF_DMA_RX_CHANNEL, CY_DMA_INTR_MASK);
+    Cy_DMA_Enable(SMIF_DMA_HW);
+    
+    Cy_SysInt_Init(&dmaIntConfig, SMIF_DMA_Interrupt_User);
+    NVIC_EnableIRQ(SMIF_DMA_TX_IRQ);
+    dmaIntConfig.intrSrc = SMIF_DMA_RX_IRQ;
+    Cy_SysInt_Init(&dmaIntConfig, SMIF_DMA_Interrupt_User);
+    NVIC_EnableIRQ(SMIF_DMA_RX_IRQ);
+}
+
+/*******************************************************************************
+* Function Name: StartDataDma
+****************************************************************************//**
+* Summary:
+*   This function loads a SMIF data channel with one transfer and enables it.
+*   The channel follows the FIFO trigger one word at a time and interrupts once 
+*   the buffer is done, the channel then disables itself.
+*
+* Parameters:
+*   transmit: true to feed the TX FIFO, false to drain the RX FIFO
+*   buffer: The SRAM side of the transfer
+*   size: The size of data
+*
+* Return:
+*   false if the buffer does not suit word transfers, the caller then lets the 
+*   SMIF ISR move the data
+*
+*******************************************************************************/
+static bool StartDataDma(bool transmit, uint8_t buffer[], uint32_t size)
+{
+    uint32_t channel = transmit ? SMIF_DMA_TX_CHANNEL : SMIF_DMA_RX_CHANNEL;
+    cy_stc_dma_descriptor_t *descriptor = transmit ? &smifTxDescriptor : &smifRxDescriptor;
+    cy_stc_dma_descriptor_config_t config =
+    {
+        .retrigger       = CY_DMA_RETRIG_4CYC,
+        .interruptType   = CY_DMA_DESCR,
+        .triggerOutType  = CY_DMA_DESCR,
+        .channelState    = CY_DMA_CHANNEL_DISABLED,
+        .triggerInType   = CY_DMA_1ELEMENT,
+        .dataSize        = CY_DMA_WORD,
+        .srcTransferSize = CY_DMA_TRANSFER_SIZE_DATA,
+        .dstTransferSize = CY_DMA_TRANSFER_SIZE_DATA,
+        .descriptorType  = CY_DMA_1D_TRANSFER,
+        .srcXincrement   = transmit ? 1 : 0,
+        .dstXincrement   = transmit ? 0 : 1,
+        .xCount          = size / sizeof(uint32_t),
+        .nextDescriptor  = NULL
+    };
+    
+    /* Word FIFO accesses only */
+    if ((size == 0u) || ((((uint32_t) (uintptr_t) buffer) | size) & (sizeof(uint32_t) - 1u)) != 0u ||
+        ((size / sizeof(uint32_t)) > SMIF_DMA_MAX_WORDS))
+    {
+        return false;
+    }
+    
+    if (transmit)
+    {
+        config.srcAddress = (void *) buffer;
+        config.dstAddress = (void *) &SMIF_1_HW->TX_DATA_FIFO_WR4;
+    }
+    else
+    {
+        config.srcAddress = (void *) &SMIF_1_HW->RX_DATA_FIFO_RD4;
+        config.dstAddress = (void *) buffer;
+    }
+    
+    if (Cy_DMA_Descriptor_Init(descriptor, &config) != CY_DMA_SUCCESS)
+    {
+        HandleErrorMemory();
+    }
+    Cy_DMA_Channel_SetDescriptor(SMIF_DMA_HW, channel, descriptor);
+    Cy_DMA_Channel_Enable(SMIF_DMA_HW, channel);
+    
+    return true;
+}
+#endif
+
 /*******************************************************************************
 * Function Name: RxCmpltCallback
 ****************************************************************************//**
 * Summary:
-*   The callback called after the transfer completion.
+*   The callback called by the SMIF ISR after the transfer completion. It 
+*   notifies the storage task blocked on the data phase.
 *
 * Parameters:
 *   event: The event of the callback.
@@ -274,9 +1336,16 @@ void SMIF_Interrupt_User(void)
 *******************************************************************************/
 void RxCmpltMemoryCallback (uint32_t event)
 {
-    if(0u == event)
+    BaseType_t higherPriorityTaskWoken = pdFALSE;
+    
+    (void) event;
+    
+    /* Wake up the storage task waiting for the end of the data phase */
+    if (storageTaskHandle != NULL)
     {
-        /*The process event is 0*/
+        vTaskNotifyGiveFromISR(storageTaskHandle, &higherPriorityTaskWoken);
+        
+        portYIELD_FROM_ISR(higherPriorityTaskWoken);
     }
 }
 
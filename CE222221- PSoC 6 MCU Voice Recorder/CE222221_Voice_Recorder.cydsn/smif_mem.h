@@ -51,12 +51,108 @@
     
 
     
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+
+/* Operations that can be submitted to the storage task */
+typedef enum
+{
+    MEM_OP_READ     = 0x00u,    /* Read a buffer from memory */
+    MEM_OP_PROGRAM  = 0x01u,    /* Program a buffer into memory */
+    MEM_OP_ERASE    = 0x02u,    /* Erase a sector, address holds the sector */
+    MEM_OP_MAP      = 0x03u,    /* Switch the SMIF to memory-mapped (XIP) mode */
+    MEM_OP_UNMAP    = 0x04u,    /* Switch the SMIF back to command mode */
+    MEM_OP_ERASE_AHEAD = 0x05u, /* Restart the erase-ahead bank at address (sector) */
+    MEM_OP_SYNC     = 0x06u,    /* Nothing, completes after the requests queued before */
+}   mem_op_t;
+
+/* Completion callback, executed in the context of the storage task */
+typedef void (*mem_callback_t)(mem_op_t op, uint32_t address, void *arg);
+
+/* Return the sector to erase after a given one, or MEM_NO_SECTOR to stop */
+typedef uint32_t (*mem_next_sector_t)(uint32_t sector);
+
+/* Request queued to the storage task */
+typedef struct
+{
+    mem_op_t        op;         /* Operation to execute */
+    uint8_t         *buffer;    /* Data buffer, unused for erase */
+    uint32_t        size;       /* Size of data */
+    uint32_t        address;    /* Memory address, or sector for erase */
+    mem_callback_t  callback;   /* Called when the operation completes */
+    void            *arg;       /* Argument passed to the callback */
+}   mem_request_t;
+
+/* CPU cost of the SMIF data phases, in CM4 cycles (DWT counter) */
+typedef struct
+{
+    uint32_t        pages;      /* Data phases completed */
+    uint32_t        interrupts; /* SMIF and SMIF DMA interrupts taken */
+    uint32_t        isrCycles;  /* Cycles spent in those interrupts */
+    uint32_t        issueCycles;/* Cycles the storage task spent starting them */
+}   mem_xfer_stats_t;
+
+/* SMIF operations timed by the latency statistics */
+typedef enum
+{
+    MEM_LAT_ERASE       = 0x00u,    /* Sector erase, the requester waits for it */
+    MEM_LAT_ERASE_AHEAD = 0x01u,    /* Erase ahead, suspended periods included */
+    MEM_LAT_PROGRAM     = 0x02u,    /* Page program, until the memory is ready */
+    MEM_LAT_READ        = 0x03u,    /* Read, until the data is in SRAM */
+    MEM_LAT_OPS         = 0x04u,    /* Number of timed operations */
+}   mem_lat_op_t;
+
+#define MEM_LAT_BUCKETS     (24u)       /* Latency histogram buckets */
+
+/* Latency statistics of one operation, in microseconds. Bucket n of the 
+   histogram counts the latencies from 2^(n-1) up to 2^n - 1 us, bucket 0 the
+   ones below 1 us, and the last bucket all the longer ones */
+typedef struct
+{
+    uint32_t        count;      /* Operations timed */
+    uint32_t        minUs;      /* Shortest latency */
+    uint32_t        maxUs;      /* Longest latency */
+    uint64_t        totalUs;    /* Sum of the latencies, mean is totalUs/count */
+    uint32_t        polls;      /* Tick sleeps while polling the memory */
+    uint32_t        histogram[MEM_LAT_BUCKETS]; /* Log2 latency histogram */
+}   mem_latency_t;
+
+/* CPU cost of the pages moved by one data transport during BenchmarkMemory */
+typedef struct
+{
+    uint32_t        pages;      /* Pages programmed and read */
+    uint32_t        cycles;     /* Cycles to issue them and in their interrupts */
+    uint32_t        interrupts; /* Interrupts taken */
+}   mem_bench_xfer_t;
+
+/* Sustained throughput measured by BenchmarkMemory, in kB/s (1000 bytes) */
+typedef struct
+{
+    uint32_t        eraseKBps;  /* Sector erases */
+    uint32_t        programKBps;/* Page programs, queued back to back */
+    uint32_t        readKBps;   /* Page reads, queued back to back */
+    mem_bench_xfer_t isr;       /* FIFOs fed by the SMIF ISR */
+    mem_bench_xfer_t dma;       /* FIFOs fed by the DW channels, SMIF_DMA_DATA */
+}   mem_bench_t;
+    
 /*******************************************************************************
 *            Function Prototypes
 *******************************************************************************/
 
 
 void InitMemory(void);
+void StorageTask(void *arg);                             /* Owns the SMIF, serves requests */
+bool SubmitMemory(mem_op_t op,
+                    uint8_t buffer[],
+                    uint32_t size,
+                    uint32_t address,
+                    mem_callback_t callback,
+                    void *arg);                          /* Queue a request, non-blocking */
+void SyncMemory(mem_op_t op,
+                    uint8_t buffer[],
+                    uint32_t size,
+                    uint32_t address);                   /* Queue a request and wait for it */
 void EraseMemory(uint32_t sector);
 void WriteMemory(uint8_t txBuffer[], 	
                     uint32_t txSize, 	
@@ -64,6 +160,26 @@ void WriteMemory(uint8_t txBuffer[],
 void ReadMemory(uint8_t rxBuffer[], 	
                     uint32_t rxSize, 	
                     uint32_t address);  				 /* Read data from memory in the quad mode */
+void StartEraseMemory(uint32_t sector);                  /* Erase without waiting */
+void EraseAheadInit(mem_next_sector_t nextSector);       /* Order to erase ahead */
+uint32_t EraseAheadBanked(void);                         /* Erased sectors ready */
+bool EraseAheadPending(uint32_t sector);                 /* Sector the bank erases next */
+uint32_t MemoryBurstPeak(void);                          /* Longest program burst */
+uint32_t MemoryQueueSpace(void);                         /* Requests that can be queued */
+void EraseCountInit(const uint32_t counts[]);            /* Restore the erase counters */
+uint32_t EraseCount(uint32_t sector);                    /* Erases of a sector */
+void MapMemory(void);                                    /* Enter memory-mapped (XIP) mode */
+void UnmapMemory(void);                                  /* Back to command mode */
+bool IsMemoryMapped(void);
+uint8_t * MappedAddress(uint32_t address);               /* XIP address of a memory offset */
+const mem_xfer_stats_t * MemoryXferStats(void);          /* CPU cost of the data phases */
+void MemoryLatency(mem_lat_op_t op, 
+                    mem_latency_t *latency);             /* Copy the statistics of an operation */
+void MemoryLatencyReset(void);
+void BenchmarkMemory(uint32_t firstSector,
+                    uint32_t sectorCount,
+                    uint8_t buffer[],
+                    mem_bench_t *result);                /* Erase, program and read a range */
 void HandleErrorMemory(void);
 void RxCmpltMemoryCallback (uint32_t event);
 
@@ -76,13 +192,58 @@ void RxCmpltMemoryCallback (uint32_t event);
 #define TIMEOUT_1_MS        (1000ul)    /* 1 ms timeout for all blocking functions */
 #define LED_ON              (0u)        /* Value to switch LED ON  */
 #define LED_OFF             (!LED_ON)   /* Value to switch LED OFF */
-#define SMIF_PRIORITY       (1u)        /* SMIF interrupt priority */ 
+#define SMIF_PRIORITY       (6u)        /* SMIF interrupt priority, calls RTOS API */ 
 #define NUM_PAGES_IN_SECTOR (0x80u)     /* Number of pages in a sector */
 #define NUM_SECTORS_IN_MEM  (0x40u)     /* Number of sectors in the memory */
 #define SECTOR_SIZE         (0x40000u)  /* Size of a sector */
 #define SECTOR_MULTIPLIER   (0x4u)      /* Multiplier to define sector address */
 
+#define MEM_NO_SECTOR       (0xFFFFFFFFu) /* No sector to erase */
+
+/* Memory timing, S25FL512S typical, see RECORD_FLASH_BUDGET_US */
+#define MEM_PROGRAM_US      (340u)      /* tPP, 512-byte page program */
+#define MEM_ERASE_US        (520000u)   /* tSE, 256 KB sector erase */
+#define MEM_SUSPEND_US      (45u)       /* tESL maximum, erase suspend latency */
+
+/* Erase-ahead bank */
+#define ERASE_AHEAD_SECTORS (4u)        /* Erased sectors kept ahead of the writer */
+#define MEM_CMD_ERASE_SUSPEND   (0x75u) /* Program/erase suspend command */
+#define MEM_CMD_ERASE_RESUME    (0x7Au) /* Program/erase resume command */
+#define MEM_CMD_READ_STS2       (0x07u) /* Read status register 2 command */
+#define MEM_STS2_ERASE_SUSPEND  (0x02u) /* Status register 2 erase suspended bit */
+#define MEM_RESUME_DELAY        (4u)    /* Ticks an erase runs before the next suspend */
+
 #define MEM_DELAY_FUNC      vTaskDelay(1)
+#define MEM_XFER_TIMEOUT    pdMS_TO_TICKS(10u)  /* Max wait for a SMIF data phase */
+#define MEM_SYNC_TIMEOUT    pdMS_TO_TICKS(10000u) /* Max wait in SyncMemory, a few sector 
+                                                     erases at tSE max, 2.6 s */
+
+/* Data phase transport. 0u: the SMIF ISR feeds the FIFOs a few bytes per 
+   interrupt. 1u: two DW1 channels move the words, one interrupt per page. 
+   They are not components of TopDesign: InitMemory sets them up and routes 
+   the tr_tx_req and tr_rx_req outputs of SMIF_1 to them through the trigger 
+   reduction group 13. The channels and the group outputs must be left free 
+   by the design */
+#define SMIF_DMA_DATA       (1u)
+#define SMIF_DMA_HW         (DW1)
+#define SMIF_DMA_TX_CHANNEL (14u)
+#define SMIF_DMA_RX_CHANNEL (15u)
+#define SMIF_DMA_PRIORITY   (3u)        /* Lowest, the audio channels go first */
+#define SMIF_DMA_TX_LEVEL   (4u)        /* TX FIFO used entries that request a word */
+#define SMIF_DMA_RX_LEVEL   (3u)        /* RX FIFO used entries above which a word is requested */
+#define SMIF_DMA_MAX_WORDS  (256u)      /* Longest X loop of a DW descriptor */
+#define SMIF_DMA_TX_IRQ     ((IRQn_Type) ((uint32_t) cpuss_interrupts_dw1_0_IRQn + SMIF_DMA_TX_CHANNEL))
+#define SMIF_DMA_RX_IRQ     ((IRQn_Type) ((uint32_t) cpuss_interrupts_dw1_0_IRQn + SMIF_DMA_RX_CHANNEL))
+
+/* Trigger routes: SMIF request -> group 13 output -> DW1 channel input */
+#define SMIF_DMA_TX_TRIG_REQ    (TRIG13_IN_SMIF_TR_TX_REQ)
+#define SMIF_DMA_TX_TRIG_GROUP  (TRIG13_OUT_TR_GROUP1_INPUT41)
+#define SMIF_DMA_TX_TRIG_REDUCED (TRIG1_IN_TR_GROUP13_OUTPUT30)
+#define SMIF_DMA_TX_TRIG_CHANNEL (TRIG1_OUT_CPUSS_DW1_TR_IN14)
+#define SMIF_DMA_RX_TRIG_REQ    (TRIG13_IN_SMIF_TR_RX_REQ)
+#define SMIF_DMA_RX_TRIG_GROUP  (TRIG13_OUT_TR_GROUP1_INPUT42)
+#define SMIF_DMA_RX_TRIG_REDUCED (TRIG1_IN_TR_GROUP13_OUTPUT31)
+#define SMIF_DMA_RX_TRIG_CHANNEL (TRIG1_OUT_CPUSS_DW1_TR_IN15)
 
 #endif /*__SMIF_MEM_H*/
     
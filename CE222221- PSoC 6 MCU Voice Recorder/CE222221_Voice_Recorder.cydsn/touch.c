@@ -56,6 +56,10 @@
 /* Macro used to clear the variables that track finger position on the slider */
 #define CLEAR_POSITION          (uint8_t)(0x00u)
 
+/* Latest slider position, a single SLIDER_POSITION event is queued for it */
+volatile uint8_t    sliderLatest        = CLEAR_POSITION;
+volatile bool       sliderPending       = false;
+
 /*******************************************************************************
 * Function Name: void InitTouch(void)
 ********************************************************************************
@@ -107,6 +111,9 @@ void TouchTask(void *arg)
     uint8_t static      prevRightButton  = NO_TOUCH;
     uint8_t static      currLeftButton   = NO_TOUCH;
     uint8_t static      currRightButton  = NO_TOUCH;
+    uint8_t static      sentSliderPos    = CLEAR_POSITION;
+    uint32_t            sliderEvent;
+    bool                sendSlider;
     
     /* Variable that stores the status of touch on the slider */
     bool    static      sliderTouched       = false;
@@ -231,6 +238,30 @@ void TouchTask(void *arg)
                                     
                     /* Send a "no touch" for this scan */
                     touchInformation.touchType = NO_TOUCH;
+                    
+                    /* Force the first position to be sent */
+                    sentSliderPos = (uint8_t) (currSliderPos + TOUCH_SLIDER_STEP);
+                }
+                
+                /* Send the absolute position as well, once it moved enough. The 
+                   event is not queued again until read, the buttons always 
+                   find room in the queue while scrubbing */
+                if ((currSliderPos >= (sentSliderPos + TOUCH_SLIDER_STEP)) ||
+                    ((currSliderPos + TOUCH_SLIDER_STEP) <= sentSliderPos))
+                {
+                    sentSliderPos = currSliderPos;
+                    
+                    taskENTER_CRITICAL();
+                    sliderLatest = currSliderPos;
+                    sendSlider = !sliderPending;
+                    sliderPending = true;
+                    taskEXIT_CRITICAL();
+                    
+                    sliderEvent = SLIDER_POSITION;
+                    if (sendSlider && (xQueueSend(EventsQueue, &sliderEvent, 0) != pdPASS))
+                    {
+                        sliderPending = false;
+                    }
                 }
             }
             /* Check if the select button (button 0) is touched */
@@ -295,4 +326,29 @@ void TouchTask(void *arg)
     }
 }
 
+/*******************************************************************************
+* Function Name: TouchSliderPosition
+********************************************************************************
+*
+* Summary:
+*  Returns the latest slider position, on a SLIDER_POSITION event. The positions
+*  the finger passed while the event waited in the queue are skipped, the next
+*  move queues a new event.
+*
+* Return:
+*  uint8_t: Slider position, 0 to TOUCH_SLIDER_MAX.
+*
+*******************************************************************************/
+uint8_t TouchSliderPosition(void)
+{
+    uint8_t position;
+    
+    taskENTER_CRITICAL();
+    position = sliderLatest;
+    sliderPending = false;
+    taskEXIT_CRITICAL();
+    
+    return position;
+}
+
 /* [] END OF FILE */
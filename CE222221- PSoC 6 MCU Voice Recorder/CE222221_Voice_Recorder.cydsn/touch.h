@@ -62,8 +62,12 @@
         LEFT_BUTTON     = 0x10000001u,
         RIGHT_BUTTON    = 0x10000002u,
         SLIDER_LEFT     = 0x10000003u,
-        SLIDER_RIGHT    = 0x10000004u
+        SLIDER_RIGHT    = 0x10000004u,
+        SLIDER_POSITION = 0x10010000u     /* Read the position with TouchSliderPosition */
     }   touch_data_types_t;
+    
+    #define TOUCH_SLIDER_MAX        100u        /* Slider centroid resolution */
+    #define TOUCH_SLIDER_STEP       2u          /* Slider travel between two positions sent */
 
     /* Data type that stores touch information */
     typedef struct
@@ -77,6 +81,9 @@
 
     /* Function to read and analyze the touch information from the CapSense sensors */
     void TouchTask(void *arg);
+    
+    /* Function that returns the latest slider position, on a SLIDER_POSITION event */
+    uint8_t TouchSliderPosition(void);
 
 #endif
 /* [] END OF FILE */
@@ -0,0 +1,165 @@
+/******************************************************************************
+* File Name: vad.c
+*
+* Version: 1.0
+*
+* Description: This file contains the voice activity detector, a processing
+*              stage that marks the silent pages
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+#include <stdlib.h>
+#include "vad.h"
+
+/*******************************************************************************
+* Function Name: VadInit
+********************************************************************************
+* Summary:
+*   This function resets a voice activity detector. The noise floor starts at
+*   the lowest speech level and settles on the first quiet blocks.
+*
+* Parameters:
+*   vad: Detector to reset.
+*
+*******************************************************************************/
+void VadInit(vad_t *vad)
+{
+    vad->level = 0;
+    vad->crossings = 0;
+    vad->noiseFloor = VAD_FLOOR_INIT*16u;
+    vad->hangover = 0;
+    vad->silent = false;
+    vad->silentBlocks = 0;
+}
+
+/*******************************************************************************
+* Function Name: VadProcess
+********************************************************************************
+* Summary:
+*   This function is the process of a voice activity stage, its state is a 
+*   vad_t. The level of a block is the mean of its absolute samples, and the 
+*   zero crossings are counted on the first channel. A voiced block holds the
+*   following ones voiced for VAD_HANGOVER_MS, so the end of a word is kept. 
+*   The samples are left unchanged, the result is in silent.
+*
+* Parameters:
+*   stage: Stage run, its state is the detector.
+*   block: Block of 16-bit or 24-bit samples.
+*
+*******************************************************************************/
+void VadProcess(dsp_stage_t *stage, dsp_block_t *block)
+{
+    vad_t *vad = (vad_t *) stage->state;
+    uint32_t sum = 0;
+    uint32_t crossings = 0;
+    uint32_t threshold;
+    uint32_t frame;
+    uint32_t channel;
+    int32_t sample;
+    int32_t previous = 0;
+    bool voiced;
+    
+    if (block->frames == 0u)
+    {
+        return;
+    }
+    
+    for (frame = 0; frame < block->frames; frame++)
+    {
+        for (channel = 0; channel < block->channels; channel++)
+        {
+            /* 24-bit samples are compared at the 16-bit scale */
+            if (block->sampleSize == sizeof(int32_t))
+            {
+                sample = ((int32_t *) block->samples)[frame*block->channels + channel] >> 8;
+            }
+            else
+            {
+                sample = ((int16_t *) block->samples)[frame*block->channels + channel];
+            }
+            
+            sum += (uint32_t) abs(sample);
+            
+            if (channel == 0u)
+            {
+                if ((sample ^ previous) < 0)
+                {
+                    crossings++;
+                }
+                previous = sample;
+            }
+        }
+    }
+    
+    vad->level = sum / (block->frames*block->channels);
+    vad->crossings = (crossings*1024u) / block->frames;
+    
+    /* Speech stands above the background, a fricative less so but crosses often */
+    threshold = (vad->noiseFloor/16u)*VAD_FLOOR_RATIO;
+    if (threshold < VAD_MIN_LEVEL)
+    {
+        threshold = VAD_MIN_LEVEL;
+    }
+    voiced = (vad->level >= threshold) || 
+             ((vad->level >= (threshold/2u)) && (vad->crossings >= VAD_ZCR_MIN));
+    
+    /* The floor drops at once to a quieter block, and rises slowly */
+    if ((vad->level*16u) < vad->noiseFloor)
+    {
+        vad->noiseFloor = vad->level*16u;
+    }
+    else
+    {
+        vad->noiseFloor += ((vad->level*16u) - vad->noiseFloor) >> (voiced ? VAD_FLOOR_RISE_VOICED : VAD_FLOOR_RISE);
+    }
+    
+    if (voiced)
+    {
+        vad->hangover = (VAD_HANGOVER_MS*block->sampleRate) / (1000u*block->frames);
+        vad->silent = false;
+    }
+    else if (vad->hangover > 0u)
+    {
+        vad->hangover--;
+        vad->silent = false;
+    }
+    else
+    {
+        vad->silent = true;
+        vad->silentBlocks++;
+    }
+}
+
+/* [] END OF FILE */
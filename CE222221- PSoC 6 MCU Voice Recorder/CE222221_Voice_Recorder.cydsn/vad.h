@@ -0,0 +1,86 @@
+/******************************************************************************
+* File Name: vad.h
+*
+* Version: 1.0
+*
+* Description: This file declares the functions provided by the vad.c file
+*
+* Related Document: N/A
+*
+* Hardware Dependency: CY8CKIT-062-WiFi-BT PSoC 6 WiFi-BT Pioneer Kit
+*
+******************************************************************************
+* Copyright (2018), Cypress Semiconductor Corporation.
+******************************************************************************
+* This software, including source code, documentation and related materials
+* ("Software") is owned by Cypress Semiconductor Corporation (Cypress) and is
+* protected by and subject to worldwide patent protection (United States and 
+* foreign), United States copyright laws and international treaty provisions. 
+* Cypress hereby grants to licensee a personal, non-exclusive, non-transferable
+* license to copy, use, modify, create derivative works of, and compile the 
+* Cypress source code and derivative works for the sole purpose of creating 
+* custom software in support of licensee product, such licensee product to be
+* used only in conjunction with Cypress's integrated circuit as specified in the
+* applicable agreement. Any reproduction, modification, translation, compilation,
+* or representation of this Software except as specified above is prohibited 
+* without the express written permission of Cypress.
+* 
+* Disclaimer: THIS SOFTWARE IS PROVIDED AS-IS, WITH NO WARRANTY OF ANY KIND, 
+* EXPRESS OR IMPLIED, INCLUDING, BUT NOT LIMITED TO, NONINFRINGEMENT, IMPLIED 
+* WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE.
+* Cypress reserves the right to make changes to the Software without notice. 
+* Cypress does not assume any liability arising out of the application or use
+* of Software or any product or circuit described in the Software. Cypress does
+* not authorize its products for use as critical components in any products 
+* where a malfunction or failure may reasonably be expected to result in 
+* significant injury or death ("ACTIVE Risk Product"). By including Cypress's 
+* product in a ACTIVE Risk Product, the manufacturer of such system or application
+* assumes all risk of such use and in doing so indemnifies Cypress against all
+* liability. Use of this Software may be limited by and subject to the applicable
+* Cypress software license agreement.
+*****************************************************************************/
+
+/* Include Guard */
+#ifndef VAD_H
+#define VAD_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "dsp.h"
+
+/*******************************************************************************
+*            Structures and Enums
+*******************************************************************************/
+/* State of a voice activity detector, one per path. A block is voiced when its
+   level stands above the noise floor, or a little above it with the many zero
+   crossings of a fricative. The floor follows the quiet blocks */
+typedef struct vad
+{
+    uint32_t level;                   /* Mean absolute sample of the last block */
+    uint32_t crossings;               /* Zero crossings per 1024 samples, last block */
+    uint32_t noiseFloor;              /* Level of the background, in 1/16 */
+    uint32_t hangover;                /* Blocks still marked voiced after speech */
+    bool silent;                      /* Last block is silence */
+    uint32_t silentBlocks;            /* Silent blocks since the reset */
+} vad_t;
+
+/*******************************************************************************
+*            Function Prototypes
+*******************************************************************************/
+void VadInit(vad_t *vad);
+void VadProcess(dsp_stage_t *stage, dsp_block_t *block);
+
+/*******************************************************************************
+*            Constants
+*******************************************************************************/
+#define VAD_MIN_LEVEL       (64u)           /* Lowest speech level, 16-bit mean absolute */
+#define VAD_FLOOR_RATIO     (3u)            /* Speech level over the noise floor */
+#define VAD_ZCR_MIN         (300u)          /* Crossings per 1024 samples of a fricative */
+#define VAD_FLOOR_RISE      (6u)            /* Floor rises by 1/64 of the gap per quiet block */
+#define VAD_FLOOR_RISE_VOICED (10u)         /* And by 1/1024 per voiced block */
+#define VAD_FLOOR_INIT      (VAD_MIN_LEVEL) /* Floor level before any block */
+#define VAD_HANGOVER_MS     (300u)          /* Speech kept after the level drops */
+#define VAD_BUDGET_CYCLES   (8000u)         /* Cycles declared for a page */
+
+#endif
+/* [] END OF FILE */